@@ -0,0 +1,57 @@
+#!/usr/bin/env python
+# Export the weights of a GCNv2 or GCNv2_tiny model (TorchScript .pt or state_dict) to the flat
+# file read by the native GCNNetwork (see Network.md).
+#
+#   python export_gcn.py gcn2_320x240.pt gcn2_320x240.gcn
+
+import struct
+import sys
+
+import torch
+
+LAYERS = ['conv1', 'conv2', 'conv3_1', 'conv3_2', 'conv4_1', 'conv4_2',
+          'convF_1', 'convF_2', 'convD_1', 'convD_2']
+
+# Stride and padding of each kernel size in GCNv2
+CONV_PARAMS = {4: (2, 1), 3: (1, 1), 1: (1, 0)}
+
+
+def load_state_dict(path):
+    try:
+        return torch.jit.load(path, map_location='cpu').state_dict()
+    except RuntimeError:
+        state = torch.load(path, map_location='cpu')
+        return state.state_dict() if hasattr(state, 'state_dict') else state
+
+
+def main():
+    if len(sys.argv) != 3:
+        print('Usage: python export_gcn.py model.pt weights.gcn')
+        return 1
+
+    state = load_state_dict(sys.argv[1])
+
+    with open(sys.argv[2], 'wb') as f:
+        f.write(b'GCNW')
+        f.write(struct.pack('<ii', 1, len(LAYERS)))
+
+        for name in LAYERS:
+            weight = state[name + '.weight'].detach().float().contiguous()
+            bias = state[name + '.bias'].detach().float().contiguous()
+            n_out, n_in, kh, kw = weight.shape
+            assert kh == kw and kh in CONV_PARAMS, name
+            stride, pad = CONV_PARAMS[kh]
+
+            f.write(struct.pack('<i', len(name)))
+            f.write(name.encode('ascii'))
+            f.write(struct.pack('<5i', n_out, n_in, kh, stride, pad))
+            f.write(weight.numpy().astype('<f4').tobytes())
+            f.write(bias.numpy().astype('<f4').tobytes())
+
+            print('%-8s %3d -> %3d, %dx%d, stride %d, pad %d' % (name, n_in, n_out, kh, kw, stride, pad))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,202 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Equivalence check of the native GCNNetwork against the TorchScript model it was exported from.
+// Both networks run on the same images. Keypoints are matched by position, and the tool reports
+// missing and extra keypoints, the confidence difference and the Hamming distance between
+// the descriptors of matched keypoints, along with the time of each network.
+// The exit status is 0 if the outputs are equivalent.
+
+#include <torch/script.h> // One-stop header.
+#include <torch/torch.h>
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "GCNNetwork.h"
+#include "HammingDistance.h"
+
+using namespace std;
+
+// Keypoints present in both outputs, and descriptor agreement of the matched ones
+struct Comparison
+{
+    int nReference;
+    int nNative;
+    int nMatched;
+    double sumConfDiff;
+    double maxConfDiff;
+    long sumDistance;
+    long sumDistanceReversed;
+    int maxDistance;
+};
+
+static unsigned char ReverseBits(unsigned char b)
+{
+    b = (unsigned char)(((b & 0xF0) >> 4) | ((b & 0x0F) << 4));
+    b = (unsigned char)(((b & 0xCC) >> 2) | ((b & 0x33) << 2));
+    return (unsigned char)(((b & 0xAA) >> 1) | ((b & 0x55) << 1));
+}
+
+void Compare(const cv::Mat &refPts, const cv::Mat &refDesc, const cv::Mat &pts, const cv::Mat &desc,
+             int width, int height, Comparison &c)
+{
+    vector<int> vIndex(width*height,-1);
+    for(int i=0; i<refPts.rows; i++)
+    {
+        const int u = (int)refPts.at<float>(i,0);
+        const int v = (int)refPts.at<float>(i,1);
+        if(u>=0 && u<width && v>=0 && v<height)
+            vIndex[v*width+u] = i;
+    }
+
+    c.nReference += refPts.rows;
+    c.nNative += pts.rows;
+
+    unsigned char reversed[32];
+    for(int i=0; i<pts.rows; i++)
+    {
+        const int u = (int)pts.at<float>(i,0);
+        const int v = (int)pts.at<float>(i,1);
+        const int j = vIndex[v*width+u];
+        if(j<0)
+            continue;
+
+        c.nMatched++;
+
+        const double confDiff = fabs(pts.at<float>(i,2)-refPts.at<float>(j,2));
+        c.sumConfDiff += confDiff;
+        c.maxConfDiff = max(c.maxConfDiff,confDiff);
+
+        const int dist = ORB_SLAM2::HammingDistance::Distance(desc.ptr(i),refDesc.ptr(j));
+        c.sumDistance += dist;
+        c.maxDistance = max(c.maxDistance,dist);
+
+        for(int k=0; k<32; k++)
+            reversed[k] = ReverseBits(desc.ptr(i)[k]);
+        c.sumDistanceReversed += ORB_SLAM2::HammingDistance::Distance(reversed,refDesc.ptr(j));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 4 || argc > 5)
+    {
+        cerr << endl << "Usage: ./gcn_check model.pt weights.gcn path_to_images [detection_threshold]" << endl;
+        return 1;
+    }
+
+    int width = 320;
+    int height = 240;
+    if (getenv("FULL_RESOLUTION") != nullptr)
+    {
+        width = 640;
+        height = 480;
+    }
+
+    const float detThreshold = argc==5 ? atof(argv[4]) : ORB_SLAM2::GCNNetwork::DETECTION_THRESHOLD;
+
+    std::shared_ptr<torch::jit::script::Module> module = torch::jit::load(argv[1], torch::Device(torch::kCPU));
+
+    ORB_SLAM2::GCNNetwork network(width,height,0,detThreshold);
+    if(!network.Load(argv[2]))
+        return 1;
+
+    vector<cv::String> vFilenames;
+    cv::glob(string(argv[3])+"/*.png", vFilenames, false);
+    if(vFilenames.empty())
+    {
+        cerr << "No png images found in " << argv[3] << endl;
+        return 1;
+    }
+
+    Comparison c = {0,0,0,0,0,0,0,0};
+    double timeReference = 0, timeNative = 0;
+
+    torch::NoGradGuard no_grad;
+    torch::Tensor inputTensor = torch::zeros({1, 1, height, width}, torch::kFloat32);
+    cv::Mat input(height, width, CV_32FC1, inputTensor.data<float>());
+
+    for(size_t i=0; i<vFilenames.size(); i++)
+    {
+        cv::Mat im = cv::imread(vFilenames[i],CV_LOAD_IMAGE_GRAYSCALE);
+        if(im.empty())
+            continue;
+
+        cv::Mat imFloat;
+        im.convertTo(imFloat, CV_32FC1, 1.f / 255.f , 0);
+        cv::resize(imFloat, input, cv::Size(width, height));
+
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+        std::vector<torch::jit::IValue> inputs;
+        inputs.push_back(inputTensor);
+        auto output = module->forward(inputs).toTuple();
+        auto pts  = output->elements()[0].toTensor().to(torch::kCPU).squeeze().contiguous();
+        auto desc = output->elements()[1].toTensor().to(torch::kCPU).squeeze().contiguous();
+        const int K = pts.numel()/3;
+        cv::Mat refPts = cv::Mat(K, 3, CV_32FC1, pts.data<float>()).clone();
+        cv::Mat refDesc = cv::Mat(K, 32, CV_8UC1, desc.data<unsigned char>()).clone();
+
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+        cv::Mat nativePts, nativeDesc;
+        network(input, nativePts, nativeDesc);
+
+        std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+
+        timeReference += std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+        timeNative += std::chrono::duration_cast<std::chrono::duration<double> >(t3 - t2).count();
+
+        Compare(refPts, refDesc, nativePts, nativeDesc, width, height, c);
+    }
+
+    const int nImages = vFilenames.size();
+    const double recall = c.nReference>0 ? (double)c.nMatched/c.nReference : 1.0;
+    const double precision = c.nNative>0 ? (double)c.nMatched/c.nNative : 1.0;
+    const double meanDistance = c.nMatched>0 ? (double)c.sumDistance/c.nMatched : 0.0;
+    const double meanDistanceReversed = c.nMatched>0 ? (double)c.sumDistanceReversed/c.nMatched : 0.0;
+
+    cout << "images: " << nImages << ", detection threshold: " << detThreshold << endl;
+    cout << "keypoints: " << c.nReference << " reference, " << c.nNative << " native, " << c.nMatched << " matched" << endl;
+    cout << "recall: " << recall << ", precision: " << precision << endl;
+    cout << "confidence difference: mean " << (c.nMatched>0 ? c.sumConfDiff/c.nMatched : 0.0)
+         << ", max " << c.maxConfDiff << endl;
+    cout << "descriptor distance: mean " << meanDistance << ", max " << c.maxDistance << " bits" << endl;
+    cout << "mean time: reference " << timeReference/nImages << " s, native " << timeNative/nImages
+         << " s (" << ORB_SLAM2::GCNNetwork::GetKernelName(ORB_SLAM2::GCNNetwork::GetKernel()) << " kernel)" << endl;
+
+    if(meanDistanceReversed<meanDistance/4)
+        cout << "descriptor bits match in reverse order within each byte, "
+             << "the model packs channel 8*i+j in bit 7-j" << endl;
+
+    // Borderline confidences and descriptor channels may flip because of float rounding
+    const bool bEquivalent = recall>=0.99 && precision>=0.99 && meanDistance<=1.0;
+    cout << (bEquivalent ? "PASS" : "FAIL") << endl;
+
+    return bEquivalent ? 0 : 1;
+}
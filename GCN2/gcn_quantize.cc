@@ -0,0 +1,223 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Calibration and accuracy report of the reduced precision modes of the native GCNNetwork.
+// The FP32 network records the input range of every layer on the calibration images and writes
+// them to calibration.yml (GCNextractor.calibration). FP16 and INT8 then run on the test images
+// next to FP32, and the keypoints kept by the non-maximum suppression are compared: each FP32
+// keypoint is paired with the nearest reduced precision keypoint within the suppression radius.
+// The tool reports the time of each precision, the position drift of the paired keypoints and
+// the Hamming distance between their descriptors.
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "GCNNetwork.h"
+#include "NonMaxSuppression.h"
+#include "HammingDistance.h"
+
+using namespace std;
+using ORB_SLAM2::GCNNetwork;
+
+// Keypoints of a reduced precision against FP32
+struct Drift
+{
+    int nReference;
+    int nReduced;
+    int nPaired;
+    int nSamePixel;
+    int nWithinPixel;
+    double sumDrift;
+    long sumDistance;
+    int maxDistance;
+    double time;
+};
+
+int LoadImages(const string &strPath, int width, int height, vector<cv::Mat> &vImages)
+{
+    vector<cv::String> vFilenames;
+    cv::glob(strPath+"/*.png", vFilenames, false);
+
+    for(size_t i=0; i<vFilenames.size(); i++)
+    {
+        cv::Mat im = cv::imread(vFilenames[i],CV_LOAD_IMAGE_GRAYSCALE);
+        if(im.empty())
+            continue;
+
+        cv::Mat imFloat, input;
+        im.convertTo(imFloat, CV_32FC1, 1.f / 255.f , 0);
+        cv::resize(imFloat, input, cv::Size(width, height));
+        vImages.push_back(input);
+    }
+
+    return vImages.size();
+}
+
+// Network and suppression as in GCNextractor, returns the time of the network in seconds
+double Extract(GCNNetwork &network, ORB_SLAM2::NonMaxSuppression &nms, const cv::Mat &input,
+               vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors)
+{
+    cv::Mat pts, desc;
+
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    network(input, pts, desc);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    nms(pts, desc, keypoints, descriptors);
+
+    return std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+}
+
+void Compare(const vector<cv::KeyPoint> &vRef, const cv::Mat &refDesc, const vector<cv::KeyPoint> &vKeys,
+             const cv::Mat &desc, const int width, const int height, const int radius, Drift &d)
+{
+    vector<int> vIndex(width*height,-1);
+    for(size_t i=0; i<vKeys.size(); i++)
+        vIndex[(int)vKeys[i].pt.y*width+(int)vKeys[i].pt.x] = i;
+
+    d.nReference += vRef.size();
+    d.nReduced += vKeys.size();
+
+    for(size_t i=0; i<vRef.size(); i++)
+    {
+        const int u = vRef[i].pt.x;
+        const int v = vRef[i].pt.y;
+
+        int bestIdx = -1;
+        int bestDist2 = radius*radius+1;
+        for(int y=max(v-radius,0); y<=min(v+radius,height-1); y++)
+        {
+            for(int x=max(u-radius,0); x<=min(u+radius,width-1); x++)
+            {
+                const int j = vIndex[y*width+x];
+                const int dist2 = (x-u)*(x-u)+(y-v)*(y-v);
+                if(j>=0 && dist2<bestDist2)
+                {
+                    bestDist2 = dist2;
+                    bestIdx = j;
+                }
+            }
+        }
+
+        if(bestIdx<0)
+            continue;
+
+        d.nPaired++;
+        d.sumDrift += sqrt((double)bestDist2);
+        if(bestDist2==0)
+            d.nSamePixel++;
+        if(bestDist2<=1)
+            d.nWithinPixel++;
+
+        const int dist = ORB_SLAM2::HammingDistance::Distance(refDesc.ptr(i),desc.ptr(bestIdx));
+        d.sumDistance += dist;
+        d.maxDistance = max(d.maxDistance,dist);
+    }
+}
+
+void Report(const string &strName, const Drift &d, const double timeReference, const int nImages)
+{
+    const double nRef = max(d.nReference,1);
+    const double nPaired = max(d.nPaired,1);
+
+    cout << strName << ": " << d.time/nImages*1e3 << " ms (x" << timeReference/d.time << ")" << endl;
+    cout << "  keypoints: " << d.nReduced << " (fp32 " << d.nReference << "), paired " << d.nPaired/nRef*100 << "%" << endl;
+    cout << "  position: same pixel " << d.nSamePixel/nRef*100 << "%, within 1 px " << d.nWithinPixel/nRef*100
+         << "%, mean drift of paired " << d.sumDrift/nPaired << " px" << endl;
+    cout << "  descriptor distance of paired: mean " << d.sumDistance/nPaired << ", max " << d.maxDistance << " bits" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc != 5)
+    {
+        cerr << endl << "Usage: ./gcn_quantize weights.gcn path_to_calibration_images path_to_test_images calibration.yml" << endl;
+        return 1;
+    }
+
+    int width = 320;
+    int height = 240;
+    int border = 8;
+    int distThresh = 4;
+    if (getenv("FULL_RESOLUTION") != nullptr)
+    {
+        width = 640;
+        height = 480;
+        border = 16;
+        distThresh = 8;
+    }
+
+    vector<cv::Mat> vCalibration, vTest;
+    if(LoadImages(argv[2],width,height,vCalibration)==0 || LoadImages(argv[3],width,height,vTest)==0)
+    {
+        cerr << "No png images found in " << argv[2] << " or " << argv[3] << endl;
+        return 1;
+    }
+
+    // Calibration on FP32
+    GCNNetwork networkFP32(width,height);
+    if(!networkFP32.Load(argv[1]))
+        return 1;
+
+    networkFP32.Calibrate(vCalibration);
+    if(!networkFP32.SaveCalibration(argv[4]))
+        return 1;
+    cout << "calibrated on " << vCalibration.size() << " images, input ranges written to " << argv[4] << endl;
+
+    GCNNetwork networkFP16(width,height);
+    GCNNetwork networkINT8(width,height);
+    if(!networkFP16.Load(argv[1]) || !networkFP16.SetPrecision(GCNNetwork::FP16) ||
+       !networkINT8.Load(argv[1]) || !networkINT8.LoadCalibration(argv[4]) || !networkINT8.SetPrecision(GCNNetwork::INT8))
+        return 1;
+
+    GCNNetwork* pNetworks[2] = {&networkFP16, &networkINT8};
+    Drift drift[2] = {};
+    double timeReference = 0;
+
+    ORB_SLAM2::NonMaxSuppression nms(width,height,distThresh,border);
+
+    vector<cv::KeyPoint> vRef, vKeys;
+    cv::Mat refDesc, desc;
+    for(size_t i=0; i<vTest.size(); i++)
+    {
+        timeReference += Extract(networkFP32,nms,vTest[i],vRef,refDesc);
+
+        for(int k=0; k<2; k++)
+        {
+            drift[k].time += Extract(*pNetworks[k],nms,vTest[i],vKeys,desc);
+            Compare(vRef,refDesc,vKeys,desc,width,height,distThresh,drift[k]);
+        }
+    }
+
+    const int nImages = vTest.size();
+    cout << "test images: " << nImages << ", " << GCNNetwork::GetKernelName(GCNNetwork::GetKernel()) << " kernel" << endl;
+    cout << "fp32: " << timeReference/nImages*1e3 << " ms" << endl;
+    Report("fp16",drift[0],timeReference,nImages);
+    Report("int8",drift[1],timeReference,nImages);
+
+    return 0;
+}
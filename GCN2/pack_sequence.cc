@@ -0,0 +1,167 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Packs a TUM RGB-D sequence into a single PackedSequence file for rgbd_gcn. Each frame is
+// converted once to the gray image and depth resolution used by the tracking (320x240 unless
+// FULL_RESOLUTION is set, as in Tracking::CreateFrameRGBD), so replays only map the file and
+// skip the PNG decoding, color conversion and resize.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "PackedSequence.h"
+#include "ImagePreprocessing.h"
+
+using namespace std;
+
+void LoadImages(const string &strAssociationFilename, vector<string> &vstrImageFilenamesRGB,
+                vector<string> &vstrImageFilenamesD, vector<double> &vTimestamps);
+
+int main(int argc, char **argv)
+{
+    if(argc != 5)
+    {
+        cerr << endl << "Usage: ./pack_sequence path_to_settings path_to_sequence path_to_association output_file" << endl;
+        return 1;
+    }
+
+    cv::FileStorage fSettings(argv[1], cv::FileStorage::READ);
+    if(!fSettings.isOpened())
+    {
+        cerr << "Failed to open settings file at: " << argv[1] << endl;
+        return 1;
+    }
+
+    // Color order of the images (0: BGR, 1: RGB. It is ignored if images are grayscale)
+    int nRGB = fSettings["Camera.RGB"];
+    const bool bRGB = nRGB;
+
+    // Retrieve paths to images
+    vector<string> vstrImageFilenamesRGB;
+    vector<string> vstrImageFilenamesD;
+    vector<double> vTimestamps;
+    string strSequence = string(argv[2]);
+    LoadImages(string(argv[3]), vstrImageFilenamesRGB, vstrImageFilenamesD, vTimestamps);
+
+    const int nImages = vstrImageFilenamesRGB.size();
+    if(vstrImageFilenamesRGB.empty())
+    {
+        cerr << endl << "No images found in provided path." << endl;
+        return 1;
+    }
+    else if(vstrImageFilenamesD.size()!=vstrImageFilenamesRGB.size())
+    {
+        cerr << endl << "Different number of images for rgb and depth." << endl;
+        return 1;
+    }
+
+    ORB_SLAM2::PackedSequence packed;
+    cv::Size size;
+
+    cout << endl << "Packing " << nImages << " frames..." << endl;
+
+    for(int ni=0; ni<nImages; ni++)
+    {
+        cv::Mat imRGB = cv::imread(strSequence+"/"+vstrImageFilenamesRGB[ni],CV_LOAD_IMAGE_UNCHANGED);
+        cv::Mat imD = cv::imread(strSequence+"/"+vstrImageFilenamesD[ni],CV_LOAD_IMAGE_UNCHANGED);
+
+        if(imRGB.empty() || imD.empty())
+        {
+            cerr << endl << "Failed to load image at: " << strSequence << "/" << vstrImageFilenamesRGB[ni] << endl;
+            return 1;
+        }
+
+        if(imD.type()!=CV_16UC1)
+        {
+            cerr << endl << "Depth maps must be 16-bit: " << strSequence << "/" << vstrImageFilenamesD[ni] << endl;
+            return 1;
+        }
+
+        if(ni==0)
+        {
+            size = imRGB.size();
+            if (getenv("NN_ONLY") != nullptr || getenv("FULL_RESOLUTION") == nullptr)
+                size = cv::Size(320, 240);
+
+            if(!packed.Create(argv[4],size.width,size.height))
+                return 1;
+        }
+
+        cv::Mat imGray(size,CV_8UC1);
+        if(!ORB_SLAM2::ImagePreprocessing::ToGray(imRGB,bRGB,imGray,static_cast<float*>(NULL)))
+        {
+            imGray = imRGB;
+            if(imGray.channels()==3)
+                cvtColor(imGray,imGray,bRGB ? CV_RGB2GRAY : CV_BGR2GRAY);
+            else if(imGray.channels()==4)
+                cvtColor(imGray,imGray,bRGB ? CV_RGBA2GRAY : CV_BGRA2GRAY);
+
+            if(imGray.size()!=size)
+                cv::resize(imGray, imGray, size);
+        }
+
+        // Raw sensor units, DepthMapFactor is applied by the tracking
+        cv::Mat imDepth = imD;
+        if(imDepth.size()!=size)
+            cv::resize(imDepth, imDepth, size, 0, 0, cv::INTER_NEAREST);
+
+        if(!packed.Add(vTimestamps[ni],imGray,imDepth))
+            return 1;
+    }
+
+    packed.Close();
+
+    cout << "Packed " << nImages << " frames of " << size.width << "x" << size.height << " in " << argv[4] << endl;
+
+    return 0;
+}
+
+void LoadImages(const string &strAssociationFilename, vector<string> &vstrImageFilenamesRGB,
+                vector<string> &vstrImageFilenamesD, vector<double> &vTimestamps)
+{
+    ifstream fAssociation;
+    fAssociation.open(strAssociationFilename.c_str());
+    while(!fAssociation.eof())
+    {
+        string s;
+        getline(fAssociation,s);
+        if(!s.empty())
+        {
+            stringstream ss;
+            ss << s;
+            double t;
+            string sRGB, sD;
+            ss >> t;
+            vTimestamps.push_back(t);
+            ss >> sRGB;
+            vstrImageFilenamesRGB.push_back(sRGB);
+            ss >> t;
+            ss >> sD;
+            vstrImageFilenamesD.push_back(sD);
+
+        }
+    }
+}
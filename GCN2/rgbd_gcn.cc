@@ -18,16 +18,21 @@
 * along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <torch/script.h> // One-stop header.
-#include <torch/torch.h>
-
 #include <iostream>
 #include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
 
 #include <opencv2/core/core.hpp>
 #include <System.h>
+#include <PackedSequence.h>
 
 using namespace std;
 
@@ -35,58 +40,213 @@ using namespace std;
 void LoadImages(const string &strAssociationFilename, vector<string> &vstrImageFilenamesRGB,
                 vector<string> &vstrImageFilenamesD, vector<double> &vTimestamps);
 
+// Decodes the images of the sequence ahead of the tracking with a pool of threads. Frame i is
+// decoded into slot i%depth, so at most depth frames are decoded and not yet tracked.
+class ImagePrefetcher
+{
+public:
+
+    ImagePrefetcher(const string &strSequence, const vector<string> &vstrRGB, const vector<string> &vstrD,
+                    const int depth, const int nThreads);
+    ~ImagePrefetcher();
+
+    // Blocks until frame ni is decoded. Returns false if an image could not be read.
+    // decodeTime is the time the decoder spent on the frame, in seconds.
+    bool Get(const int ni, cv::Mat &imRGB, cv::Mat &imD, double &decodeTime);
+
+protected:
+
+    void Run();
+
+    struct Slot
+    {
+        int index;
+        cv::Mat imRGB;
+        cv::Mat imD;
+        double decodeTime;
+    };
+
+    const string mstrSequence;
+    const vector<string> &mvstrRGB;
+    const vector<string> &mvstrD;
+    const int mnImages;
+
+    vector<Slot> mvSlots;
+    int mnNext;
+    int mnConsumed;
+    bool mbFinish;
+
+    mutex mMutex;
+    condition_variable mCondDecoded;
+    condition_variable mCondConsumed;
+    vector<thread*> mvpThreads;
+};
+
+double Percentile(const vector<float> &vSorted, const double p)
+{
+    if(vSorted.empty())
+        return 0;
+    return vSorted[min((size_t)(p*vSorted.size()),vSorted.size()-1)];
+}
+
+void PrintLatency(const string &name, vector<float> vTimes)
+{
+    if(vTimes.empty())
+        return;
+
+    sort(vTimes.begin(),vTimes.end());
+    float totaltime = 0;
+    for(size_t i=0; i<vTimes.size(); i++)
+        totaltime+=vTimes[i];
+
+    cout << name << " (ms): mean " << 1e3*totaltime/vTimes.size() << ", p50 " << 1e3*Percentile(vTimes,0.50)
+         << ", p95 " << 1e3*Percentile(vTimes,0.95) << ", p99 " << 1e3*Percentile(vTimes,0.99)
+         << ", max " << 1e3*vTimes.back() << endl;
+}
+
 int main(int argc, char **argv)
 {
-    if(argc != 5)
+    // Options go before the positional arguments
+    bool bFast = false;
+    bool bStats = false;
+    int nPrefetch = 0;
+    int nDecoders = 2;
+
+    int arg = 1;
+    for(; arg<argc && strncmp(argv[arg],"--",2)==0; arg++)
     {
-        cerr << endl << "Usage: ./rgbd_gcn path_to_vocabulary path_to_settings path_to_sequence path_to_association" << endl;
+        if(strcmp(argv[arg],"--fast")==0)
+            bFast = true;
+        else if(strcmp(argv[arg],"--stats")==0)
+            bStats = true;
+        else if(strcmp(argv[arg],"--prefetch")==0 && arg+1<argc)
+            nPrefetch = atoi(argv[++arg]);
+        else if(strcmp(argv[arg],"--decoders")==0 && arg+1<argc)
+            nDecoders = max(atoi(argv[++arg]),1);
+        else
+            break;
+    }
+
+    // A packed sequence (see pack_sequence) replaces the sequence folder and the association file
+    const int nArgs = argc-arg;
+    const bool bPacked = nArgs>=3 && ORB_SLAM2::PackedSequence::IsPackedSequence(argv[arg+2]);
+    const int nSequenceArgs = bPacked ? 1 : 2;
+    if(nArgs != 2+nSequenceArgs && nArgs != 3+nSequenceArgs)
+    {
+        cerr << endl << "Usage: ./rgbd_gcn [--fast] [--prefetch N] [--decoders N] [--stats] "
+             << "path_to_vocabulary path_to_settings path_to_sequence path_to_association [feature_cache]" << endl
+             << "       ./rgbd_gcn [--fast] [--stats] path_to_vocabulary path_to_settings packed_sequence [feature_cache]" << endl
+             << "  --fast          process frames as fast as possible instead of at the camera rate" << endl
+             << "  --prefetch N    decode up to N frames ahead in background threads (0: decode in the loop)" << endl
+             << "  --decoders N    number of decoding threads for --prefetch (default 2)" << endl
+             << "  --stats         print the sustainable FPS and p50/p95/p99 latencies of each stage" << endl;
         return 1;
     }
 
-    // Retrieve paths to images
+    const string strVocabulary = argv[arg];
+    const string strSettings = argv[arg+1];
+    const string strSequence = argv[arg+2];
+
+    // Retrieve paths to images, or map the packed sequence
     vector<string> vstrImageFilenamesRGB;
     vector<string> vstrImageFilenamesD;
     vector<double> vTimestamps;
-    string strAssociationFilename = string(argv[4]);
-    LoadImages(strAssociationFilename, vstrImageFilenamesRGB, vstrImageFilenamesD, vTimestamps);
+    ORB_SLAM2::PackedSequence packed;
+    if(bPacked)
+    {
+        if(!packed.Open(strSequence))
+            return 1;
+        for(int ni=0; ni<packed.GetFrames(); ni++)
+            vTimestamps.push_back(packed.GetTimestamp(ni));
+        nPrefetch = 0;
+    }
+    else
+    {
+        string strAssociationFilename = string(argv[arg+3]);
+        LoadImages(strAssociationFilename, vstrImageFilenamesRGB, vstrImageFilenamesD, vTimestamps);
+    }
 
     // Check consistency in the number of images and depthmaps
-    int nImages = vstrImageFilenamesRGB.size();
-    if(vstrImageFilenamesRGB.empty())
+    int nImages = vTimestamps.size();
+    if(vTimestamps.empty())
     {
         cerr << endl << "No images found in provided path." << endl;
         return 1;
     }
-    else if(vstrImageFilenamesD.size()!=vstrImageFilenamesRGB.size())
+    else if(!bPacked && (vstrImageFilenamesRGB.size()!=vTimestamps.size() || vstrImageFilenamesD.size()!=vstrImageFilenamesRGB.size()))
     {
         cerr << endl << "Different number of images for rgb and depth." << endl;
         return 1;
     }
 
     // Create SLAM system. It initializes all system threads and gets ready to process frames.
-    ORB_SLAM2::System SLAM(argv[1],argv[2],ORB_SLAM2::System::RGBD,true);
+    ORB_SLAM2::System SLAM(strVocabulary,strSettings,ORB_SLAM2::System::RGBD,true);
+
+    // The first run with a feature cache writes it, the following runs read the features from it
+    if(nArgs == 3+nSequenceArgs && !SLAM.SetFeatureCache(argv[arg+2+nSequenceArgs]))
+    {
+        SLAM.Shutdown();
+        return 1;
+    }
+
+    ImagePrefetcher* pPrefetcher = static_cast<ImagePrefetcher*>(NULL);
+    if(nPrefetch>0)
+        pPrefetcher = new ImagePrefetcher(strSequence,vstrImageFilenamesRGB,vstrImageFilenamesD,nPrefetch,nDecoders);
 
     // Vector for tracking time statistics
     vector<float> vTimesTrack;
     vTimesTrack.resize(nImages);
 
+    // Per stage times: decode (in the decoding threads with --prefetch), wait for the decoded
+    // frame, tracking, and the whole loop iteration
+    vector<float> vTimesDecode, vTimesWait, vTimesFrame;
+    vTimesDecode.reserve(nImages);
+    vTimesWait.reserve(nImages);
+    vTimesFrame.reserve(nImages);
+
     cout << endl << "-------" << endl;
     cout << "Start processing sequence ..." << endl;
-    cout << "Images in the sequence: " << nImages << endl << endl;
+    cout << "Images in the sequence: " << nImages << endl;
+    if(bPacked)
+        cout << "Reading the packed sequence " << strSequence << " (" << packed.GetWidth() << "x" << packed.GetHeight() << ")" << endl;
+    if(bFast)
+        cout << "Processing as fast as possible" << endl;
+    if(pPrefetcher)
+        cout << "Prefetching " << nPrefetch << " frames with " << nDecoders << " threads" << endl;
+    cout << endl;
+
+    std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
 
     // Main loop
     cv::Mat imRGB, imD, imF;
     for(int ni=0; ni<nImages; ni++)
     {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
         // Read image and depthmap from file
-        imRGB = cv::imread(string(argv[3])+"/"+vstrImageFilenamesRGB[ni],CV_LOAD_IMAGE_UNCHANGED);
-        imD = cv::imread(string(argv[3])+"/"+vstrImageFilenamesD[ni],CV_LOAD_IMAGE_UNCHANGED);
+        double tdecode = 0;
+        bool bLoaded;
+        if(bPacked)
+        {
+            // Views into the mapped file, nothing is decoded or copied
+            packed.GetFrame(ni,imRGB,imD);
+            bLoaded = true;
+        }
+        else if(pPrefetcher)
+            bLoaded = pPrefetcher->Get(ni,imRGB,imD,tdecode);
+        else
+        {
+            imRGB = cv::imread(strSequence+"/"+vstrImageFilenamesRGB[ni],CV_LOAD_IMAGE_UNCHANGED);
+            imD = cv::imread(strSequence+"/"+vstrImageFilenamesD[ni],CV_LOAD_IMAGE_UNCHANGED);
+            bLoaded = !imRGB.empty();
+        }
         double tframe = vTimestamps[ni];
 
-        if(imRGB.empty())
+        if(!bLoaded)
         {
             cerr << endl << "Failed to load image at: "
-                 << string(argv[3]) << "/" << vstrImageFilenamesRGB[ni] << endl;
+                 << strSequence << "/" << vstrImageFilenamesRGB[ni] << endl;
+            delete pPrefetcher;
             return 1;
         }
 
@@ -107,8 +267,11 @@ int main(int argc, char **argv)
 #endif
 
         double ttrack = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+        double tload = std::chrono::duration_cast<std::chrono::duration<double> >(t1 - t0).count();
 
         vTimesTrack[ni]=ttrack;
+        vTimesDecode.push_back(pPrefetcher ? tdecode : tload);
+        vTimesWait.push_back(tload);
 
         // Wait to load the next frame
         double T=0;
@@ -117,10 +280,17 @@ int main(int argc, char **argv)
         else if(ni>0)
             T = tframe-vTimestamps[ni-1];
 
-        if(ttrack<T)
+        if(!bFast && ttrack<T)
             usleep((T-ttrack)*1e6);
+
+        vTimesFrame.push_back(std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - t0).count());
     }
 
+    std::chrono::steady_clock::time_point tEnd = std::chrono::steady_clock::now();
+    const double tTotal = std::chrono::duration_cast<std::chrono::duration<double> >(tEnd - tStart).count();
+
+    delete pPrefetcher;
+
     std::cout << "Finished!" << std::endl;
 
     // Tracking time statistics
@@ -134,6 +304,19 @@ int main(int argc, char **argv)
     cout << "median tracking time: " << vTimesTrack[nImages/2] << endl;
     cout << "mean tracking time: " << totaltime/nImages << endl;
 
+    if(bStats)
+    {
+        cout << endl << "processed " << nImages << " frames in " << tTotal << " s: " << nImages/tTotal << " fps";
+        if(!bFast)
+            cout << " (paced at the camera rate, use --fast for the sustainable rate)";
+        cout << endl;
+        PrintLatency(bPacked ? "read (mapped)" : pPrefetcher ? "decode (background)" : "decode",vTimesDecode);
+        if(pPrefetcher)
+            PrintLatency("wait for decoded frame",vTimesWait);
+        PrintLatency("tracking",vTimesTrack);
+        PrintLatency("frame",vTimesFrame);
+    }
+
     // Save camera trajectory
     SLAM.SaveTrajectoryTUM("CameraTrajectory.txt");
     SLAM.SaveKeyFrameTrajectoryTUM("KeyFrameTrajectory.txt");
@@ -145,6 +328,86 @@ int main(int argc, char **argv)
     return 0;
 }
 
+ImagePrefetcher::ImagePrefetcher(const string &strSequence, const vector<string> &vstrRGB, const vector<string> &vstrD,
+                                 const int depth, const int nThreads):
+    mstrSequence(strSequence), mvstrRGB(vstrRGB), mvstrD(vstrD), mnImages(vstrRGB.size()),
+    mvSlots(depth), mnNext(0), mnConsumed(0), mbFinish(false)
+{
+    for(int i=0; i<depth; i++)
+        mvSlots[i].index = -1;
+
+    for(int i=0; i<nThreads; i++)
+        mvpThreads.push_back(new thread(&ImagePrefetcher::Run,this));
+}
+
+ImagePrefetcher::~ImagePrefetcher()
+{
+    {
+        unique_lock<mutex> lock(mMutex);
+        mbFinish = true;
+    }
+    mCondConsumed.notify_all();
+
+    for(size_t i=0; i<mvpThreads.size(); i++)
+    {
+        mvpThreads[i]->join();
+        delete mvpThreads[i];
+    }
+}
+
+void ImagePrefetcher::Run()
+{
+    const int depth = mvSlots.size();
+
+    while(1)
+    {
+        int ni;
+        {
+            unique_lock<mutex> lock(mMutex);
+            while(!mbFinish && mnNext<mnImages && mnNext>=mnConsumed+depth)
+                mCondConsumed.wait(lock);
+            if(mbFinish || mnNext>=mnImages)
+                return;
+            ni = mnNext++;
+        }
+
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        cv::Mat imRGB = cv::imread(mstrSequence+"/"+mvstrRGB[ni],CV_LOAD_IMAGE_UNCHANGED);
+        cv::Mat imD = cv::imread(mstrSequence+"/"+mvstrD[ni],CV_LOAD_IMAGE_UNCHANGED);
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+        {
+            unique_lock<mutex> lock(mMutex);
+            Slot &slot = mvSlots[ni%depth];
+            slot.imRGB = imRGB;
+            slot.imD = imD;
+            slot.decodeTime = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+            slot.index = ni;
+        }
+        mCondDecoded.notify_all();
+    }
+}
+
+bool ImagePrefetcher::Get(const int ni, cv::Mat &imRGB, cv::Mat &imD, double &decodeTime)
+{
+    {
+        unique_lock<mutex> lock(mMutex);
+        Slot &slot = mvSlots[ni%mvSlots.size()];
+        while(slot.index!=ni)
+            mCondDecoded.wait(lock);
+
+        imRGB = slot.imRGB;
+        imD = slot.imD;
+        decodeTime = slot.decodeTime;
+        slot.imRGB.release();
+        slot.imD.release();
+        mnConsumed = ni+1;
+    }
+    mCondConsumed.notify_all();
+
+    return !imRGB.empty();
+}
+
 void LoadImages(const string &strAssociationFilename, vector<string> &vstrImageFilenamesRGB,
                 vector<string> &vstrImageFilenamesD, vector<double> &vTimestamps)
 {
@@ -0,0 +1,210 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Several RGB-D sequences tracked at the same time, one System per stream, with the GCN
+// inference of all streams batched by a shared GCNInferenceService. All streams use the same
+// settings file (camera calibration is shared by every Frame). Frames are processed as fast as
+// possible and the viewer is disabled.
+
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+
+#include <opencv2/core/core.hpp>
+#include <System.h>
+#include <GCNInferenceService.h>
+
+using namespace std;
+
+
+void LoadImages(const string &strAssociationFilename, vector<string> &vstrImageFilenamesRGB,
+                vector<string> &vstrImageFilenamesD, vector<double> &vTimestamps);
+
+void RunStream(ORB_SLAM2::System* pSLAM, const string &strSequence, const string &strAssociation,
+               vector<float>* pvTimesTrack);
+
+int main(int argc, char **argv)
+{
+    if(argc < 5 || (argc-3)%2 != 0)
+    {
+        cerr << endl << "Usage: ./rgbd_gcn_multi path_to_vocabulary path_to_settings "
+             << "path_to_sequence_1 path_to_association_1 [path_to_sequence_2 path_to_association_2 ...]" << endl;
+        return 1;
+    }
+
+    const int nStreams = (argc-3)/2;
+
+    cv::FileStorage fSettings(argv[2], cv::FileStorage::READ);
+    if(!fSettings.isOpened())
+    {
+       cerr << "Failed to open settings file at: " << argv[2] << endl;
+       return 1;
+    }
+
+    string strDevice = (string)fSettings["GCNextractor.device"];
+    int nThreads = fSettings["GCNextractor.nThreads"];
+    int nMaxBatchSize = fSettings["GCNService.maxBatchSize"];
+    double maxLatency = fSettings["GCNService.maxLatency"];
+    if(nMaxBatchSize<=0)
+        nMaxBatchSize = nStreams;
+
+    int width = 320;
+    int height = 240;
+    if (getenv("FULL_RESOLUTION") != nullptr)
+    {
+        width = 640;
+        height = 480;
+    }
+
+    const char *net_fn = getenv("GCN_PATH");
+    net_fn = (net_fn == nullptr) ? "gcn2.pt" : net_fn;
+
+    // One module shared by all streams
+    ORB_SLAM2::GCNInferenceService service(net_fn,width,height,strDevice,nThreads,nMaxBatchSize,maxLatency);
+
+    cout << endl << "-------" << endl;
+    cout << "Streams: " << nStreams << ", max batch size: " << nMaxBatchSize
+         << ", max batch latency: " << maxLatency << " ms" << endl;
+
+    vector<ORB_SLAM2::System*> vpSLAM(nStreams);
+    for(int i=0; i<nStreams; i++)
+        vpSLAM[i] = new ORB_SLAM2::System(argv[1],argv[2],ORB_SLAM2::System::RGBD,false,&service);
+
+    vector<vector<float> > vvTimesTrack(nStreams);
+    vector<thread*> vpThreads(nStreams);
+
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    for(int i=0; i<nStreams; i++)
+        vpThreads[i] = new thread(&RunStream,vpSLAM[i],string(argv[3+2*i]),string(argv[4+2*i]),&vvTimesTrack[i]);
+
+    for(int i=0; i<nStreams; i++)
+    {
+        vpThreads[i]->join();
+        delete vpThreads[i];
+    }
+
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    const double ttotal = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+
+    std::cout << "Finished!" << std::endl;
+
+    int nFrames = 0;
+    for(int i=0; i<nStreams; i++)
+    {
+        vector<float> &vTimesTrack = vvTimesTrack[i];
+        nFrames += vTimesTrack.size();
+        if(vTimesTrack.empty())
+            continue;
+
+        sort(vTimesTrack.begin(),vTimesTrack.end());
+        float totaltime = 0;
+        for(size_t ni=0; ni<vTimesTrack.size(); ni++)
+            totaltime+=vTimesTrack[ni];
+
+        cout << "-------" << endl << endl;
+        cout << "stream " << i << endl;
+        cout << "median tracking time: " << vTimesTrack[vTimesTrack.size()/2] << endl;
+        cout << "mean tracking time: " << totaltime/vTimesTrack.size() << endl;
+    }
+
+    cout << "-------" << endl << endl;
+    cout << "aggregate throughput: " << nFrames/ttotal << " frames/s" << endl;
+
+    service.PrintStatistics();
+
+    // Save camera trajectories and stop all threads
+    for(int i=0; i<nStreams; i++)
+    {
+        stringstream ss;
+        ss << i;
+        vpSLAM[i]->SaveTrajectoryTUM("CameraTrajectory_" + ss.str() + ".txt");
+        vpSLAM[i]->SaveKeyFrameTrajectoryTUM("KeyFrameTrajectory_" + ss.str() + ".txt");
+        vpSLAM[i]->Shutdown();
+    }
+
+    service.Shutdown();
+
+    return 0;
+}
+
+void RunStream(ORB_SLAM2::System* pSLAM, const string &strSequence, const string &strAssociation,
+               vector<float>* pvTimesTrack)
+{
+    vector<string> vstrImageFilenamesRGB;
+    vector<string> vstrImageFilenamesD;
+    vector<double> vTimestamps;
+    LoadImages(strAssociation, vstrImageFilenamesRGB, vstrImageFilenamesD, vTimestamps);
+
+    const int nImages = min(vstrImageFilenamesRGB.size(),vstrImageFilenamesD.size());
+    pvTimesTrack->reserve(nImages);
+
+    cv::Mat imRGB, imD;
+    for(int ni=0; ni<nImages; ni++)
+    {
+        imRGB = cv::imread(strSequence+"/"+vstrImageFilenamesRGB[ni],CV_LOAD_IMAGE_UNCHANGED);
+        imD = cv::imread(strSequence+"/"+vstrImageFilenamesD[ni],CV_LOAD_IMAGE_UNCHANGED);
+
+        if(imRGB.empty())
+        {
+            cerr << endl << "Failed to load image at: "
+                 << strSequence << "/" << vstrImageFilenamesRGB[ni] << endl;
+            return;
+        }
+
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+        pSLAM->TrackRGBD(imRGB,imD,vTimestamps[ni]);
+
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+        pvTimesTrack->push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    }
+}
+
+void LoadImages(const string &strAssociationFilename, vector<string> &vstrImageFilenamesRGB,
+                vector<string> &vstrImageFilenamesD, vector<double> &vTimestamps)
+{
+    ifstream fAssociation;
+    fAssociation.open(strAssociationFilename.c_str());
+    while(!fAssociation.eof())
+    {
+        string s;
+        getline(fAssociation,s);
+        if(!s.empty())
+        {
+            stringstream ss;
+            ss << s;
+            double t;
+            string sRGB, sD;
+            ss >> t;
+            vTimestamps.push_back(t);
+            ss >> sRGB;
+            vstrImageFilenamesRGB.push_back(sRGB);
+            ss >> t;
+            ss >> sD;
+            vstrImageFilenamesD.push_back(sD);
+
+        }
+    }
+}
@@ -0,0 +1,213 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Runs the system on a synthetic RGB-D sequence (see SyntheticScene) and reports the tracking
+// time, the size of the map and the absolute trajectory error against the ground truth. The
+// features are given to the tracking directly, so no dataset, network or GPU is needed and every
+// run of the same settings sees the same frames. The scene and trajectory are set in the
+// Synthetic.* entries of the settings file (see Synthetic.yaml).
+//
+// Writes CameraTrajectory.txt, KeyFrameTrajectory.txt and GroundTruth.txt (TUM format).
+
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+
+#include <System.h>
+#include <SyntheticScene.h>
+#include <Converter.h>
+
+using namespace std;
+
+// Rigid alignment (rotation and translation, RGB-D has metric scale) of the estimated camera
+// centers to the ground truth, and RMSE, mean and max of the remaining errors.
+void ComputeATE(const vector<cv::Mat> &vEstimated, const vector<cv::Mat> &vGroundTruth, double &rmse, double &mean, double &max)
+{
+    const int N = vEstimated.size();
+    cv::Mat meanE = cv::Mat::zeros(3,1,CV_64F);
+    cv::Mat meanG = cv::Mat::zeros(3,1,CV_64F);
+    for(int i=0; i<N; i++)
+    {
+        meanE += vEstimated[i];
+        meanG += vGroundTruth[i];
+    }
+    meanE /= N;
+    meanG /= N;
+
+    cv::Mat H = cv::Mat::zeros(3,3,CV_64F);
+    for(int i=0; i<N; i++)
+        H += (vEstimated[i]-meanE)*(vGroundTruth[i]-meanG).t();
+
+    cv::SVD svd(H);
+    cv::Mat S = cv::Mat::eye(3,3,CV_64F);
+    if(cv::determinant(svd.vt.t()*svd.u.t())<0)
+        S.at<double>(2,2) = -1;
+    const cv::Mat R = svd.vt.t()*S*svd.u.t();
+    const cv::Mat t = meanG - R*meanE;
+
+    rmse = 0;
+    mean = 0;
+    max = 0;
+    for(int i=0; i<N; i++)
+    {
+        const double e = cv::norm(R*vEstimated[i]+t-vGroundTruth[i]);
+        rmse += e*e;
+        mean += e;
+        max = std::max(max,e);
+    }
+    rmse = sqrt(rmse/N);
+    mean /= N;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc != 3)
+    {
+        cerr << endl << "Usage: ./rgbd_synthetic path_to_vocabulary path_to_settings" << endl;
+        return 1;
+    }
+
+    cv::FileStorage fsSettings(argv[2], cv::FileStorage::READ);
+    if(!fsSettings.isOpened())
+    {
+        cerr << "Failed to open settings file at: " << argv[2] << endl;
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    ORB_SLAM2::SyntheticScene scene(argv[2]);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    const int nImages = scene.GetFrames();
+    cout << endl << "Synthetic scene: " << scene.GetPoints() << " points, " << nImages << " frames, generated in "
+         << std::chrono::duration_cast<std::chrono::duration<double> >(t1 - t0).count() << " s" << endl;
+
+    // The features are given directly, the ORB extractor only provides the scale information
+    setenv("USE_ORB","1",1);
+
+    // Create SLAM system. It initializes all system threads and gets ready to process frames.
+    ORB_SLAM2::System SLAM(argv[1],argv[2],ORB_SLAM2::System::RGBD,false);
+
+    vector<float> vTimesGenerate(nImages), vTimesTrack(nImages);
+    int nLost = 0;
+
+    cout << endl << "-------" << endl;
+    cout << "Start processing sequence ..." << endl;
+    cout << "Images in the sequence: " << nImages << endl << endl;
+
+    vector<cv::KeyPoint> vKeys;
+    cv::Mat descriptors;
+    vector<float> vDepth;
+    const cv::Size imageSize = scene.GetImageSize();
+
+    std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+    for(int ni=0; ni<nImages; ni++)
+    {
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        scene.GetFrame(ni,vKeys,descriptors,vDepth);
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+        const cv::Mat Tcw = SLAM.TrackRGBD(vKeys,descriptors,vDepth,imageSize,scene.GetTimestamp(ni));
+        std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+
+        vTimesGenerate[ni] = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+        vTimesTrack[ni] = std::chrono::duration_cast<std::chrono::duration<double> >(t3 - t2).count();
+        if(Tcw.empty())
+            nLost++;
+
+        if((ni+1)%500==0)
+            cout << ni+1 << " frames, " << SLAM.KeyFramesInMap() << " keyframes, " << SLAM.MapPointsInMap() << " map points" << endl;
+    }
+    const double tTotal = std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - tStart).count();
+
+    // Stop all threads (waits for a running global bundle adjustment)
+    SLAM.Shutdown();
+
+    // Tracking time statistics
+    vector<float> vSorted = vTimesTrack;
+    sort(vSorted.begin(),vSorted.end());
+    float totaltime = 0;
+    float totalGenerate = 0;
+    for(int ni=0; ni<nImages; ni++)
+    {
+        totaltime+=vTimesTrack[ni];
+        totalGenerate+=vTimesGenerate[ni];
+    }
+    cout << "-------" << endl << endl;
+    cout << "median tracking time: " << vSorted[nImages/2] << endl;
+    cout << "mean tracking time: " << totaltime/nImages << endl;
+    cout << "max tracking time: " << vSorted.back() << endl;
+    cout << "mean frame generation time: " << totalGenerate/nImages << endl;
+    cout << "processed " << nImages << " frames in " << tTotal << " s: " << nImages/tTotal << " fps, " << nLost << " frames lost" << endl;
+    cout << "map: " << SLAM.KeyFramesInMap() << " keyframes, " << SLAM.MapPointsInMap() << " map points" << endl;
+
+    // Save camera trajectory and the ground truth
+    SLAM.SaveTrajectoryTUM("CameraTrajectory.txt");
+    SLAM.SaveKeyFrameTrajectoryTUM("KeyFrameTrajectory.txt");
+
+    ofstream f("GroundTruth.txt");
+    f << fixed;
+    vector<cv::Mat> vGroundTruth(nImages);
+    for(int ni=0; ni<nImages; ni++)
+    {
+        const cv::Mat Twc = scene.GetPose(ni);
+        const vector<float> q = ORB_SLAM2::Converter::toQuaternion(Twc.rowRange(0,3).colRange(0,3));
+        Twc.rowRange(0,3).col(3).convertTo(vGroundTruth[ni],CV_64F);
+        f << setprecision(6) << scene.GetTimestamp(ni) << " " << setprecision(9) << Twc.at<float>(0,3) << " " << Twc.at<float>(1,3) << " "
+          << Twc.at<float>(2,3) << " " << q[0] << " " << q[1] << " " << q[2] << " " << q[3] << endl;
+    }
+    f.close();
+
+    // Absolute trajectory error of the tracked frames
+    vector<cv::Mat> vEstimated, vMatched;
+    ifstream fTrajectory("CameraTrajectory.txt");
+    string s;
+    while(getline(fTrajectory,s))
+    {
+        stringstream ss(s);
+        double t;
+        cv::Mat twc(3,1,CV_64F);
+        if(!(ss >> t >> twc.at<double>(0) >> twc.at<double>(1) >> twc.at<double>(2)))
+            continue;
+        const int ni = (int)floor(t*scene.GetFps()+0.5);
+        if(ni<0 || ni>=nImages)
+            continue;
+        vEstimated.push_back(twc);
+        vMatched.push_back(vGroundTruth[ni]);
+    }
+
+    if(vEstimated.size()<3)
+    {
+        cerr << "Not enough tracked frames to compute the trajectory error" << endl;
+        return 1;
+    }
+
+    double rmse, mean, max;
+    ComputeATE(vEstimated,vMatched,rmse,mean,max);
+    cout << "ATE: rmse " << rmse << " m, mean " << mean << " m, max " << max << " m over " << vEstimated.size() << " frames" << endl;
+
+    return 0;
+}
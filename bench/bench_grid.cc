@@ -0,0 +1,222 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Copy and lookup cost of the feature grid of Frame and KeyFrame.
+// Compares the previous grid of per-cell vectors with FeatureGrid (CSR layout over the KeyPointArray).
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cmath>
+
+#include <opencv2/core/core.hpp>
+
+#include "FeatureGrid.h"
+
+using namespace std;
+
+const int GRID_COLS = 64;
+const int GRID_ROWS = 48;
+
+// Previous implementation (one vector per cell), kept as reference.
+struct VectorGrid
+{
+    std::vector<std::size_t> mGrid[GRID_COLS][GRID_ROWS];
+    float mnMinX, mnMinY, mfGridElementWidthInv, mfGridElementHeightInv;
+
+    void Assign(const vector<cv::KeyPoint> &vKeysUn)
+    {
+        const int N = vKeysUn.size();
+        int nReserve = 0.5f*N/(GRID_COLS*GRID_ROWS);
+        for(unsigned int i=0; i<GRID_COLS;i++)
+            for (unsigned int j=0; j<GRID_ROWS;j++)
+                mGrid[i][j].reserve(nReserve);
+
+        for(int i=0;i<N;i++)
+        {
+            const cv::KeyPoint &kp = vKeysUn[i];
+            const int posX = round((kp.pt.x-mnMinX)*mfGridElementWidthInv);
+            const int posY = round((kp.pt.y-mnMinY)*mfGridElementHeightInv);
+            if(posX<0 || posX>=GRID_COLS || posY<0 || posY>=GRID_ROWS)
+                continue;
+            mGrid[posX][posY].push_back(i);
+        }
+    }
+
+    vector<size_t> GetFeaturesInArea(const vector<cv::KeyPoint> &mvKeysUn, const float &x, const float  &y, const float  &r, const int minLevel, const int maxLevel) const
+    {
+        vector<size_t> vIndices;
+        vIndices.reserve(mvKeysUn.size());
+
+        const int nMinCellX = max(0,(int)floor((x-mnMinX-r)*mfGridElementWidthInv));
+        if(nMinCellX>=GRID_COLS)
+            return vIndices;
+
+        const int nMaxCellX = min((int)GRID_COLS-1,(int)ceil((x-mnMinX+r)*mfGridElementWidthInv));
+        if(nMaxCellX<0)
+            return vIndices;
+
+        const int nMinCellY = max(0,(int)floor((y-mnMinY-r)*mfGridElementHeightInv));
+        if(nMinCellY>=GRID_ROWS)
+            return vIndices;
+
+        const int nMaxCellY = min((int)GRID_ROWS-1,(int)ceil((y-mnMinY+r)*mfGridElementHeightInv));
+        if(nMaxCellY<0)
+            return vIndices;
+
+        const bool bCheckLevels = (minLevel>0) || (maxLevel>=0);
+
+        for(int ix = nMinCellX; ix<=nMaxCellX; ix++)
+        {
+            for(int iy = nMinCellY; iy<=nMaxCellY; iy++)
+            {
+                const vector<size_t> vCell = mGrid[ix][iy];
+                if(vCell.empty())
+                    continue;
+
+                for(size_t j=0, jend=vCell.size(); j<jend; j++)
+                {
+                    const cv::KeyPoint &kpUn = mvKeysUn[vCell[j]];
+                    if(bCheckLevels)
+                    {
+                        if(kpUn.octave<minLevel)
+                            continue;
+                        if(maxLevel>=0)
+                            if(kpUn.octave>maxLevel)
+                                continue;
+                    }
+
+                    const float distx = kpUn.pt.x-x;
+                    const float disty = kpUn.pt.y-y;
+
+                    if(fabs(distx)<r && fabs(disty)<r)
+                        vIndices.push_back(vCell[j]);
+                }
+            }
+        }
+
+        return vIndices;
+    }
+};
+
+double Elapsed(const std::chrono::steady_clock::time_point &t1, const std::chrono::steady_clock::time_point &t2, int nIterations)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double,std::micro> >(t2 - t1).count()/nIterations;
+}
+
+void Run(int width, int height, int nFeatures, int nIterations)
+{
+    cv::RNG rng(12345);
+    vector<cv::KeyPoint> vKeys(nFeatures);
+    for(int i=0; i<nFeatures; i++)
+        vKeys[i] = cv::KeyPoint(rng.uniform(0.f,(float)width),rng.uniform(0.f,(float)height),1.0f,-1,0,rng.uniform(0,8));
+
+    const float widthInv = (float)GRID_COLS/width;
+    const float heightInv = (float)GRID_ROWS/height;
+
+    // Build
+    VectorGrid* pVectorGrid = new VectorGrid();
+    pVectorGrid->mnMinX = 0;
+    pVectorGrid->mnMinY = 0;
+    pVectorGrid->mfGridElementWidthInv = widthInv;
+    pVectorGrid->mfGridElementHeightInv = heightInv;
+
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+    {
+        VectorGrid* pGrid = new VectorGrid(*pVectorGrid);
+        pGrid->Assign(vKeys);
+        delete pGrid;
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    pVectorGrid->Assign(vKeys);
+
+    // FeatureGrid reads the keypoints from the structure of arrays kept by the frames
+    ORB_SLAM2::KeyPointArray keysUn;
+    keysUn.Assign(vKeys);
+    ORB_SLAM2::FeatureGrid grid;
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+        grid.Assign(keysUn,GRID_COLS,GRID_ROWS,0,0,widthInv,heightInv);
+    std::chrono::steady_clock::time_point t4 = std::chrono::steady_clock::now();
+
+    // Copy (Frame copy per tracked frame, KeyFrame construction)
+    size_t nCheck = 0;
+    std::chrono::steady_clock::time_point t5 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+    {
+        VectorGrid* pCopy = new VectorGrid(*pVectorGrid);
+        nCheck += pCopy->mGrid[it%GRID_COLS][it%GRID_ROWS].size();
+        delete pCopy;
+    }
+    std::chrono::steady_clock::time_point t6 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+    {
+        ORB_SLAM2::FeatureGrid* pCopy = new ORB_SLAM2::FeatureGrid(grid);
+        nCheck += pCopy->CellEnd(it%GRID_COLS,it%GRID_ROWS)-pCopy->CellBegin(it%GRID_COLS,it%GRID_ROWS);
+        delete pCopy;
+    }
+    std::chrono::steady_clock::time_point t7 = std::chrono::steady_clock::now();
+
+    // Lookup around every keypoint, as the projection searches do (radius 15, one level)
+    const float r = 15;
+    size_t nFoundVector = 0;
+    std::chrono::steady_clock::time_point t8 = std::chrono::steady_clock::now();
+    for(int i=0; i<nFeatures; i++)
+        nFoundVector += pVectorGrid->GetFeaturesInArea(vKeys,vKeys[i].pt.x,vKeys[i].pt.y,r,vKeys[i].octave-1,vKeys[i].octave+1).size();
+    std::chrono::steady_clock::time_point t9 = std::chrono::steady_clock::now();
+
+    size_t nFoundCSR = 0;
+    vector<size_t> vIndices;
+    bool bSame = true;
+    std::chrono::steady_clock::time_point t10 = std::chrono::steady_clock::now();
+    for(int i=0; i<nFeatures; i++)
+    {
+        grid.GetFeaturesInArea(keysUn,vKeys[i].pt.x,vKeys[i].pt.y,r,vKeys[i].octave-1,vKeys[i].octave+1,vIndices);
+        nFoundCSR += vIndices.size();
+    }
+    std::chrono::steady_clock::time_point t11 = std::chrono::steady_clock::now();
+
+    for(int i=0; i<nFeatures && bSame; i++)
+    {
+        grid.GetFeaturesInArea(keysUn,vKeys[i].pt.x,vKeys[i].pt.y,r,vKeys[i].octave-1,vKeys[i].octave+1,vIndices);
+        bSame = vIndices==pVectorGrid->GetFeaturesInArea(vKeys,vKeys[i].pt.x,vKeys[i].pt.y,r,vKeys[i].octave-1,vKeys[i].octave+1);
+    }
+
+    delete pVectorGrid;
+
+    cout << width << "x" << height << ", " << nFeatures << " features" << (bSame ? "" : " (RESULTS DIFFER)") << endl;
+    cout << "  vector grid: build " << Elapsed(t1,t2,nIterations) << " us, copy " << Elapsed(t5,t6,nIterations)
+         << " us, lookup " << Elapsed(t8,t9,nFeatures)*1e3 << " ns (" << nFoundVector << " found)" << endl;
+    cout << "  CSR grid:    build " << Elapsed(t3,t4,nIterations) << " us, copy " << Elapsed(t6,t7,nIterations)
+         << " us, lookup " << Elapsed(t10,t11,nFeatures)*1e3 << " ns (" << nFoundCSR << " found)" << endl;
+    if(nCheck==0)
+        cout << "  (empty cells)" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    const int nIterations = 2000;
+
+    Run(320,240,1000,nIterations);
+    Run(640,480,2000,nIterations);
+
+    return 0;
+}
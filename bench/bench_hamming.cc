@@ -0,0 +1,137 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Hamming distance kernels on 32 byte descriptors: the previous 32 bit SWAR DescriptorDistance
+// against every HammingDistance kernel supported by this CPU, for one-to-one, one-to-many and
+// many-to-many (distance matrix) calls. Results are checked against the previous implementation.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include "HammingDistance.h"
+
+using namespace std;
+using ORB_SLAM2::HammingDistance;
+
+// Previous ORBmatcher::DescriptorDistance. It was called across translation units, so it is
+// not inlined here either.
+__attribute__((noinline)) int DescriptorDistanceSWAR(const unsigned char* a, const unsigned char* b)
+{
+    int dist=0;
+    for(int i=0; i<8; i++)
+    {
+        uint32_t va, vb;
+        memcpy(&va,a+4*i,4);
+        memcpy(&vb,b+4*i,4);
+        unsigned int v = va ^ vb;
+        v = v - ((v >> 1) & 0x55555555);
+        v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+        dist += (((v + (v >> 4)) & 0xF0F0F0F) * 0x1010101) >> 24;
+    }
+    return dist;
+}
+
+double Elapsed(const std::chrono::steady_clock::time_point &t1, const std::chrono::steady_clock::time_point &t2)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double,std::nano> >(t2 - t1).count();
+}
+
+int main(int argc, char **argv)
+{
+    const int N = 2000;
+    const int nIterations = 20;
+    const size_t stride = HammingDistance::DESCRIPTOR_SIZE;
+
+    srand(12345);
+    vector<unsigned char> vA(N*stride), vB(N*stride);
+    for(size_t i=0; i<vA.size(); i++)
+    {
+        vA[i] = rand() & 0xFF;
+        vB[i] = rand() & 0xFF;
+    }
+    const unsigned char* A = &vA[0];
+    const unsigned char* B = &vB[0];
+
+    // Reference distance matrix
+    vector<int> vRef(N*N);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+        for(int i=0; i<N; i++)
+            for(int j=0; j<N; j++)
+                vRef[i*N+j] = DescriptorDistanceSWAR(A+i*stride,B+j*stride);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    const double tRef = Elapsed(t1,t2)/(nIterations*(double)N*N);
+
+    cout << fixed << setprecision(3);
+    cout << "ns per distance, " << N << "x" << N << " descriptors" << endl;
+    cout << setw(10) << "kernel" << setw(12) << "one2one" << setw(12) << "one2many" << setw(12) << "many2many" << endl;
+    cout << setw(10) << "legacy" << setw(12) << tRef << endl;
+
+    const HammingDistance::Kernel bestKernel = HammingDistance::GetKernel();
+
+    vector<int> vD(N*N);
+    bool bOk = true;
+    for(int k=HammingDistance::SCALAR; k<=HammingDistance::AVX512; k++)
+    {
+        const HammingDistance::Kernel kernel = (HammingDistance::Kernel)k;
+        if(!HammingDistance::SetKernel(kernel))
+        {
+            cout << setw(10) << HammingDistance::GetKernelName(kernel) << "  not supported" << endl;
+            continue;
+        }
+
+        t1 = std::chrono::steady_clock::now();
+        for(int it=0; it<nIterations; it++)
+            for(int i=0; i<N; i++)
+                for(int j=0; j<N; j++)
+                    vD[i*N+j] = HammingDistance::Distance(A+i*stride,B+j*stride);
+        t2 = std::chrono::steady_clock::now();
+        const double tOne = Elapsed(t1,t2)/(nIterations*(double)N*N);
+        bOk = bOk && vD==vRef;
+
+        t1 = std::chrono::steady_clock::now();
+        for(int it=0; it<nIterations; it++)
+            for(int i=0; i<N; i++)
+                HammingDistance::Distance(A+i*stride,B,N,stride,&vD[i*N]);
+        t2 = std::chrono::steady_clock::now();
+        const double tMany = Elapsed(t1,t2)/(nIterations*(double)N*N);
+        bOk = bOk && vD==vRef;
+
+        t1 = std::chrono::steady_clock::now();
+        for(int it=0; it<nIterations; it++)
+            HammingDistance::DistanceMatrix(A,N,stride,B,N,stride,&vD[0],N);
+        t2 = std::chrono::steady_clock::now();
+        const double tMatrix = Elapsed(t1,t2)/(nIterations*(double)N*N);
+        bOk = bOk && vD==vRef;
+
+        cout << setw(10) << HammingDistance::GetKernelName(kernel) << setw(12) << tOne << setw(12) << tMany << setw(12) << tMatrix << endl;
+    }
+
+    HammingDistance::SetKernel(bestKernel);
+    cout << "selected kernel: " << HammingDistance::GetKernelName(bestKernel) << endl;
+    cout << "results " << (bOk ? "match" : "DO NOT match") << " the previous implementation" << endl;
+
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Brute force descriptor matching as used by ORBmatcher::SearchByNN: cv::BFMatcher with cross
+// check followed by the distance threshold, against BinaryMatcher with 1 and 4 threads.
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/features2d/features2d.hpp>
+
+#include "BinaryMatcher.h"
+
+using namespace std;
+
+const int TH_HIGH = 100;
+
+// Second set is a noisy copy of the first one, so most descriptors have a true match
+void GenerateDescriptors(int N, cv::RNG &rng, cv::Mat &desc1, cv::Mat &desc2)
+{
+    desc1.create(N,32,CV_8U);
+    rng.fill(desc1,cv::RNG::UNIFORM,0,256);
+    desc2 = desc1.clone();
+    for(int i=0; i<N; i++)
+        for(int b=0; b<20; b++)
+            desc2.at<unsigned char>(i,rng.uniform(0,32)) ^= (1 << rng.uniform(0,8));
+}
+
+double TimePerCall(const std::chrono::steady_clock::time_point &t1, const std::chrono::steady_clock::time_point &t2, int nIterations)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double,std::micro> >(t2 - t1).count()/nIterations;
+}
+
+void Run(int N, int nIterations)
+{
+    cv::RNG rng(12345);
+    cv::Mat desc1, desc2;
+    GenerateDescriptors(N,rng,desc1,desc2);
+
+    int nBF = 0;
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+    {
+        vector<cv::DMatch> matches;
+        cv::BFMatcher desc_matcher(cv::NORM_HAMMING, true);
+        desc_matcher.match(desc1, desc2, matches, cv::Mat());
+        nBF = 0;
+        for(size_t i=0; i<matches.size(); i++)
+            if(matches[i].distance<=TH_HIGH)
+                nBF++;
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    cout << N << "x" << N << " descriptors" << endl;
+    cout << "  cv::BFMatcher:          " << TimePerCall(t1,t2,nIterations) << " us, " << nBF << " matches" << endl;
+
+    const int vThreads[] = {1, 4};
+    for(int t=0; t<2; t++)
+    {
+        ORB_SLAM2::BinaryMatcher matcher(TH_HIGH,0.0f,vThreads[t]);
+        vector<int> vMatches;
+        int nmatches = 0;
+
+        t1 = std::chrono::steady_clock::now();
+        for(int it=0; it<nIterations; it++)
+            nmatches = matcher.Match(desc1,desc2,vMatches);
+        t2 = std::chrono::steady_clock::now();
+
+        cout << "  BinaryMatcher " << vThreads[t] << " thread: " << TimePerCall(t1,t2,nIterations) << " us, " << nmatches << " matches" << endl;
+    }
+
+    ORB_SLAM2::BinaryMatcher matcherRatio(TH_HIGH,0.8f,1);
+    vector<int> vMatches;
+    cout << "  with ratio test 0.8:    " << matcherRatio.Match(desc1,desc2,vMatches) << " matches" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    Run(1000,50);
+    Run(2000,20);
+
+    return 0;
+}
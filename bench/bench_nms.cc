@@ -0,0 +1,162 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Per-frame cost of the GCN non-maximum suppression on synthetic detections.
+// Compares the previous dense grid implementation with NonMaxSuppression.
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "NonMaxSuppression.h"
+
+using namespace std;
+
+// Previous implementation (dense grids, raster scan), kept as reference.
+void nms_dense(cv::Mat det, cv::Mat desc, std::vector<cv::KeyPoint>& pts, cv::Mat& descriptors,
+        int border, int dist_thresh, int img_width, int img_height)
+{
+    std::vector<cv::Point2f> pts_raw;
+
+    for (int i = 0; i < det.rows; i++)
+        pts_raw.push_back(cv::Point2f((int) det.at<float>(i, 0), (int) det.at<float>(i, 1)));
+
+    cv::Mat grid = cv::Mat(cv::Size(img_width, img_height), CV_8UC1);
+    cv::Mat inds = cv::Mat(cv::Size(img_width, img_height), CV_16UC1);
+
+    grid.setTo(0);
+    inds.setTo(0);
+
+    for (size_t i = 0; i < pts_raw.size(); i++)
+    {
+        grid.at<char>(pts_raw[i].y, pts_raw[i].x) = 1;
+        inds.at<unsigned short>(pts_raw[i].y, pts_raw[i].x) = i;
+    }
+
+    cv::copyMakeBorder(grid, grid, dist_thresh, dist_thresh, dist_thresh, dist_thresh, cv::BORDER_CONSTANT, 0);
+
+    for (size_t i = 0; i < pts_raw.size(); i++)
+    {
+        int uu = (int) pts_raw[i].x + dist_thresh;
+        int vv = (int) pts_raw[i].y + dist_thresh;
+
+        if (grid.at<char>(vv, uu) != 1)
+            continue;
+
+        for(int k = -dist_thresh; k < (dist_thresh+1); k++)
+            for(int j = -dist_thresh; j < (dist_thresh+1); j++)
+            {
+                if(j==0 && k==0) continue;
+                grid.at<char>(vv + k, uu + j) = 0;
+            }
+        grid.at<char>(vv, uu) = 2;
+    }
+
+    std::vector<int> select_indice;
+
+    for (int v = 0; v < (img_height + dist_thresh); v++)
+        for (int u = 0; u < (img_width + dist_thresh); u++)
+        {
+            if (u -dist_thresh>= (img_width - border) || u-dist_thresh < border || v-dist_thresh >= (img_height - border) || v-dist_thresh < border)
+                continue;
+
+            if (grid.at<char>(v,u) == 2)
+            {
+                int select_ind = (int) inds.at<unsigned short>(v-dist_thresh, u-dist_thresh);
+                pts.push_back(cv::KeyPoint(pts_raw[select_ind], 1.0f));
+                select_indice.push_back(select_ind);
+            }
+        }
+
+    descriptors.create(select_indice.size(), 32, CV_8U);
+
+    for (size_t i=0; i<select_indice.size(); i++)
+        for (int j=0; j<32; j++)
+            descriptors.at<unsigned char>(i, j) = desc.at<unsigned char>(select_indice[i], j);
+}
+
+// Clustered detections, similar to what the detector head returns around corners.
+void GenerateDetections(int width, int height, int nDetections, cv::RNG &rng, cv::Mat &det, cv::Mat &desc)
+{
+    det.create(nDetections,3,CV_32F);
+    desc.create(nDetections,32,CV_8U);
+    rng.fill(desc,cv::RNG::UNIFORM,0,256);
+
+    const int nClusters = nDetections/6+1;
+    for(int i=0; i<nDetections; i++)
+    {
+        cv::RNG rngCluster(i%nClusters+1);
+        const float cx = rngCluster.uniform(0.f,(float)width);
+        const float cy = rngCluster.uniform(0.f,(float)height);
+        const float u = min(max(cx+(float)rng.gaussian(2.0),0.f),(float)width-1);
+        const float v = min(max(cy+(float)rng.gaussian(2.0),0.f),(float)height-1);
+        det.at<float>(i,0) = (int)u;
+        det.at<float>(i,1) = (int)v;
+        det.at<float>(i,2) = rng.uniform(0.f,1.f);
+    }
+}
+
+double TimePerFrame(const std::chrono::steady_clock::time_point &t1, const std::chrono::steady_clock::time_point &t2, int nIterations)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double,std::micro> >(t2 - t1).count()/nIterations;
+}
+
+void Run(int width, int height, int border, int dist_thresh, int nDetections, int nIterations)
+{
+    cv::RNG rng(12345);
+    cv::Mat det, desc;
+    GenerateDetections(width,height,nDetections,rng,det,desc);
+
+    vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+    {
+        keypoints.clear();
+        nms_dense(det,desc,keypoints,descriptors,border,dist_thresh,width,height);
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    const size_t nDense = keypoints.size();
+
+    ORB_SLAM2::NonMaxSuppression nms(width,height,dist_thresh,border);
+
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+        nms(det,desc,keypoints,descriptors);
+    std::chrono::steady_clock::time_point t4 = std::chrono::steady_clock::now();
+
+    cout << width << "x" << height << ", " << nDetections << " detections" << endl;
+    cout << "  dense grid:  " << TimePerFrame(t1,t2,nIterations) << " us/frame, " << nDense << " kept" << endl;
+    cout << "  sparse grid: " << TimePerFrame(t3,t4,nIterations) << " us/frame, " << keypoints.size() << " kept" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    const int nIterations = 1000;
+
+    Run(320,240,8,4,3000,nIterations);
+    Run(640,480,16,8,12000,nIterations);
+
+    return 0;
+}
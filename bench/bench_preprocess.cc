@@ -0,0 +1,99 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Per-frame cost of the RGB-D preprocessing ahead of the GCN: the previous chain of
+// cvtColor, resize and convertTo against the fused ImagePreprocessing path.
+
+#include <iostream>
+#include <chrono>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "ImagePreprocessing.h"
+
+using namespace std;
+
+double TimePerFrame(const std::chrono::steady_clock::time_point &t1, const std::chrono::steady_clock::time_point &t2, int nIterations)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double,std::micro> >(t2 - t1).count()/nIterations;
+}
+
+void Run(const cv::Size &inputSize, const cv::Size &size, int nIterations)
+{
+    const float depthFactor = 1.0f/5000.0f;
+
+    cv::RNG rng(12345);
+    cv::Mat imRGB(inputSize,CV_8UC3);
+    cv::Mat imD(inputSize,CV_16UC1);
+    rng.fill(imRGB,cv::RNG::UNIFORM,0,256);
+    rng.fill(imD,cv::RNG::UNIFORM,0,20000);
+
+    // Persistent network input, as in GCNextractor
+    cv::Mat input(size,CV_32FC1);
+
+    cv::Mat imGrayChain, imDepthChain;
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+    {
+        cv::Mat imGray, imDepth;
+        cv::cvtColor(imRGB,imGray,CV_BGR2GRAY);
+        cv::resize(imGray,imGray,size);
+        cv::resize(imD,imDepth,size,0,0,cv::INTER_NEAREST);
+        imDepth.convertTo(imDepth,CV_32F,depthFactor);
+        imGray.convertTo(input,CV_32FC1,1.f/255.f,0);
+        imGrayChain = imGray;
+        imDepthChain = imDepth;
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    cv::Mat imGrayFused, imDepthFused;
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    for(int it=0; it<nIterations; it++)
+    {
+        cv::Mat imGray(size,CV_8UC1);
+        cv::Mat imDepth(size,CV_32FC1);
+        ORB_SLAM2::ImagePreprocessing::ToGray(imRGB,false,imGray,input.ptr<float>());
+        ORB_SLAM2::ImagePreprocessing::ToDepth(imD,depthFactor,imDepth);
+        imGrayFused = imGray;
+        imDepthFused = imDepth;
+    }
+    std::chrono::steady_clock::time_point t4 = std::chrono::steady_clock::now();
+
+    const double tChain = TimePerFrame(t1,t2,nIterations);
+    const double tFused = TimePerFrame(t3,t4,nIterations);
+
+    cout << inputSize.width << "x" << inputSize.height << " -> " << size.width << "x" << size.height << endl;
+    cout << "  cvtColor/resize/convertTo: " << tChain << " us/frame" << endl;
+    cout << "  fused:                     " << tFused << " us/frame" << endl;
+    cout << "  saved:                     " << tChain-tFused << " us/frame" << endl;
+    cout << "  max gray difference: " << cv::norm(imGrayChain,imGrayFused,cv::NORM_INF)
+         << ", max depth difference: " << cv::norm(imDepthChain,imDepthFused,cv::NORM_INF) << endl;
+}
+
+int main(int argc, char **argv)
+{
+    const int nIterations = 1000;
+
+    Run(cv::Size(640,480),cv::Size(320,240),nIterations);
+    Run(cv::Size(640,480),cv::Size(640,480),nIterations);
+
+    return 0;
+}
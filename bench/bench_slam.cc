@@ -0,0 +1,808 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Microbenchmarks of the SLAM hot paths with a JSON report, to track regressions across versions.
+// Inputs are synthetic and deterministic: a textured plane seen by an RGB-D camera that moves
+// sideways in two passes. The first pass builds a map from the ground truth poses as the tracking
+// would (keyframes, map points, covisibility graph, keyframe database). The second pass revisits
+// the same area with its own map points, so its keyframes have loop candidates in the first pass.
+//
+// Usage: ./bench_slam [--filter text] [--min-time seconds] [--out file] [--vocabulary file]
+// The JSON report is written to stdout (or to --out) and a table to stderr. Without a vocabulary
+// file (binary, as loaded by System) a small vocabulary is trained on the synthetic descriptors.
+// Heap allocations are counted by replacing operator new and reported per sample. The cv::Mat
+// buffers (allocated by cv::fastMalloc) are counted apart by a default cv::MatAllocator that
+// forwards to the standard one, with OpenCV 3.4 or newer (reported as -1 otherwise).
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "Frame.h"
+#include "KeyFrame.h"
+#include "MapPoint.h"
+#include "Map.h"
+#include "KeyFrameDatabase.h"
+#include "ORBmatcher.h"
+#include "ORBextractor.h"
+#include "Optimizer.h"
+#include "Converter.h"
+#include "NonMaxSuppression.h"
+#include "MapPointDescriptors.h"
+#include "FrustumCuller.h"
+#include "HammingDistance.h"
+
+using namespace std;
+using namespace ORB_SLAM2;
+
+// Camera (TUM RGB-D like) and scene
+const int IMAGE_WIDTH = 640;
+const int IMAGE_HEIGHT = 480;
+const float FX = 525.0f;
+const float FY = 525.0f;
+const float CX = 319.5f;
+const float CY = 239.5f;
+const float BF = 40.0f;
+const float TH_DEPTH = 40.0f;
+const float SCENE_DEPTH = 2.0f;
+
+// Frames per pass, camera motion between frames and offset of the second pass (pixels)
+const int N_FRAMES = 30;
+const int STEP_X = 16;
+const int PASS_OFFSET_Y = 6;
+
+const int MIN_SAMPLES = 10;
+const int MAX_SAMPLES = 100000;
+
+// Calls to operator new in this process
+std::atomic<long> gnAllocations(0);
+
+void* operator new(size_t size)
+{
+    gnAllocations++;
+    void* p = malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+// cv::Mat buffers created in this process
+std::atomic<long> gnMatAllocations(0);
+
+#if CV_MAJOR_VERSION>3 || (CV_MAJOR_VERSION==3 && CV_MINOR_VERSION>=4)
+#define COUNT_MAT_ALLOCATIONS
+
+#if CV_MAJOR_VERSION>=4
+typedef cv::AccessFlag MatAccessFlags;
+#else
+typedef int MatAccessFlags;
+#endif
+
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+
+    CountingMatAllocator(): mpStdAllocator(cv::Mat::getStdAllocator())
+    {
+    }
+
+    // Buffers are created by the standard allocator, which also frees them
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           MatAccessFlags flags, cv::UMatUsageFlags usageFlags) const
+    {
+        if(!data)
+            gnMatAllocations++;
+        return mpStdAllocator->allocate(dims,sizes,type,data,step,flags,usageFlags);
+    }
+
+    bool allocate(cv::UMatData* u, MatAccessFlags accessFlags, cv::UMatUsageFlags usageFlags) const
+    {
+        return mpStdAllocator->allocate(u,accessFlags,usageFlags);
+    }
+
+    void deallocate(cv::UMatData* u) const
+    {
+        mpStdAllocator->deallocate(u);
+    }
+
+protected:
+
+    cv::MatAllocator* mpStdAllocator;
+};
+#endif
+
+struct Result
+{
+    string name;
+    // Operations per sample (the times are per sample)
+    int batch;
+    int nSamples;
+    double mean;
+    double median;
+    double min;
+    double max;
+    double stddev;
+    // Heap allocations (operator new) and cv::Mat buffers (-1 if not counted) per sample
+    double allocations;
+    double matAllocations;
+    // Value returned by the last sample (matches, keypoints, inliers...)
+    int value;
+};
+
+class Benchmark
+{
+public:
+
+    Benchmark(const string &strFilter, const double minTime): mstrFilter(strFilter), mMinTime(minTime)
+    {
+        cerr << setw(64) << left << "benchmark" << right << setw(12) << "mean us" << setw(12) << "median us"
+             << setw(12) << "min us" << setw(10) << "value" << setw(10) << "allocs" << setw(12) << "mat allocs" << endl;
+    }
+
+    bool Selected(const string &name) const
+    {
+        return mstrFilter.empty() || name.find(mstrFilter)!=string::npos;
+    }
+
+    // setup runs before every sample and is not timed. run returns the value of the sample.
+    void Run(const string &name, const int batch, const function<void()> &setup, const function<int()> &run)
+    {
+        if(!Selected(name))
+            return;
+
+        // Warm up
+        setup();
+        run();
+
+        vector<double> vTimes;
+        vTimes.reserve(MAX_SAMPLES);
+        double total = 0;
+        long nAllocations = 0;
+        long nMatAllocations = 0;
+        int value = 0;
+        while(((int)vTimes.size()<MIN_SAMPLES || total<mMinTime*1e6) && (int)vTimes.size()<MAX_SAMPLES)
+        {
+            setup();
+            const long nAllocationsBefore = gnAllocations;
+            const long nMatAllocationsBefore = gnMatAllocations;
+            std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            value = run();
+            std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+            nAllocations += gnAllocations-nAllocationsBefore;
+            nMatAllocations += gnMatAllocations-nMatAllocationsBefore;
+            const double t = std::chrono::duration_cast<std::chrono::duration<double,std::micro> >(t2 - t1).count();
+            vTimes.push_back(t);
+            total += t;
+        }
+
+        Result result;
+        result.name = name;
+        result.batch = batch;
+        result.nSamples = vTimes.size();
+        result.mean = total/vTimes.size();
+        double var = 0;
+        for(size_t i=0; i<vTimes.size(); i++)
+            var += (vTimes[i]-result.mean)*(vTimes[i]-result.mean);
+        result.stddev = sqrt(var/vTimes.size());
+        sort(vTimes.begin(),vTimes.end());
+        result.median = vTimes[vTimes.size()/2];
+        result.min = vTimes.front();
+        result.max = vTimes.back();
+        result.value = value;
+        result.allocations = (double)nAllocations/vTimes.size();
+#ifdef COUNT_MAT_ALLOCATIONS
+        result.matAllocations = (double)nMatAllocations/vTimes.size();
+#else
+        result.matAllocations = -1;
+#endif
+        mvResults.push_back(result);
+
+        cerr << setw(64) << left << name << right << fixed << setprecision(2) << setw(12) << result.mean
+             << setw(12) << result.median << setw(12) << result.min << setw(10) << value
+             << setw(10) << setprecision(1) << result.allocations << setw(12) << result.matAllocations << endl;
+    }
+
+    const vector<Result>& GetResults() const
+    {
+        return mvResults;
+    }
+
+protected:
+
+    string mstrFilter;
+    double mMinTime;
+    vector<Result> mvResults;
+};
+
+void NoSetup()
+{
+}
+
+string JsonString(const string &s)
+{
+    stringstream ss;
+    ss << '"';
+    for(size_t i=0; i<s.size(); i++)
+    {
+        if(s[i]=='"' || s[i]=='\\')
+            ss << '\\';
+        ss << s[i];
+    }
+    ss << '"';
+    return ss.str();
+}
+
+void WriteJson(ostream &out, const vector<pair<string,string> > &vContext, const vector<Result> &vResults)
+{
+    out << "{" << endl << "  \"context\": {" << endl;
+    for(size_t i=0; i<vContext.size(); i++)
+        out << "    " << JsonString(vContext[i].first) << ": " << vContext[i].second << (i+1<vContext.size() ? "," : "") << endl;
+    out << "  }," << endl << "  \"benchmarks\": [" << endl;
+    out << fixed << setprecision(3);
+    for(size_t i=0; i<vResults.size(); i++)
+    {
+        const Result &r = vResults[i];
+        out << "    {\"name\": " << JsonString(r.name) << ", \"batch\": " << r.batch << ", \"samples\": " << r.nSamples
+            << ", \"mean_us\": " << r.mean << ", \"median_us\": " << r.median << ", \"min_us\": " << r.min
+            << ", \"max_us\": " << r.max << ", \"stddev_us\": " << r.stddev << ", \"value\": " << r.value
+            << ", \"allocations\": " << r.allocations << ", \"mat_allocations\": " << r.matAllocations << "}"
+            << (i+1<vResults.size() ? "," : "") << endl;
+    }
+    out << "  ]" << endl << "}" << endl;
+}
+
+// Plane texture: random shapes on a noisy background, so FAST finds corners everywhere
+cv::Mat CreateTexture(int width, int height)
+{
+    cv::RNG rng(12345);
+    cv::Mat texture(height,width,CV_8UC1,cv::Scalar(128));
+    const int nShapes = width*height/150;
+    for(int i=0; i<nShapes; i++)
+    {
+        const cv::Point p(rng.uniform(0,width),rng.uniform(0,height));
+        const cv::Scalar color(rng.uniform(0,256));
+        if(rng.uniform(0,2))
+            cv::circle(texture,p,rng.uniform(2,12),color,-1);
+        else
+            cv::rectangle(texture,p,p+cv::Point(rng.uniform(3,20),rng.uniform(3,20)),color,-1);
+    }
+    cv::GaussianBlur(texture,texture,cv::Size(3,3),0);
+    return texture;
+}
+
+// View of the plane from the camera at pixel offset (ox, oy), with sensor noise
+void RenderFrame(const cv::Mat &texture, int ox, int oy, int seed, cv::Mat &imGray, cv::Mat &imDepth)
+{
+    cv::Mat noise(IMAGE_HEIGHT,IMAGE_WIDTH,CV_16SC1);
+    cv::RNG rng(seed);
+    rng.fill(noise,cv::RNG::NORMAL,0,3);
+    cv::Mat im;
+    texture(cv::Rect(ox,oy,IMAGE_WIDTH,IMAGE_HEIGHT)).convertTo(im,CV_16SC1);
+    im += noise;
+    im.convertTo(imGray,CV_8UC1);
+
+    imDepth = cv::Mat(IMAGE_HEIGHT,IMAGE_WIDTH,CV_32FC1,cv::Scalar(SCENE_DEPTH));
+}
+
+// Ground truth pose of the camera at pixel offset (ox, oy) (translation only)
+cv::Mat CameraPose(int ox, int oy)
+{
+    cv::Mat Tcw = cv::Mat::eye(4,4,CV_32F);
+    Tcw.at<float>(0,3) = -ox*SCENE_DEPTH/FX;
+    Tcw.at<float>(1,3) = -oy*SCENE_DEPTH/FY;
+    return Tcw;
+}
+
+// Keyframe at the frame pose. Keypoints are associated to the local map points by projection
+// (as Tracking::SearchLocalPoints) and new map points are created for the rest of the keypoints
+// with depth (as Tracking::CreateNewKeyFrame). The keyframe is not added to the database.
+KeyFrame* CreateKeyFrame(Frame &F, vector<MapPoint*> &vpLocalMapPoints, Map* pMap, KeyFrameDatabase* pKFDB)
+{
+    if(!vpLocalMapPoints.empty())
+    {
+        for(size_t i=0; i<vpLocalMapPoints.size(); i++)
+            if(F.isInFrustum(vpLocalMapPoints[i],0.5))
+                vpLocalMapPoints[i]->IncreaseVisible();
+
+        ORBmatcher matcher(0.8);
+        matcher.SearchByProjection(F,vpLocalMapPoints,3);
+    }
+
+    KeyFrame* pKF = new KeyFrame(F,pMap,pKFDB);
+    pMap->AddKeyFrame(pKF);
+
+    for(int i=0; i<F.N; i++)
+    {
+        MapPoint* pMP = F.mvpMapPoints[i];
+        if(pMP)
+        {
+            pMP->IncreaseFound();
+            pMP->AddObservation(pKF,i);
+            pKF->AddMapPoint(pMP,i);
+            pMP->ComputeDistinctiveDescriptors();
+            pMP->UpdateNormalAndDepth();
+        }
+        else if(F.mvDepth[i]>0)
+        {
+            cv::Mat x3D = F.UnprojectStereo(i);
+            pMP = new MapPoint(x3D,pKF,pMap);
+            pMP->AddObservation(pKF,i);
+            pKF->AddMapPoint(pMP,i);
+            pMP->ComputeDistinctiveDescriptors();
+            pMP->UpdateNormalAndDepth();
+            pMap->AddMapPoint(pMP);
+            vpLocalMapPoints.push_back(pMP);
+            F.mvpMapPoints[i] = pMP;
+        }
+    }
+
+    pKF->ComputeBoW();
+    pKF->UpdateConnections();
+
+    return pKF;
+}
+
+void ClearMatches(Frame &F)
+{
+    fill(F.mvpMapPoints.begin(),F.mvpMapPoints.end(),static_cast<MapPoint*>(NULL));
+    fill(F.mvbOutlier.begin(),F.mvbOutlier.end(),false);
+}
+
+// Clustered detections, similar to what the GCN detector head returns around corners
+void GenerateDetections(int width, int height, int nDetections, cv::Mat &det, cv::Mat &desc)
+{
+    cv::RNG rng(12345);
+    det.create(nDetections,3,CV_32F);
+    desc.create(nDetections,32,CV_8U);
+    rng.fill(desc,cv::RNG::UNIFORM,0,256);
+
+    const int nClusters = nDetections/6+1;
+    for(int i=0; i<nDetections; i++)
+    {
+        cv::RNG rngCluster(i%nClusters+1);
+        const float cx = rngCluster.uniform(0.f,(float)width);
+        const float cy = rngCluster.uniform(0.f,(float)height);
+        det.at<float>(i,0) = (int)min(max(cx+(float)rng.gaussian(2.0),0.f),(float)width-1);
+        det.at<float>(i,1) = (int)min(max(cy+(float)rng.gaussian(2.0),0.f),(float)height-1);
+        det.at<float>(i,2) = rng.uniform(0.f,1.f);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    string strFilter, strOut, strVocabulary;
+    double minTime = 0.5;
+    for(int i=1; i<argc; i++)
+    {
+        const string arg = argv[i];
+        if(arg=="--filter" && i+1<argc)
+            strFilter = argv[++i];
+        else if(arg=="--min-time" && i+1<argc)
+            minTime = atof(argv[++i]);
+        else if(arg=="--out" && i+1<argc)
+            strOut = argv[++i];
+        else if(arg=="--vocabulary" && i+1<argc)
+            strVocabulary = argv[++i];
+        else
+        {
+            cerr << "Usage: ./bench_slam [--filter text] [--min-time seconds] [--out file] [--vocabulary file]" << endl;
+            return 1;
+        }
+    }
+
+#ifdef COUNT_MAT_ALLOCATIONS
+    static CountingMatAllocator matAllocator;
+    cv::Mat::setDefaultAllocator(&matAllocator);
+#else
+    cerr << "cv::Mat buffers are not counted with OpenCV " << CV_VERSION << endl;
+#endif
+
+    // Scene
+    cv::Mat K = cv::Mat::eye(3,3,CV_32F);
+    K.at<float>(0,0) = FX;
+    K.at<float>(1,1) = FY;
+    K.at<float>(0,2) = CX;
+    K.at<float>(1,2) = CY;
+    cv::Mat DistCoef = cv::Mat::zeros(4,1,CV_32F);
+    const float thDepth = BF*TH_DEPTH/FX;
+
+    const cv::Mat texture = CreateTexture(IMAGE_WIDTH+STEP_X*N_FRAMES,IMAGE_HEIGHT+PASS_OFFSET_Y);
+    ORBextractor extractor(1000,1.2,8,20,7);
+
+    cerr << "Building the synthetic map..." << endl;
+
+    ORBVocabulary vocabulary;
+    if(!strVocabulary.empty())
+    {
+        if(!vocabulary.loadFromBinaryFile(strVocabulary))
+        {
+            cerr << "Failed to open vocabulary at: " << strVocabulary << endl;
+            return 1;
+        }
+    }
+    else
+    {
+        vector<vector<cv::Mat> > vvFeatures;
+        for(int k=0; k<N_FRAMES; k++)
+        {
+            cv::Mat im, depth, desc;
+            vector<cv::KeyPoint> vKeys;
+            RenderFrame(texture,k*STEP_X,0,k,im,depth);
+            extractor(im,cv::Mat(),vKeys,desc);
+            vvFeatures.push_back(Converter::toDescriptorVector(desc));
+        }
+        vocabulary.create(vvFeatures,10,5);
+    }
+
+    Map* pMap = new Map();
+    KeyFrameDatabase* pKFDB = new KeyFrameDatabase(vocabulary);
+
+    // Pass 0 along the plane, pass 1 over the same area with new map points
+    vector<KeyFrame*> vpKeyFrames[2];
+    vector<MapPoint*> vpMapPoints[2];
+    for(int pass=0; pass<2; pass++)
+    {
+        for(int k=0; k<N_FRAMES; k++)
+        {
+            cv::Mat im, depth;
+            const int oy = pass*PASS_OFFSET_Y;
+            RenderFrame(texture,k*STEP_X,oy,1000*(pass+1)+k,im,depth);
+            Frame F(im,depth,(pass*N_FRAMES+k)*0.033,&extractor,&vocabulary,K,DistCoef,BF,thDepth);
+            F.SetPose(CameraPose(k*STEP_X,oy));
+            KeyFrame* pKF = CreateKeyFrame(F,vpMapPoints[pass],pMap,pKFDB);
+            vpKeyFrames[pass].push_back(pKF);
+        }
+    }
+
+    // The loop query keyframe of the second pass is left out of the database, as in LoopClosing
+    KeyFrame* pLoopKF = vpKeyFrames[1][N_FRAMES/2];
+    for(int pass=0; pass<2; pass++)
+        for(int k=0; k<N_FRAMES; k++)
+            if(vpKeyFrames[pass][k]!=pLoopKF)
+                pKFDB->add(vpKeyFrames[pass][k]);
+
+    // Last and current frames in the middle of the first pass. The last frame is tracked against
+    // the map, the current frame pose is predicted with an error of 1 cm.
+    const int q = N_FRAMES/2;
+    cv::Mat imLast, depthLast, imCurrent, depthCurrent;
+    RenderFrame(texture,(q-1)*STEP_X,0,5000,imLast,depthLast);
+    RenderFrame(texture,q*STEP_X,0,5001,imCurrent,depthCurrent);
+
+    Frame LastFrame(imLast,depthLast,100.0,&extractor,&vocabulary,K,DistCoef,BF,thDepth);
+    LastFrame.SetPose(CameraPose((q-1)*STEP_X,0));
+    for(size_t i=0; i<vpMapPoints[0].size(); i++)
+        LastFrame.isInFrustum(vpMapPoints[0][i],0.5);
+    ORBmatcher(0.8).SearchByProjection(LastFrame,vpMapPoints[0],3);
+
+    Frame CurrentFrame(imCurrent,depthCurrent,100.033,&extractor,&vocabulary,K,DistCoef,BF,thDepth);
+    cv::Mat Tcw = CameraPose(q*STEP_X,0);
+    Tcw.at<float>(0,3) += 0.01f;
+    CurrentFrame.SetPose(Tcw);
+    CurrentFrame.ComputeBoW();
+    KeyFrame* pReferenceKF = vpKeyFrames[0][q-1];
+
+    // Matches for the pose optimization
+    ORBmatcher(0.9,true).SearchByProjection(CurrentFrame,LastFrame,7,false);
+    const vector<MapPoint*> vpPoseMatches = CurrentFrame.mvpMapPoints;
+    ClearMatches(CurrentFrame);
+
+    // Local map of the current frame: the points in view, as in Tracking::SearchLocalPoints
+    vector<MapPoint*> vpLocalMapPoints;
+    for(size_t i=0; i<vpMapPoints[0].size(); i++)
+        if(CurrentFrame.isInFrustum(vpMapPoints[0][i],0.5))
+            vpLocalMapPoints.push_back(vpMapPoints[0][i]);
+    MapPointDescriptors localMapDescriptors;
+    localMapDescriptors.Update(vpLocalMapPoints);
+    const cv::Mat &LocalMapDescriptors = localMapDescriptors.GetDescriptors();
+
+    // Map points of the loop candidate and its neighbours, as in LoopClosing::ComputeSim3
+    vector<MapPoint*> vpLoopMapPoints;
+    {
+        KeyFrame* pCandidateKF = vpKeyFrames[0][N_FRAMES/2];
+        vector<KeyFrame*> vpLoopConnectedKFs = pCandidateKF->GetVectorCovisibleKeyFrames();
+        vpLoopConnectedKFs.push_back(pCandidateKF);
+        set<MapPoint*> spLoopMapPoints;
+        for(size_t i=0; i<vpLoopConnectedKFs.size(); i++)
+        {
+            const vector<MapPoint*> vpMPs = vpLoopConnectedKFs[i]->GetMapPointMatches();
+            for(size_t j=0; j<vpMPs.size(); j++)
+                if(vpMPs[j] && !vpMPs[j]->isBad() && spLoopMapPoints.insert(vpMPs[j]).second)
+                    vpLoopMapPoints.push_back(vpMPs[j]);
+        }
+    }
+
+    // Minimum loop score of the query keyframe, as in LoopClosing::DetectLoop
+    float minScore = 1;
+    {
+        const vector<KeyFrame*> vpConnectedKeyFrames = pLoopKF->GetVectorCovisibleKeyFrames();
+        for(size_t i=0; i<vpConnectedKeyFrames.size(); i++)
+            minScore = min(minScore,(float)vocabulary.score(pLoopKF->mBowVec,vpConnectedKeyFrames[i]->mBowVec));
+    }
+
+    // State restored before each local bundle adjustment
+    const vector<KeyFrame*> vpAllKeyFrames = pMap->GetAllKeyFrames();
+    const vector<MapPoint*> vpAllMapPoints = pMap->GetAllMapPoints();
+    vector<cv::Mat> vKeyFramePoses, vMapPointPositions;
+    for(size_t i=0; i<vpAllKeyFrames.size(); i++)
+        vKeyFramePoses.push_back(vpAllKeyFrames[i]->GetPose());
+    for(size_t i=0; i<vpAllMapPoints.size(); i++)
+        vMapPointPositions.push_back(vpAllMapPoints[i]->GetWorldPos());
+
+    cerr << pMap->KeyFramesInMap() << " keyframes, " << pMap->MapPointsInMap() << " map points, "
+         << CurrentFrame.N << " keypoints in the current frame, " << vpLocalMapPoints.size()
+         << " local map points, " << vocabulary.size() << " words" << endl << endl;
+
+    Benchmark bench(strFilter,minTime);
+    ORBmatcher matcher(0.8);
+
+    // Descriptor distances, all pairs of the current and last frames
+    bench.Run("ORBmatcher::DescriptorDistance",CurrentFrame.N*LastFrame.N,NoSetup,[&]()
+    {
+        int sum = 0;
+        for(int i=0; i<CurrentFrame.N; i++)
+        {
+            const cv::Mat &d = CurrentFrame.mDescriptors.row(i);
+            for(int j=0; j<LastFrame.N; j++)
+                sum += ORBmatcher::DescriptorDistance(d,LastFrame.mDescriptors.row(j));
+        }
+        return sum/(CurrentFrame.N*LastFrame.N);
+    });
+
+    const function<void()> clearMatches = [&]() { ClearMatches(CurrentFrame); };
+
+    // Nearest neighbour matching
+    bench.Run("ORBmatcher::SearchByNN(KeyFrame,Frame)",1,NoSetup,[&]()
+    {
+        vector<MapPoint*> vpMatches;
+        return matcher.SearchByNN(pReferenceKF,CurrentFrame,vpMatches);
+    });
+
+    bench.Run("ORBmatcher::SearchByNN(Frame,LastFrame)",1,clearMatches,[&]()
+    {
+        return matcher.SearchByNN(CurrentFrame,LastFrame);
+    });
+
+    bench.Run("ORBmatcher::SearchByNN(Frame,MapPoints)",1,clearMatches,[&]()
+    {
+        return matcher.SearchByNN(CurrentFrame,vpLocalMapPoints);
+    });
+
+    bench.Run("ORBmatcher::SearchByNN(Frame,MapPoints,DescriptorTable)",1,clearMatches,[&]()
+    {
+        return matcher.SearchByNN(CurrentFrame,vpLocalMapPoints,LocalMapDescriptors);
+    });
+
+    // Frustum test of the whole map, as in Tracking::SearchLocalPoints
+    bench.Run("Frame::isInFrustum",(int)vpMapPoints[0].size(),NoSetup,[&]()
+    {
+        int n = 0;
+        for(size_t i=0; i<vpMapPoints[0].size(); i++)
+            n += CurrentFrame.isInFrustum(vpMapPoints[0][i],0.5);
+        return n;
+    });
+
+    FrustumCuller culler;
+    vector<FrustumCandidate> vCandidates;
+    bench.Run("FrustumCuller::Update",(int)vpMapPoints[0].size(),NoSetup,[&]()
+    {
+        culler.Update(vpMapPoints[0]);
+        return culler.GetRefreshed();
+    });
+
+    bench.Run("FrustumCuller::Cull",(int)vpMapPoints[0].size(),NoSetup,[&]()
+    {
+        culler.Cull(CurrentFrame,0.5,vCandidates);
+        return (int)vCandidates.size();
+    });
+
+    // Matching by projection
+    bench.Run("ORBmatcher::SearchByProjection(Frame,MapPoints)",1,clearMatches,[&]()
+    {
+        return matcher.SearchByProjection(CurrentFrame,vpLocalMapPoints,3);
+    });
+
+    bench.Run("ORBmatcher::SearchByProjectionAllLevels(Frame,MapPoints,DescriptorTable)",1,clearMatches,[&]()
+    {
+        return matcher.SearchByProjectionAllLevels(CurrentFrame,vpLocalMapPoints,LocalMapDescriptors,3,true,true);
+    });
+
+    ORBmatcher matcherMotion(0.9,true);
+    bench.Run("ORBmatcher::SearchByProjection(Frame,LastFrame)",1,clearMatches,[&]()
+    {
+        return matcherMotion.SearchByProjection(CurrentFrame,LastFrame,7,false);
+    });
+
+    ORBmatcher matcherReloc(0.9,true);
+    const set<MapPoint*> sAlreadyFound;
+    bench.Run("ORBmatcher::SearchByProjection(Frame,KeyFrame)",1,clearMatches,[&]()
+    {
+        return matcherReloc.SearchByProjection(CurrentFrame,pReferenceKF,sAlreadyFound,10,100);
+    });
+
+    const cv::Mat Scw = pLoopKF->GetPose();
+    vector<MapPoint*> vpLoopMatches;
+    bench.Run("ORBmatcher::SearchByProjection(KeyFrame,Sim3,MapPoints)",1,[&]()
+    {
+        vpLoopMatches.assign(pLoopKF->N,static_cast<MapPoint*>(NULL));
+    },[&]()
+    {
+        return matcher.SearchByProjection(pLoopKF,Scw,vpLoopMapPoints,vpLoopMatches,10);
+    });
+
+    // Non-maximum suppression of the GCN detections (320x240, as GCNextractor)
+    {
+        cv::Mat det, desc, descriptors;
+        GenerateDetections(320,240,3000,det,desc);
+        NonMaxSuppression nms(320,240,4,8);
+        vector<cv::KeyPoint> vKeys;
+        bench.Run("NonMaxSuppression (3000 detections)",1,NoSetup,[&]()
+        {
+            nms(det,desc,vKeys,descriptors);
+            return (int)vKeys.size();
+        });
+    }
+
+    // ORB extraction
+    {
+        vector<cv::KeyPoint> vKeys;
+        cv::Mat descriptors;
+        bench.Run("ORBextractor::operator()",1,NoSetup,[&]()
+        {
+            extractor(imCurrent,cv::Mat(),vKeys,descriptors);
+            return (int)vKeys.size();
+        });
+    }
+
+    // Grid queries around every keypoint
+    bench.Run("Frame::GetFeaturesInArea",CurrentFrame.N,NoSetup,[&]()
+    {
+        int n = 0;
+        for(int i=0; i<CurrentFrame.N; i++)
+        {
+            const cv::KeyPoint &kp = CurrentFrame.mvKeysUn[i];
+            n += CurrentFrame.GetFeaturesInArea(kp.pt.x,kp.pt.y,15).size();
+        }
+        return n;
+    });
+
+    vector<size_t> vIndices;
+    bench.Run("Frame::GetFeaturesInArea (buffer)",CurrentFrame.N,NoSetup,[&]()
+    {
+        int n = 0;
+        for(int i=0; i<CurrentFrame.N; i++)
+        {
+            const cv::KeyPoint &kp = CurrentFrame.mvKeysUn[i];
+            CurrentFrame.GetFeaturesInArea(kp.pt.x,kp.pt.y,15,-1,-1,vIndices);
+            n += vIndices.size();
+        }
+        return n;
+    });
+
+    // Copy done for the frames queued by the feature extraction thread
+    bench.Run("Frame copy",1,NoSetup,[&]()
+    {
+        Frame copy(CurrentFrame);
+        return copy.N;
+    });
+
+    // Frame built for every image and handed off to the last frame, as in Tracking. The features
+    // are given (no extraction), so this measures the frame buffers, grid and scale tables.
+    const vector<cv::KeyPoint> vCurrentKeys = CurrentFrame.mvKeys;
+    const cv::Mat CurrentDescriptors = CurrentFrame.mDescriptors.clone();
+    const vector<float> vCurrentDepth = CurrentFrame.mvDepth;
+    Frame TrackedFrame, PreviousFrame;
+    bench.Run("Frame construction and hand-off",1,NoSetup,[&]()
+    {
+        TrackedFrame = Frame(vCurrentKeys,CurrentDescriptors,vCurrentDepth,cv::Size(IMAGE_WIDTH,IMAGE_HEIGHT),100.033,
+                             &extractor,&vocabulary,K,DistCoef,BF,thDepth);
+        PreviousFrame = TrackedFrame;
+        return TrackedFrame.N;
+    });
+
+    bench.Run("Optimizer::PoseOptimization",1,[&]()
+    {
+        CurrentFrame.mvpMapPoints = vpPoseMatches;
+        fill(CurrentFrame.mvbOutlier.begin(),CurrentFrame.mvbOutlier.end(),false);
+        CurrentFrame.SetPose(Tcw);
+    },[&]()
+    {
+        return Optimizer::PoseOptimization(&CurrentFrame);
+    });
+
+    KeyFrame* pLastKF = vpKeyFrames[0].back();
+    bool bStopFlag = false;
+    bench.Run("Optimizer::LocalBundleAdjustment",1,[&]()
+    {
+        for(size_t i=0; i<vpAllKeyFrames.size(); i++)
+            vpAllKeyFrames[i]->SetPose(vKeyFramePoses[i]);
+        for(size_t i=0; i<vpAllMapPoints.size(); i++)
+            vpAllMapPoints[i]->SetWorldPos(vMapPointPositions[i]);
+    },[&]()
+    {
+        Optimizer::LocalBundleAdjustment(pLastKF,&bStopFlag,pMap);
+        return (int)pLastKF->GetVectorCovisibleKeyFrames().size()+1;
+    });
+
+    bench.Run("KeyFrameDatabase::DetectLoopCandidates",1,NoSetup,[&]()
+    {
+        return (int)pKFDB->DetectLoopCandidates(pLoopKF,minScore).size();
+    });
+
+    const vector<cv::Mat> vCurrentDesc = Converter::toDescriptorVector(CurrentFrame.mDescriptors);
+    bench.Run("TemplatedVocabulary::transform",1,NoSetup,[&]()
+    {
+        DBoW2::BowVector bowVec;
+        DBoW2::FeatureVector featVec;
+        vocabulary.transform(vCurrentDesc,bowVec,featVec,4);
+        return (int)bowVec.size();
+    });
+
+    // Report
+    char date[32];
+    const time_t now = time(NULL);
+    strftime(date,sizeof(date),"%Y-%m-%dT%H:%M:%SZ",gmtime(&now));
+
+    vector<pair<string,string> > vContext;
+    vContext.push_back(make_pair(string("date"),JsonString(date)));
+#ifdef __VERSION__
+    vContext.push_back(make_pair(string("compiler"),JsonString(__VERSION__)));
+#endif
+    vContext.push_back(make_pair(string("hardware_threads"),to_string(std::thread::hardware_concurrency())));
+    vContext.push_back(make_pair(string("hamming_kernel"),JsonString(HammingDistance::GetKernelName(HammingDistance::GetKernel()))));
+    vContext.push_back(make_pair(string("vocabulary"),JsonString(strVocabulary.empty() ? "synthetic" : strVocabulary)));
+    vContext.push_back(make_pair(string("vocabulary_words"),to_string(vocabulary.size())));
+    vContext.push_back(make_pair(string("keyframes"),to_string(pMap->KeyFramesInMap())));
+    vContext.push_back(make_pair(string("map_points"),to_string(pMap->MapPointsInMap())));
+    vContext.push_back(make_pair(string("frame_keypoints"),to_string(CurrentFrame.N)));
+    vContext.push_back(make_pair(string("local_map_points"),to_string(vpLocalMapPoints.size())));
+
+    if(strOut.empty())
+        WriteJson(cout,vContext,bench.GetResults());
+    else
+    {
+        ofstream f(strOut.c_str());
+        WriteJson(f,vContext,bench.GetResults());
+        cerr << endl << "Results written to " << strOut << endl;
+    }
+
+    pMap->clear();
+    delete pKFDB;
+    delete pMap;
+
+    return 0;
+}
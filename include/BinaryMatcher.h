@@ -0,0 +1,70 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BINARYMATCHER_H
+#define BINARYMATCHER_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+// Brute force matcher for 32 byte binary descriptors with cross check: a query and a train
+// descriptor are matched if each is the nearest neighbour of the other (lowest index on ties).
+// This is slightly stricter than cv::BFMatcher(NORM_HAMMING, true), which can match a query to
+// a train that chose it even when the query has a nearer train.
+// The distance matrix is computed only once: the best train of each query and the best query
+// of each train are updated in the same pass, over tiles of train descriptors that stay in
+// cache, and the distance threshold is applied before building any match.
+// Queries can be split among several threads.
+class BinaryMatcher
+{
+public:
+
+    // Matches with distance above maxDistance are rejected. If ratio>0, matches whose distance
+    // is not below ratio times the second best distance of the query are also rejected.
+    BinaryMatcher(int maxDistance, float ratio=0.0f, int nThreads=0);
+
+    // vMatches[i] is the train index matched to query i, or -1. Returns the number of matches.
+    int Match(const cv::Mat &query, const cv::Mat &train, std::vector<int> &vMatches);
+
+    // Threads used when nThreads is 0 in the constructor (1 by default).
+    static void SetDefaultThreads(int nThreads);
+
+protected:
+
+    // Best and second best train distances of each query and best query of each train,
+    // for the queries in [i0,i1).
+    void MatchRange(const cv::Mat &query, const cv::Mat &train, const int i0, const int i1,
+                    int* pBestTrain, int* pBestDist, int* pSecondDist,
+                    int* pBestQuery, int* pBestQueryDist);
+
+    int mnMaxDistance;
+    float mfRatio;
+    int mnThreads;
+
+    static int snDefaultThreads;
+};
+
+} //namespace ORB_SLAM
+
+#endif // BINARYMATCHER_H
@@ -0,0 +1,136 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FEATURECACHE_H
+#define FEATURECACHE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <utility>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+// Per-sequence cache of the GCN features (keypoints, confidence and 32 byte descriptors) indexed
+// by timestamp. A first run writes the features of every frame, later runs of the same sequence
+// read them instead of running the network, which makes parameter sweeps over tracking and
+// mapping fast and deterministic.
+//
+// File layout (little endian): a header {"GCNF", version, width, height, nFeatures, descriptor
+// bytes (int32), number of frames, offset of the index (int64)}, then for each frame its N
+// keypoints (u, v, confidence as float32) followed by its N descriptors, and at the end the
+// index with one entry {timestamp (float64), offset of the frame (int64), N, 0 (int32)} per frame.
+// The file is memory-mapped for reading, so frames are only paged in when requested.
+class FeatureCache
+{
+public:
+
+    FeatureCache();
+    ~FeatureCache();
+
+    // Map an existing cache. Returns false if the file is missing or not a valid cache.
+    bool Open(const std::string &strFile);
+
+    // Start writing a new cache. width, height and nFeatures describe the extraction settings
+    // and are checked by the readers. The index is written by Close.
+    bool Create(const std::string &strFile, int width, int height, int nFeatures);
+
+    // Finish writing (or unmap) the file and print the number of frames read or written.
+    void Close();
+
+    bool IsReading(){
+        return mpData!=NULL;
+    }
+
+    bool IsWriting(){
+        return mFile.is_open();
+    }
+
+    int GetWidth(){
+        return mnWidth;
+    }
+
+    int GetHeight(){
+        return mnHeight;
+    }
+
+    int GetFeatures(){
+        return mnFeatures;
+    }
+
+    // Features of the frame with this timestamp (1 us tolerance). Returns false if not cached.
+    bool Get(const double &timestamp, std::vector<cv::KeyPoint> &vKeys, cv::Mat &descriptors);
+
+    // Append the features of a frame.
+    void Add(const double &timestamp, const std::vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors);
+
+protected:
+
+    struct Header
+    {
+        char signature[4];
+        int32_t version;
+        int32_t width;
+        int32_t height;
+        int32_t nFeatures;
+        int32_t descriptorSize;
+        int64_t nFrames;
+        int64_t indexOffset;
+    };
+
+    struct IndexEntry
+    {
+        double timestamp;
+        int64_t offset;
+        int32_t N;
+        int32_t reserved;
+    };
+
+    std::string mstrFile;
+    int mnWidth;
+    int mnHeight;
+    int mnFeatures;
+
+    // Reading: mapped file and index sorted by timestamp
+    const unsigned char* mpData;
+    size_t mnSize;
+    const IndexEntry* mpIndex;
+    std::vector<std::pair<double,int> > mvOrder;
+
+    // Writing
+    std::ofstream mFile;
+    std::vector<IndexEntry> mvIndex;
+    int64_t mnOffset;
+    std::vector<float> mvKeyBuffer;
+
+    int mnHits;
+    int mnMisses;
+
+    std::mutex mMutex;
+};
+
+} //namespace ORB_SLAM
+
+#endif // FEATURECACHE_H
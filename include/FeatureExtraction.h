@@ -0,0 +1,115 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FEATUREEXTRACTION_H
+#define FEATUREEXTRACTION_H
+
+#include "Frame.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <list>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+namespace ORB_SLAM2
+{
+
+class Tracking;
+
+// Feature extraction stage that runs ahead of the tracking. Input images are queued and
+// turned into Frames (keypoints, descriptors, depth) in a separate thread, so that frame N+1
+// is extracted while frame N is tracked. The queue is bounded: inserting blocks while
+// more than mnQueueSize frames are waiting to be tracked.
+class FeatureExtraction
+{
+public:
+    FeatureExtraction(Tracking* pTracker, const int nQueueSize);
+
+    // Main function
+    void Run();
+
+    // Queue a RGB-D image for extraction. Images are copied.
+    void InsertImageRGBD(const cv::Mat &imRGB, const cv::Mat &imD, const double &timestamp);
+
+    // Get the oldest extracted frame and its grayscale image. Blocks until it is ready.
+    // Returns false if no frame is pending.
+    bool GetFrame(Frame &frame, cv::Mat &imGray);
+
+    // Frames inserted and not yet retrieved (queued, in extraction or extracted).
+    int FramesPending();
+
+    int GetQueueSize(){
+        return mnQueueSize;
+    }
+
+    // Drop all pending frames (used on reset).
+    void Clear();
+
+    void AddTrackingTime(const double &t);
+
+    // Prints queue depth and per stage timings
+    void PrintStatistics();
+
+    void RequestFinish();
+    bool isFinished();
+
+protected:
+
+    struct ImageRGBD
+    {
+        cv::Mat imRGB;
+        cv::Mat imD;
+        double timestamp;
+    };
+
+    struct ExtractedFrame
+    {
+        Frame frame;
+        cv::Mat imGray;
+    };
+
+    Tracking* mpTracker;
+
+    const int mnQueueSize;
+
+    std::list<ImageRGBD> mlImages;
+    std::list<ExtractedFrame> mlFrames;
+    bool mbBusy;
+
+    bool mbFinishRequested;
+    bool mbFinished;
+
+    std::mutex mMutexQueue;
+    std::condition_variable mCondImages;
+    std::condition_variable mCondFrames;
+
+    // Stage statistics (seconds)
+    std::vector<float> mvTimesExtraction;
+    std::vector<float> mvTimesTracking;
+    std::vector<float> mvTimesWait;
+    std::vector<int> mvQueueDepth;
+    std::mutex mMutexStats;
+};
+
+} //namespace ORB_SLAM
+
+#endif // FEATUREEXTRACTION_H
@@ -0,0 +1,97 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FEATUREGRID_H
+#define FEATUREGRID_H
+
+#include <vector>
+#include <cstddef>
+
+#include <opencv2/core/core.hpp>
+
+#include "FrameArena.h"
+#include "KeyPointArray.h"
+
+namespace ORB_SLAM2
+{
+
+// Keypoints of a frame bucketed in a grid of cells for the search of features in an area.
+// Compressed sparse row layout: the keypoint indices of all cells in one array, ordered by
+// cell, and the start of each cell in another, so copying a grid copies two arrays. Cells are
+// stored by column (cell ix*rows+iy), so the cells of a column within a search area are
+// contiguous, and the indices in a cell are increasing, which gives the same order of results
+// as a grid of per-cell vectors visited column by column.
+class FeatureGrid
+{
+public:
+
+    FeatureGrid();
+
+    // The arrays are taken from the FrameArena and given back on destruction. Assignment
+    // copies into the arrays of this grid.
+    FeatureGrid(const FeatureGrid &grid);
+    FeatureGrid& operator=(const FeatureGrid &grid) = default;
+    ~FeatureGrid();
+
+    // Assign the keypoints to the cell nearest to (x-minX)*cellWidthInv, (y-minY)*cellHeightInv.
+    // Keypoints outside the grid are not assigned.
+    void Assign(const KeyPointArray &keysUn, const int nCols, const int nRows,
+                const float minX, const float minY, const float cellWidthInv, const float cellHeightInv);
+
+    // Indices of the keypoints in the square of half side r around (x,y), with octave in
+    // [minLevel,maxLevel] (minLevel<=0 and maxLevel<0 disable the checks). The result is
+    // written into vIndices, which is cleared first and keeps its capacity between calls.
+    void GetFeaturesInArea(const KeyPointArray &keysUn, const float &x, const float &y, const float &r,
+                           const int minLevel, const int maxLevel, std::vector<size_t> &vIndices) const;
+
+    // Keypoint indices of a cell
+    const unsigned int* CellBegin(const int ix, const int iy) const{
+        return mvIndices.data()+mvCellStart[ix*mnRows+iy];
+    }
+
+    const unsigned int* CellEnd(const int ix, const int iy) const{
+        return mvIndices.data()+mvCellStart[ix*mnRows+iy+1];
+    }
+
+    int GetCols() const{
+        return mnCols;
+    }
+
+    int GetRows() const{
+        return mnRows;
+    }
+
+protected:
+
+    int mnCols;
+    int mnRows;
+    float mfMinX;
+    float mfMinY;
+    float mfCellWidthInv;
+    float mfCellHeightInv;
+
+    // Start of each cell in mvIndices (mnCols*mnRows+1 entries) and keypoint indices by cell
+    std::vector<unsigned int> mvCellStart;
+    std::vector<unsigned int> mvIndices;
+};
+
+} //namespace ORB_SLAM
+
+#endif // FEATUREGRID_H
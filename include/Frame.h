@@ -30,8 +30,13 @@
 #include "KeyFrame.h"
 #include "ORBextractor.h"
 #include "GCNextractor.h"
+#include "FeatureGrid.h"
+#include "FrameArena.h"
+#include "KeyPointArray.h"
+#include "LevelTable.h"
 
 #include <opencv2/opencv.hpp>
+#include <Eigen/Core>
 
 namespace ORB_SLAM2
 {
@@ -52,6 +57,13 @@ public:
     // Copy constructor.
     Frame(const Frame &frame);
 
+    // Member-wise assignment: the vectors are copied into the buffers of this frame (no
+    // allocation once they are large enough) and the cv::Mat headers are shared.
+    Frame& operator=(const Frame &frame) = default;
+
+    // The per-keypoint buffers go back to the FrameArena of this thread.
+    ~Frame();
+
     // Constructor for stereo cameras.
     Frame(const cv::Mat &imLeft, const cv::Mat &imRight, const double &timeStamp, ORBextractor* extractorLeft, ORBextractor* extractorRight, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth);
 
@@ -62,11 +74,23 @@ public:
     Frame(const cv::Mat &imGray, const double &timeStamp, ORBextractor* extractor,ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth);
 
     Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeStamp, GCNextractor* extractor, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth);
-    
+
+    // Constructor for RGB-D cameras with GCN features computed beforehand (feature cache).
+    // The extractor only provides the scale information, the network is not run.
+    Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeStamp, const std::vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, GCNextractor* extractor, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth);
+
+    // Constructor for RGB-D features given directly, without images (synthetic scenes).
+    // vDepth holds the depth of each keypoint (<=0 if unknown), descriptors one row per keypoint
+    // (copied). The extractor only provides the scale information.
+    Frame(const std::vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, const std::vector<float> &vDepth, const cv::Size &imageSize, const double &timeStamp, ORBextractor* extractor, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth);
+
     // Extract ORB on the image. 0 for left image and 1 for right image.
     void ExtractORB(int flag, const cv::Mat &im);
     void ExtractGCN(const cv::Mat &im);
 
+    // Scale information, undistortion, depth association and grid of a GCN RGB-D frame
+    void SetupGCN(const cv::Mat &imGray, const cv::Mat &imDepth, cv::Mat &K);
+
     // Compute Bag of Words representation.
     void ComputeBoW();
 
@@ -86,6 +110,19 @@ public:
         return mRwc.clone();
     }
 
+    // Pose as fixed-size Eigen types, updated with mTcw (no allocation, for the tracking loops)
+    inline const Eigen::Matrix3f& GetRotationEigen() const{
+        return mRcwEigen;
+    }
+
+    inline const Eigen::Vector3f& GetTranslationEigen() const{
+        return mtcwEigen;
+    }
+
+    inline const Eigen::Vector3f& GetCameraCenterEigen() const{
+        return mOwEigen;
+    }
+
     // Check if a MapPoint is in the frustum of the camera
     // and fill variables of the MapPoint to be used by the tracking
     bool isInFrustum(MapPoint* pMP, float viewingCosLimit);
@@ -95,6 +132,10 @@ public:
 
     vector<size_t> GetFeaturesInArea(const float &x, const float  &y, const float  &r, const int minLevel=-1, const int maxLevel=-1) const;
 
+    // Same search, the result is written into vIndices (a buffer reused by the caller)
+    void GetFeaturesInArea(const float &x, const float  &y, const float  &r, const int minLevel, const int maxLevel,
+                           vector<size_t> &vIndices) const;
+
     // Search a match for each keypoint in the left image to a keypoint in the right image.
     // If there is a match, depth is computed and the right coordinate associated to the left keypoint is stored.
     void ComputeStereoMatches();
@@ -117,7 +158,8 @@ public:
     // Frame timestamp.
     double mTimeStamp;
 
-    // Calibration matrix and OpenCV distortion parameters.
+    // Calibration matrix and OpenCV distortion parameters. Shared with the Tracking (never
+    // written in place), so building a frame does not copy them.
     cv::Mat mK;
     static float fx;
     static float fy;
@@ -146,6 +188,9 @@ public:
     std::vector<cv::KeyPoint> mvKeys, mvKeysRight;
     std::vector<cv::KeyPoint> mvKeysUn;
 
+    // Coordinates, octave and angle of mvKeysUn as separate arrays, for the matching and optimization loops.
+    KeyPointArray mKeysUnArray;
+
     // Corresponding stereo coordinate and depth for each keypoint.
     // "Monocular" keypoints have a negative value.
     std::vector<float> mvuRight;
@@ -167,7 +212,7 @@ public:
     // Keypoints are assigned to cells in a grid to reduce matching complexity when projecting MapPoints.
     static float mfGridElementWidthInv;
     static float mfGridElementHeightInv;
-    std::vector<std::size_t> mGrid[FRAME_GRID_COLS][FRAME_GRID_ROWS];
+    FeatureGrid mGrid;
 
     // Camera pose.
     cv::Mat mTcw;
@@ -183,10 +228,10 @@ public:
     int mnScaleLevels;
     float mfScaleFactor;
     float mfLogScaleFactor;
-    vector<float> mvScaleFactors;
-    vector<float> mvInvScaleFactors;
-    vector<float> mvLevelSigma2;
-    vector<float> mvInvLevelSigma2;
+    LevelTable mvScaleFactors;
+    LevelTable mvInvScaleFactors;
+    LevelTable mvLevelSigma2;
+    LevelTable mvInvLevelSigma2;
 
     // Undistorted Image Bounds (computed once).
     static float mnMinX;
@@ -210,11 +255,19 @@ private:
     // Assign keypoints to the grid for speed up feature matching (called in the constructor).
     void AssignFeaturesToGrid();
 
+    // Take the per-keypoint buffers from the FrameArena (called in the constructors) and give them back.
+    void AcquireBuffers();
+    void ReleaseBuffers();
+
     // Rotation, translation and camera center
     cv::Mat mRcw;
     cv::Mat mtcw;
     cv::Mat mRwc;
     cv::Mat mOw; //==mtwc
+
+    Eigen::Matrix3f mRcwEigen;
+    Eigen::Vector3f mtcwEigen;
+    Eigen::Vector3f mOwEigen;
 };
 
 }// namespace ORB_SLAM
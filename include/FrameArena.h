@@ -0,0 +1,146 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+namespace ORB_SLAM2
+{
+
+// Per-thread pool of the per-keypoint buffers of the frames. A frame takes its vectors from
+// the pool of the thread that builds it and gives them back when it is destroyed, so the
+// temporary frame built for every image reuses the capacity of the previous one and the
+// tracking does not allocate them again at steady state.
+//
+// With Extraction.queueSize>0 frames are built in the extraction thread and destroyed in the
+// tracking thread. A thread whose pool is full moves half of it to a shared pool, and a thread
+// whose pool is empty refills half of it from there, so buffers flow back to the thread that
+// builds the frames with one lock per MAX_POOLED/2 buffers.
+class FrameArena
+{
+public:
+
+    // Buffers kept per element type and thread
+    static const size_t MAX_POOLED = 16;
+
+    // Buffers kept per element type in the shared pool, the rest are freed
+    static const size_t MAX_SHARED = 64;
+
+    // Swap a recycled buffer (empty, with capacity) into v, if v has no capacity yet
+    template<class T>
+    static void Acquire(std::vector<T> &v)
+    {
+        if(v.capacity()==0)
+        {
+            std::vector<std::vector<T> > &vPool = GetPool<T>();
+            if(vPool.empty())
+                Refill(vPool);
+
+            if(!vPool.empty())
+            {
+                v.swap(vPool.back());
+                vPool.pop_back();
+            }
+        }
+        v.clear();
+    }
+
+    // Give the buffer of v back to the pool of this thread, v is left empty
+    template<class T>
+    static void Release(std::vector<T> &v)
+    {
+        if(v.capacity()==0)
+            return;
+
+        std::vector<std::vector<T> > &vPool = GetPool<T>();
+        if(vPool.size()==MAX_POOLED)
+            Spill(vPool);
+
+        vPool.push_back(std::vector<T>());
+        vPool.back().swap(v);
+    }
+
+protected:
+
+    template<class T>
+    struct SharedPool
+    {
+        std::mutex mMutex;
+        std::vector<std::vector<T> > mvBuffers;
+    };
+
+    template<class T>
+    static std::vector<std::vector<T> >& GetPool()
+    {
+        static thread_local std::vector<std::vector<T> > vPool;
+        if(vPool.capacity()==0)
+            vPool.reserve(MAX_POOLED);
+        return vPool;
+    }
+
+    template<class T>
+    static SharedPool<T>& GetSharedPool()
+    {
+        static SharedPool<T> shared;
+        return shared;
+    }
+
+    // Move half of a full thread pool to the shared pool
+    template<class T>
+    static void Spill(std::vector<std::vector<T> > &vPool)
+    {
+        SharedPool<T> &shared = GetSharedPool<T>();
+        std::unique_lock<std::mutex> lock(shared.mMutex);
+        if(shared.mvBuffers.capacity()==0)
+            shared.mvBuffers.reserve(MAX_SHARED);
+
+        while(vPool.size()>MAX_POOLED/2)
+        {
+            if(shared.mvBuffers.size()<MAX_SHARED)
+            {
+                shared.mvBuffers.push_back(std::vector<T>());
+                shared.mvBuffers.back().swap(vPool.back());
+            }
+            vPool.pop_back();
+        }
+    }
+
+    // Take up to half a thread pool from the shared pool
+    template<class T>
+    static void Refill(std::vector<std::vector<T> > &vPool)
+    {
+        SharedPool<T> &shared = GetSharedPool<T>();
+        std::unique_lock<std::mutex> lock(shared.mMutex);
+        while(vPool.size()<MAX_POOLED/2 && !shared.mvBuffers.empty())
+        {
+            vPool.push_back(std::vector<T>());
+            vPool.back().swap(shared.mvBuffers.back());
+            shared.mvBuffers.pop_back();
+        }
+    }
+};
+
+} //namespace ORB_SLAM
+
+#endif // FRAMEARENA_H
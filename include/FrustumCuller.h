@@ -0,0 +1,102 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+#include <vector>
+
+namespace ORB_SLAM2
+{
+
+class MapPoint;
+class Frame;
+
+// Local map point in the frustum of a frame, with the data used to search it by projection
+struct FrustumCandidate
+{
+    // Index of the point in the list given to FrustumCuller::Update
+    int index;
+    float u;
+    float v;
+    // Projection in the right image (stereo/RGB-D)
+    float ur;
+    int level;
+    float viewCos;
+};
+
+// Frustum test of a list of map points, as Frame::isInFrustum, done in one pass over a packed
+// snapshot (structure of arrays) of their positions, normals and distance bounds. The test itself
+// is branch-free so the compiler vectorizes it, and the scale level and viewing cosine are only
+// computed for the points that pass. Long lists can be split among several threads.
+// On Update, rows of points that were in the previous snapshot and whose position version did not
+// change are copied from it, so only new or moved points are read under their mutex.
+class FrustumCuller
+{
+public:
+
+    FrustumCuller();
+
+    void Update(const std::vector<MapPoint*> &vpMapPoints);
+
+    void Clear();
+
+    // Points of the snapshot in the frustum of F and with viewing cosine of at least
+    // viewingCosLimit, by increasing index. The map points are not modified.
+    void Cull(const Frame &F, const float viewingCosLimit, std::vector<FrustumCandidate> &vCandidates);
+
+    void SetThreads(int nThreads);
+
+    // Rows read from the map points in the last Update
+    int GetRefreshed() const {
+        return mnRefreshed;
+    }
+
+protected:
+
+    struct Snapshot
+    {
+        std::vector<MapPoint*> vpMapPoints;
+        std::vector<int> vVersions;
+        std::vector<float> vX, vY, vZ;
+        std::vector<float> vNx, vNy, vNz;
+        // Squared distance bounds (scale invariance region) and maximum distance for the scale prediction
+        std::vector<float> vMinDist2, vMaxDist2;
+        std::vector<float> vMaxDistance;
+
+        void Resize(const int n);
+        void CopyRow(const int i, const Snapshot &from, const int j);
+    };
+
+    void CullRange(const Frame &F, const float viewingCosLimit, const int i0, const int i1,
+                   std::vector<FrustumCandidate> &vCandidates);
+
+    // Current and previous snapshots, swapped on each Update
+    Snapshot mSnapshots[2];
+    int mnCurrent;
+    int mnRefreshed;
+
+    int mnThreads;
+    std::vector<std::vector<FrustumCandidate> > mvThreadCandidates;
+};
+
+} //namespace ORB_SLAM
+
+#endif // FRUSTUMCULLER_H
@@ -0,0 +1,162 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GCNINFERENCESERVICE_H
+#define GCNINFERENCESERVICE_H
+
+#ifdef WITH_TORCH
+#include <torch/script.h> // One-stop header.
+#include <torch/torch.h>
+
+// Compile will fail for opimizier since pytorch defined this
+#ifdef EIGEN_MPL2_ONLY
+#undef EIGEN_MPL2_ONLY
+#endif
+#endif
+
+#include <opencv2/core/core.hpp>
+
+#include <list>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "GCNNetwork.h"
+
+namespace ORB_SLAM2
+{
+
+// GCN inference shared by several Tracking instances (one per camera stream). Extractors
+// submit their normalized network input and block until the result is ready. Requests are
+// gathered in a single Nx1xHxW forward pass of one shared network: a batch is run as soon as
+// every registered stream has submitted a frame, the batch is full, or the oldest request has
+// waited for the maximum batch latency.
+//
+// Weight files exported by GCN2/export_gcn.py run on the CPU in the native GCNNetwork, which
+// takes batches of any size. TorchScript models (WITH_TORCH builds) use the usual outputs for
+// batches of one image (pts Kx3: u, v, confidence; desc Kx32). For larger batches the model
+// must return pts as Kx4 (image index, u, v, confidence), as given by nonzero() over the batch.
+// If it does not, the service runs the images one by one.
+class GCNInferenceService
+{
+public:
+
+    // strDevice and nThreads as in GCNextractor (the native network always runs on the CPU).
+    // maxLatency in milliseconds.
+    GCNInferenceService(const std::string &strModelPath, int width, int height,
+                        const std::string &strDevice, int nThreads,
+                        int nMaxBatchSize, double maxLatency);
+
+    ~GCNInferenceService();
+
+    // Streams using the service. A batch is not delayed once every stream has submitted.
+    void RegisterStream();
+    void UnregisterStream();
+
+    // Blocking inference of a HxW CV_32F normalized image. Outputs are owned by the caller.
+    void Infer(const cv::Mat &input, cv::Mat &pts, cv::Mat &desc);
+
+    int GetWidth(){
+        return mnWidth;
+    }
+
+    int GetHeight(){
+        return mnHeight;
+    }
+
+    bool IsOnCPU();
+
+    int GetThreads();
+
+    // Precision of the native network, as GCNextractor::SetPrecision.
+    bool SetPrecision(const std::string &strPrecision, const std::string &strCalibration);
+
+    std::string GetPrecision();
+
+    // Batch size and forward time statistics
+    void PrintStatistics();
+
+    // Finish pending requests and stop the inference thread.
+    void Shutdown();
+
+protected:
+
+    struct Request
+    {
+        const cv::Mat* pInput;
+        cv::Mat pts;
+        cv::Mat desc;
+        bool bDone;
+        std::chrono::steady_clock::time_point tSubmit;
+    };
+
+    // Main function of the inference thread
+    void Run();
+
+    void Forward(std::vector<Request*> &vpBatch);
+
+    // Whole batch in the native network
+    void ForwardNative(std::vector<Request*> &vpBatch);
+
+#ifdef WITH_TORCH
+    void ForwardModule(std::vector<Request*> &vpBatch);
+
+    // Run the module on images [i0,i0+n) of the input tensor. Outputs are on the CPU, one row per point.
+    void Forward(const int i0, const int n, torch::Tensor &pts, torch::Tensor &desc);
+
+    std::shared_ptr<torch::jit::script::Module> module;
+    torch::Device mDevice;
+
+    // Persistent maxBatchSize x 1 x H x W host input
+    torch::Tensor mInputTensor;
+#endif
+
+    // Native network (NULL if the model runs in libtorch) and its batch
+    GCNNetwork* mpNetwork;
+    std::vector<cv::Mat> mvInputs;
+    std::vector<cv::Mat> mvPts;
+    std::vector<cv::Mat> mvDesc;
+    std::mutex mMutexNetwork;
+
+    int mnWidth;
+    int mnHeight;
+    int mnMaxBatchSize;
+    std::chrono::microseconds mMaxLatency;
+
+    std::list<Request*> mlpRequests;
+    int mnStreams;
+    bool mbFinishRequested;
+    std::mutex mMutexRequests;
+    std::condition_variable mCondRequests;
+    std::condition_variable mCondDone;
+
+    std::thread* mptInference;
+
+    // Statistics
+    std::vector<int> mvBatchSizes;
+    std::vector<float> mvTimesForward;
+};
+
+} //namespace ORB_SLAM
+
+#endif // GCNINFERENCESERVICE_H
@@ -0,0 +1,243 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GCNNETWORK_H
+#define GCNNETWORK_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+// Native CPU forward pass of GCNv2 and GCNv2_tiny (see GCN2/Network.md), without libtorch.
+// Weights are read from the flat file written by GCN2/export_gcn.py. Convolutions are computed
+// as GEMMs over im2col panels of 16 output pixels, with bias and ELU fused in the store.
+// Output channels are split among a pool of threads, and the GEMM kernel is selected at
+// runtime (AVX2/FMA when available, portable C++ otherwise).
+// Several images can be run in one pass: every layer is then a single GEMM over the panels of
+// all images, so the threads are synchronized once per layer for the whole batch and the late
+// low resolution layers have enough panels to keep every thread busy.
+//
+// The outputs match the exported TorchScript models: one row (u, v, confidence) per pixel of
+// the detection map above the detection threshold, in raster order, and the descriptor of each
+// keypoint. The L2 normalized descriptor map is bilinearly sampled at the keypoint and
+// binarized (channel 8*i+j > 0 sets bit j of byte i).
+//
+// Reduced precision modes:
+// FP16 keeps the weights in half precision (half the memory) and converts the weights of each
+// layer back to float right before its GEMM. Arithmetic stays in FP32.
+// INT8 quantizes the weights per output channel to [-127,127] and the input of each layer to
+// 8 bits (asymmetric, with the range recorded by Calibrate). Products are accumulated in 32 bit
+// integers with 16 bit multiply-adds (fused in vpdpwssd with AVX-VNNI), and bias and ELU are
+// applied after rescaling to float.
+class GCNNetwork
+{
+public:
+
+    enum Kernel
+    {
+        SCALAR=0,
+        AVX2=1,
+        AVX_VNNI=2      // AVX2 with fused 16 bit dot products, only used by INT8
+    };
+
+    enum Precision
+    {
+        FP32=0,
+        FP16=1,
+        INT8=2
+    };
+
+    static const float DETECTION_THRESHOLD;
+
+    // nThreads 0 uses one thread per core.
+    GCNNetwork(int width, int height, int nThreads=0, float detThreshold=DETECTION_THRESHOLD);
+    ~GCNNetwork();
+
+    // Returns false (and prints the reason) if the file is missing or does not match the network.
+    bool Load(const std::string &strFile);
+
+    // True if the file starts with the weight file signature.
+    static bool IsWeightFile(const std::string &strFile);
+
+    // Switch to a reduced precision after Load. The FP32 weights are released, so the network
+    // cannot go back to FP32 without loading again. INT8 needs a calibration.
+    bool SetPrecision(Precision precision);
+
+    Precision GetPrecision(){
+        return mPrecision;
+    }
+
+    // Record the input range of every layer on a set of HxW CV_32F images (FP32 only).
+    void Calibrate(const std::vector<cv::Mat> &vImages);
+    bool SaveCalibration(const std::string &strFile);
+    bool LoadCalibration(const std::string &strFile);
+
+    bool IsCalibrated(){
+        return mbCalibrated;
+    }
+
+    // "fp32", "fp16" or "int8"
+    static bool ParsePrecision(const std::string &str, Precision &precision);
+    static const char* GetPrecisionName(Precision precision);
+
+    // input: HxW CV_32F image in [0,1]. pts: Nx3 CV_32F (u, v, confidence). desc: Nx32 CV_8U.
+    void operator()(const cv::Mat &input, cv::Mat &pts, cv::Mat &desc);
+
+    // Batch of images, same outputs per image. Buffers grow to the largest batch seen.
+    void operator()(const std::vector<cv::Mat> &vInputs, std::vector<cv::Mat> &vPts, std::vector<cv::Mat> &vDesc);
+
+    // Detection map (HxW) and L2 normalized descriptor map (256 x H/16*W/16) of the last image.
+    const cv::Mat& GetDetectionMap(){
+        return mDetectionMap;
+    }
+
+    const cv::Mat& GetDescriptorMap(){
+        return mDescriptorMap;
+    }
+
+    int GetWidth(){
+        return mnWidth;
+    }
+
+    int GetHeight(){
+        return mnHeight;
+    }
+
+    int GetThreads(){
+        return mnThreads;
+    }
+
+    // Kernel in use, and kernel selection (for benchmarking, not thread-safe).
+    static Kernel GetKernel();
+    static bool SetKernel(Kernel kernel);
+    static bool IsSupported(Kernel kernel);
+    static const char* GetKernelName(Kernel kernel);
+
+protected:
+
+    struct Layer
+    {
+        std::string name;
+        int nIn;
+        int nOut;
+        int kernel;
+        int stride;
+        int pad;
+        bool bELU;
+
+        // Weights in blocks of 4 output channels, interleaved: W[block][k][4], k over (c,ky,kx)
+        std::vector<float> vWeights;
+        std::vector<float> vBias;
+
+        // FP16: same layout as vWeights
+        std::vector<unsigned short> vWeightsHalf;
+
+        // INT8: W[block][k/2][4][2] (pairs of k per channel for the 16 bit multiply-add), output
+        // scale and zero point correction per channel
+        std::vector<short> vWeightsInt;
+        std::vector<float> vScale;
+        std::vector<int> vOffset;
+
+        // Input range (calibration) and input quantization
+        float inputMin;
+        float inputMax;
+        float inputScale;
+        int inputZero;
+    };
+
+    // Convolution of nImages consecutive nIn x inH x inW inputs, outputs are nOut x outH x outW.
+    void Convolution(Layer &layer, const float* pIn, const int nImages, const int inH, const int inW, float* pOut);
+
+    // Panels [p0,p1) of the batch, the panels of image i follow those of image i-1.
+    void Im2Col(const Layer &layer, const float* pIn, const int inH, const int inW,
+                const int outH, const int outW, const int p0, const int p1);
+
+    // Grow the activation and panel buffers to nImages images
+    void Reserve(const int nImages);
+
+    // 8 bit quantization of the im2col panels [p0,p1) into mvPanelsInt
+    void QuantizePanels(const Layer &layer, const int p0, const int p1);
+
+    void QuantizeWeights(Layer &layer);
+
+    // Run job(i) for i in [0,mnThreads), job(0) in the calling thread.
+    void Parallel(const std::function<void(int)> &job);
+    void Worker(const int i);
+
+    void Binarize(const float* pDesc, unsigned char* pBits);
+
+    // Keypoints of mDetectionMap with descriptors sampled from the normalized cells pCells
+    void ExtractKeypoints(const float* pCells, const int hCells, const int wCells, cv::Mat &pts, cv::Mat &desc);
+
+    int mnWidth;
+    int mnHeight;
+    int mnThreads;
+    float mfDetThreshold;
+
+    bool mbLoaded;
+
+    Precision mPrecision;
+    bool mbCalibrated;
+    bool mbCalibrating;
+
+    // conv1, conv2, conv3_1, conv3_2, conv4_1, conv4_2, convF_1, convF_2, convD_1, convD_2
+    std::vector<Layer> mvLayers;
+
+    // Input batch, activations (two ping-pong buffers and the shared encoder output) and im2col
+    // panels, for mnBatchCapacity images of the sizes below
+    int mnBatchCapacity;
+    size_t mnActivationSize;
+    size_t mnEncoderSize;
+    size_t mnPanelsSize;
+    size_t mnPanelsIntSize;
+    std::vector<float> mvInput;
+    std::vector<float> mvBufferA;
+    std::vector<float> mvBufferB;
+    std::vector<float> mvEncoder;
+    std::vector<float> mvPanels;
+    std::vector<short> mvPanelsInt;
+    std::vector<float> mvWeightsFloat;
+
+    cv::Mat mDetectionMap;
+    cv::Mat mDescriptorMap;
+    std::vector<float> mvCellDescriptors;
+
+    // Thread pool
+    std::vector<std::thread*> mvpWorkers;
+    const std::function<void(int)>* mpJob;
+    unsigned long mnJob;
+    int mnPending;
+    bool mbFinish;
+    std::mutex mMutexWorkers;
+    std::condition_variable mCondWork;
+    std::condition_variable mCondDone;
+};
+
+} //namespace ORB_SLAM
+
+#endif // GCNNETWORK_H
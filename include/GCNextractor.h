@@ -21,6 +21,7 @@
 #ifndef GCNEXTRACTOR_H
 #define GCNEXTRACTOR_H
 
+#ifdef WITH_TORCH
 #include <torch/script.h> // One-stop header.
 #include <torch/torch.h>
 
@@ -28,25 +29,41 @@
 #ifdef EIGEN_MPL2_ONLY
 #undef EIGEN_MPL2_ONLY
 #endif
+#endif
 
 #include <vector>
 #include <list>
+#include <string>
 #include <opencv/cv.h>
 
+#include "LevelTable.h"
+#include "NonMaxSuppression.h"
+#include "GCNNetwork.h"
 
 namespace ORB_SLAM2
 {
 
+class GCNInferenceService;
+
 class GCNextractor
 {
 public:
     
     enum {HARRIS_SCORE=0, FAST_SCORE=1 };
 
+    // strDevice selects where the network runs ("cpu" or "cuda"). If empty or "auto",
+    // CUDA is used when available and the CPU otherwise. nThreads sets the number of
+    // intra-op threads for CPU inference (0 keeps the library default).
+    // If pService is given, the network runs in the shared inference service (which sets the
+    // input resolution, device, threads and precision) and no module is loaded by the extractor.
+    // If GCN_PATH is a weight file exported by GCN2/export_gcn.py, the network runs on the CPU
+    // with the native GCNNetwork (nThreads threads) instead of libtorch.
     GCNextractor(int nfeatures, float scaleFactor, int nlevels,
-                 int iniThFAST, int minThFAST);
+                 int iniThFAST, int minThFAST,
+                 const std::string &strDevice = "", int nThreads = 0,
+                 GCNInferenceService* pService = NULL);
 
-    ~GCNextractor(){}
+    ~GCNextractor();
 
     // Compute the ORB features and descriptors on an image.
     // ORB are dispersed on the image using an octree.
@@ -55,28 +72,56 @@ public:
                     std::vector<cv::KeyPoint>& keypoints,
                     cv::OutputArray descriptors);
 
+    // Fused preprocessing of a color or gray image into imGray (allocated by the caller with
+    // the tracking resolution). When imGray has the network resolution, the normalized input is
+    // written in the same pass and the next call to operator() on imGray skips its conversion.
+    // Returns false if the image is not supported by the fused path.
+    bool Preprocess(const cv::Mat &im, const bool bRGB, cv::Mat &imGray);
+
     int inline GetLevels(){
         return nlevels;}
 
+    int inline GetFeatures(){
+        return nfeatures;}
+
+    // Network input resolution
+    int inline GetInputWidth(){
+        return mnInputWidth;}
+
+    int inline GetInputHeight(){
+        return mnInputHeight;}
+
     float inline GetScaleFactor(){
         return scaleFactor;}
 
-    std::vector<float> inline GetScaleFactors(){
-        return mvScaleFactor;
+    LevelTable inline GetScaleFactors(){
+        return mScaleFactorTable;
     }
 
-    std::vector<float> inline GetInverseScaleFactors(){
-        return mvInvScaleFactor;
+    LevelTable inline GetInverseScaleFactors(){
+        return mInvScaleFactorTable;
     }
 
-    std::vector<float> inline GetScaleSigmaSquares(){
-        return mvLevelSigma2;
+    LevelTable inline GetScaleSigmaSquares(){
+        return mLevelSigma2Table;
     }
 
-    std::vector<float> inline GetInverseScaleSigmaSquares(){
-        return mvInvLevelSigma2;
+    LevelTable inline GetInverseScaleSigmaSquares(){
+        return mInvLevelSigma2Table;
     }
 
+    bool IsOnCPU();
+
+    // Threads used for CPU inference
+    int GetThreads();
+
+    // Precision of the native network ("fp32", "fp16" or "int8"). INT8 loads the input ranges
+    // written by gcn_quantize from strCalibration. Returns false (and keeps FP32) if the
+    // precision is not available, TorchScript models and the shared service only run in FP32.
+    bool SetPrecision(const std::string &strPrecision, const std::string &strCalibration);
+
+    std::string GetPrecision();
+
     std::vector<cv::Mat> mvImagePyramid;
 
 protected:
@@ -96,7 +141,45 @@ protected:
     std::vector<float> mvLevelSigma2;
     std::vector<float> mvInvLevelSigma2;
 
+    // Tables shared with the frames
+    LevelTable mScaleFactorTable;
+    LevelTable mInvScaleFactorTable;
+    LevelTable mLevelSigma2Table;
+    LevelTable mInvLevelSigma2Table;
+
+#ifdef WITH_TORCH
     std::shared_ptr<torch::jit::script::Module> module;
+#endif
+
+    // Native network (NULL if the network runs in libtorch)
+    GCNNetwork* mpNetwork;
+
+    // Network input resolution and NMS parameters (in network pixels, scaled with the width).
+    int mnInputWidth;
+    int mnInputHeight;
+    int mnBorder;
+    int mnDistThresh;
+
+#ifdef WITH_TORCH
+    torch::Device mDevice;
+#endif
+
+    // Shared batched inference (NULL if the extractor runs its own module)
+    GCNInferenceService* mpService;
+
+    NonMaxSuppression* mpNMS;
+
+    // Persistent 1x1xHxW network input. With libtorch, mInputMat wraps the host tensor memory
+    // so the normalized image is written in place. On CUDA it is uploaded to mDeviceInput.
+#ifdef WITH_TORCH
+    torch::Tensor mInputTensor;
+    torch::Tensor mDeviceInput;
+#endif
+    cv::Mat mInputMat;
+    cv::Mat mImFloat;
+
+    // Image whose normalized input is already in mInputTensor (set by Preprocess)
+    const uchar* mpPreparedImage;
 };
 
 } //namespace ORB_SLAM
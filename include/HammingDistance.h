@@ -0,0 +1,67 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HAMMINGDISTANCE_H
+#define HAMMINGDISTANCE_H
+
+#include <cstddef>
+
+namespace ORB_SLAM2
+{
+
+// Hamming distance between 256-bit (32 byte) ORB/GCN descriptors.
+// The kernel is selected at runtime from the best instruction set supported by the CPU:
+// scalar (SWAR popcount), SSE4.2 (popcnt), AVX2 (nibble lookup table) or AVX-512 (VPOPCNTDQ).
+// Descriptors do not need to be aligned.
+class HammingDistance
+{
+public:
+
+    enum Kernel
+    {
+        SCALAR=0,
+        SSE42=1,
+        AVX2=2,
+        AVX512=3
+    };
+
+    static const int DESCRIPTOR_SIZE = 32;
+
+    // One-to-one
+    static int Distance(const unsigned char* a, const unsigned char* b);
+
+    // One-to-many: dist[i] = d(a, B[i]), B[i] at B+i*strideB bytes.
+    static void Distance(const unsigned char* a, const unsigned char* B, const int nB, const size_t strideB, int* dist);
+
+    // Many-to-many: D[i*strideD+j] = d(A[i], B[j]). B is processed in tiles that stay in L1 cache.
+    static void DistanceMatrix(const unsigned char* A, const int nA, const size_t strideA,
+                               const unsigned char* B, const int nB, const size_t strideB,
+                               int* D, const size_t strideD);
+
+    // Kernel in use, and kernel selection (for benchmarking, not thread-safe).
+    static Kernel GetKernel();
+    static bool SetKernel(Kernel kernel);
+    static bool IsSupported(Kernel kernel);
+    static const char* GetKernelName(Kernel kernel);
+};
+
+} //namespace ORB_SLAM
+
+#endif // HAMMINGDISTANCE_H
@@ -0,0 +1,50 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGEPREPROCESSING_H
+#define IMAGEPREPROCESSING_H
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+// Single pass conversions of the input images to the tracking resolution. Each output pixel
+// is computed once from the source pixels, instead of chaining cvtColor, resize and convertTo
+// over full images. The outputs must be allocated by the caller with the target size.
+class ImagePreprocessing
+{
+public:
+
+    // Gray conversion (1, 3 or 4 channel 8-bit input) and downscale by a factor of 1 or 2.
+    // Same result as cvtColor followed by a bilinear resize, up to rounding.
+    // If pNormalized is not NULL, gray/255 is also written there (imGray.rows x imGray.cols floats).
+    // Returns false if the input is not supported, nothing is written then.
+    static bool ToGray(const cv::Mat &im, const bool bRGB, cv::Mat &imGray, float* pNormalized);
+
+    // Nearest neighbour resize of a 16-bit or float depth map and conversion to float scaled
+    // by depthFactor. Same result as resize(INTER_NEAREST) followed by convertTo.
+    // Returns false if the input is not supported, nothing is written then.
+    static bool ToDepth(const cv::Mat &imD, const float depthFactor, cv::Mat &imDepth);
+};
+
+} //namespace ORB_SLAM
+
+#endif // IMAGEPREPROCESSING_H
@@ -28,8 +28,13 @@
 #include "ORBextractor.h"
 #include "Frame.h"
 #include "KeyFrameDatabase.h"
+#include "LockProfiler.h"
+#include "FeatureGrid.h"
+#include "LevelTable.h"
+#include "KeyPointArray.h"
 
 #include <mutex>
+#include <Eigen/Core>
 
 
 namespace ORB_SLAM2
@@ -54,6 +59,12 @@ public:
     cv::Mat GetRotation();
     cv::Mat GetTranslation();
 
+    // Pose as fixed-size Eigen types, returned by value under the pose mutex (no allocation)
+    Eigen::Matrix3f GetRotationEigen();
+    Eigen::Vector3f GetTranslationEigen();
+    Eigen::Vector3f GetCameraCenterEigen();
+    void GetPoseEigen(Eigen::Matrix3f &Rcw, Eigen::Vector3f &tcw);
+
     // Bag of Words Representation
     void ComputeBoW();
 
@@ -92,6 +103,8 @@ public:
 
     // KeyPoint functions
     std::vector<size_t> GetFeaturesInArea(const float &x, const float  &y, const float  &r) const;
+    // Same search, the result is written into vIndices (a buffer reused by the caller)
+    void GetFeaturesInArea(const float &x, const float  &y, const float  &r, std::vector<size_t> &vIndices) const;
     cv::Mat UnprojectStereo(int i);
 
     // Image
@@ -162,6 +175,7 @@ public:
     // KeyPoints, stereo coordinate and descriptors (all associated by an index)
     const std::vector<cv::KeyPoint> mvKeys;
     const std::vector<cv::KeyPoint> mvKeysUn;
+    const KeyPointArray mKeysUnArray; // x, y, octave and angle of mvKeysUn
     const std::vector<float> mvuRight; // negative value for monocular points
     const std::vector<float> mvDepth; // negative value for monocular points
     const cv::Mat mDescriptors;
@@ -177,9 +191,9 @@ public:
     const int mnScaleLevels;
     const float mfScaleFactor;
     const float mfLogScaleFactor;
-    const std::vector<float> mvScaleFactors;
-    const std::vector<float> mvLevelSigma2;
-    const std::vector<float> mvInvLevelSigma2;
+    const LevelTable mvScaleFactors;
+    const LevelTable mvLevelSigma2;
+    const LevelTable mvInvLevelSigma2;
 
     // Image bounds and calibration
     const int mnMinX;
@@ -199,6 +213,11 @@ protected:
 
     cv::Mat Cw; // Stereo middel point. Only for visualization
 
+    // Eigen copies of the pose, updated with Tcw
+    Eigen::Matrix3f mRcwEigen;
+    Eigen::Vector3f mtcwEigen;
+    Eigen::Vector3f mOwEigen;
+
     // MapPoints associated to keypoints
     std::vector<MapPoint*> mvpMapPoints;
 
@@ -207,7 +226,7 @@ protected:
     ORBVocabulary* mpORBvocabulary;
 
     // Grid over the image to speed up feature matching
-    std::vector< std::vector <std::vector<size_t> > > mGrid;
+    const FeatureGrid mGrid;
 
     std::map<KeyFrame*,int> mConnectedKeyFrameWeights;
     std::vector<KeyFrame*> mvpOrderedConnectedKeyFrames;
@@ -228,9 +247,9 @@ protected:
 
     Map* mpMap;
 
-    std::mutex mMutexPose;
-    std::mutex mMutexConnections;
-    std::mutex mMutexFeatures;
+    KeyFramePoseMutex mMutexPose;
+    KeyFrameConnectionsMutex mMutexConnections;
+    KeyFrameFeaturesMutex mMutexFeatures;
 };
 
 } //namespace ORB_SLAM
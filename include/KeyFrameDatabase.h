@@ -28,6 +28,7 @@
 #include "KeyFrame.h"
 #include "Frame.h"
 #include "ORBVocabulary.h"
+#include "LockProfiler.h"
 
 #include<mutex>
 
@@ -66,7 +67,7 @@ protected:
   std::vector<list<KeyFrame*> > mvInvertedFile;
 
   // Mutex
-  std::mutex mMutex;
+  KeyFrameDatabaseMutex mMutex;
 };
 
 } //namespace ORB_SLAM
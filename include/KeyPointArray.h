@@ -0,0 +1,97 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KEYPOINTARRAY_H
+#define KEYPOINTARRAY_H
+
+#include <vector>
+#include <cstddef>
+
+#include <opencv2/core/core.hpp>
+
+#include "FrameArena.h"
+
+namespace ORB_SLAM2
+{
+
+// Structure of arrays copy of the fields of the undistorted keypoints read by the matching and
+// optimization loops (x, y, octave and angle). A cv::KeyPoint is 28 bytes, so a loop over the
+// coordinates of a vector of keypoints loads 4 times more memory than it uses, while here each
+// field is contiguous. The cv::KeyPoint vectors are kept for the rest of the code (drawers,
+// initializer, stereo matching). Arrays are taken from the FrameArena as the frame buffers.
+class KeyPointArray
+{
+public:
+
+    KeyPointArray();
+    KeyPointArray(const KeyPointArray &keys);
+    KeyPointArray& operator=(const KeyPointArray &keys) = default;
+    ~KeyPointArray();
+
+    // Copy the fields of the keypoints (octaves must fit in 8 bits)
+    void Assign(const std::vector<cv::KeyPoint> &vKeys);
+
+    size_t size() const{
+        return mvX.size();
+    }
+
+    bool empty() const{
+        return mvX.empty();
+    }
+
+    const float& X(const size_t i) const{
+        return mvX[i];
+    }
+
+    const float& Y(const size_t i) const{
+        return mvY[i];
+    }
+
+    int Octave(const size_t i) const{
+        return mvOctave[i];
+    }
+
+    const float& Angle(const size_t i) const{
+        return mvAngle[i];
+    }
+
+    const float* XData() const{
+        return mvX.data();
+    }
+
+    const float* YData() const{
+        return mvY.data();
+    }
+
+    const unsigned char* OctaveData() const{
+        return mvOctave.data();
+    }
+
+protected:
+
+    std::vector<float> mvX;
+    std::vector<float> mvY;
+    std::vector<unsigned char> mvOctave;
+    std::vector<float> mvAngle;
+};
+
+} //namespace ORB_SLAM
+
+#endif // KEYPOINTARRAY_H
@@ -0,0 +1,57 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LEVELTABLE_H
+#define LEVELTABLE_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace ORB_SLAM2
+{
+
+// Read-only values per pyramid level (scale factors, sigmas). The extractor builds each table
+// once and its frames and keyframes share it, so copying a table does not allocate.
+class LevelTable
+{
+public:
+
+    LevelTable(){}
+
+    explicit LevelTable(const std::vector<float> &vValues):
+        mpValues(std::make_shared<std::vector<float> >(vValues)){}
+
+    const float& operator[](const size_t i) const{
+        return (*mpValues)[i];
+    }
+
+    size_t size() const{
+        return mpValues ? mpValues->size() : 0;
+    }
+
+protected:
+
+    std::shared_ptr<const std::vector<float> > mpValues;
+};
+
+} //namespace ORB_SLAM
+
+#endif // LEVELTABLE_H
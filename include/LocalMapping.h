@@ -85,8 +85,6 @@ protected:
 
     cv::Mat ComputeF12(KeyFrame* &pKF1, KeyFrame* &pKF2);
 
-    cv::Mat SkewSymmetricMatrix(const cv::Mat &v);
-
     bool mbMonocular;
 
     void ResetIfRequested();
@@ -0,0 +1,129 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOCKPROFILER_H
+#define LOCKPROFILER_H
+
+#include <mutex>
+#include <chrono>
+
+namespace ORB_SLAM2
+{
+
+// Contention of the map mutexes. Built with LOCK_PROFILING (cmake -DLOCK_PROFILING=ON) the
+// mutexes below are ProfiledMutex, which count the acquisitions of each named lock, the
+// acquisitions that had to wait, the total and max wait and hold times, and System::Shutdown
+// prints a report sorted by total wait. Otherwise they are plain std::mutex.
+class LockProfiler
+{
+public:
+
+    enum Lock
+    {
+        MAP_UPDATE=0,
+        MAPPOINT_GLOBAL,
+        KEYFRAME_CONNECTIONS,
+        KEYFRAME_FEATURES,
+        KEYFRAME_POSE,
+        KEYFRAME_DATABASE,
+        NUM_LOCKS
+    };
+
+    // One acquisition of lock, with the time waited for it and held (ns)
+    static void Record(const Lock lock, const long long wait, const long long hold, const bool bContended);
+
+    // Print the contention report. Does nothing without LOCK_PROFILING.
+    static void PrintReport();
+
+    static const char* GetLockName(const Lock lock);
+};
+
+#ifdef LOCK_PROFILING
+
+// Mutex that measures how long it is waited for and held (for std::unique_lock and std::lock_guard).
+// The timestamps are written only by the thread that holds the mutex.
+template<LockProfiler::Lock L>
+class ProfiledMutex
+{
+public:
+
+    ProfiledMutex(): mnWait(0), mbContended(false) {}
+
+    void lock()
+    {
+        if(mMutex.try_lock())
+        {
+            mAcquired = std::chrono::steady_clock::now();
+            mnWait = 0;
+            mbContended = false;
+            return;
+        }
+
+        const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        mMutex.lock();
+        mAcquired = std::chrono::steady_clock::now();
+        mnWait = std::chrono::duration_cast<std::chrono::nanoseconds>(mAcquired-t1).count();
+        mbContended = true;
+    }
+
+    bool try_lock()
+    {
+        if(!mMutex.try_lock())
+            return false;
+        mAcquired = std::chrono::steady_clock::now();
+        mnWait = 0;
+        mbContended = false;
+        return true;
+    }
+
+    void unlock()
+    {
+        const long long hold = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-mAcquired).count();
+        LockProfiler::Record(L,mnWait,hold,mbContended);
+        mMutex.unlock();
+    }
+
+private:
+    ProfiledMutex(const ProfiledMutex&);
+    ProfiledMutex& operator=(const ProfiledMutex&);
+
+    std::mutex mMutex;
+    std::chrono::steady_clock::time_point mAcquired;
+    long long mnWait;
+    bool mbContended;
+};
+
+#else
+
+template<LockProfiler::Lock L>
+using ProfiledMutex = std::mutex;
+
+#endif
+
+typedef ProfiledMutex<LockProfiler::MAP_UPDATE> MapUpdateMutex;
+typedef ProfiledMutex<LockProfiler::MAPPOINT_GLOBAL> MapPointGlobalMutex;
+typedef ProfiledMutex<LockProfiler::KEYFRAME_CONNECTIONS> KeyFrameConnectionsMutex;
+typedef ProfiledMutex<LockProfiler::KEYFRAME_FEATURES> KeyFrameFeaturesMutex;
+typedef ProfiledMutex<LockProfiler::KEYFRAME_POSE> KeyFramePoseMutex;
+typedef ProfiledMutex<LockProfiler::KEYFRAME_DATABASE> KeyFrameDatabaseMutex;
+
+} //namespace ORB_SLAM
+
+#endif // LOCKPROFILER_H
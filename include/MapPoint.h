@@ -24,9 +24,12 @@
 #include"KeyFrame.h"
 #include"Frame.h"
 #include"Map.h"
+#include"LockProfiler.h"
 
 #include<opencv2/core/core.hpp>
+#include<Eigen/Core>
 #include<mutex>
+#include<atomic>
 
 namespace ORB_SLAM2
 {
@@ -46,6 +49,10 @@ public:
     cv::Mat GetWorldPos();
 
     cv::Mat GetNormal();
+
+    // Same as GetWorldPos and GetNormal, without allocating a cv::Mat (for the tracking loops)
+    Eigen::Vector3f GetWorldPosEigen();
+    Eigen::Vector3f GetNormalEigen();
     KeyFrame* GetReferenceKeyFrame();
 
     std::map<KeyFrame*,size_t> GetObservations();
@@ -74,8 +81,26 @@ public:
 
     cv::Mat GetDescriptor();
 
+    // Copy the descriptor (32 bytes) without allocating. Returns its version, or -1 if the
+    // descriptor is not computed yet.
+    int CopyDescriptor(unsigned char* pDescriptor);
+
+    // Incremented every time the descriptor changes. Can be read without locking.
+    inline int GetDescriptorVersion(){
+        return mnDescriptorVersion;
+    }
+
     void UpdateNormalAndDepth();
 
+    // Copy position, normal and the min/max distances of the point, read together. The distances
+    // are not scaled (see GetMinDistanceInvariance/GetMaxDistanceInvariance). Returns the position version.
+    int CopyGeometry(Eigen::Vector3f &Pos, Eigen::Vector3f &Normal, float &minDistance, float &maxDistance);
+
+    // Incremented every time the position, normal or distances change. Can be read without locking.
+    inline int GetPositionVersion(){
+        return mnPositionVersion;
+    }
+
     float GetMinDistanceInvariance();
     float GetMaxDistanceInvariance();
     int PredictScale(const float &currentDist, KeyFrame*pKF);
@@ -97,6 +122,8 @@ public:
     float mTrackViewCos;
     long unsigned int mnTrackReferenceForFrame;
     long unsigned int mnLastFrameSeen;
+    int mnTrackDescriptorRow;
+    int mnTrackFrustumRow;
 
     // Variables used by local mapping
     long unsigned int mnBALocalForKF;
@@ -110,21 +137,23 @@ public:
     long unsigned int mnBAGlobalForKF;
 
 
-    static std::mutex mGlobalMutex;
+    static MapPointGlobalMutex mGlobalMutex;
 
 protected:    
 
      // Position in absolute coordinates
-     cv::Mat mWorldPos;
+     Eigen::Vector3f mWorldPos;
+     std::atomic<int> mnPositionVersion;
 
      // Keyframes observing the point and associated index in keyframe
      std::map<KeyFrame*,size_t> mObservations;
 
      // Mean viewing direction
-     cv::Mat mNormalVector;
+     Eigen::Vector3f mNormalVector;
 
      // Best descriptor to fast matching
      cv::Mat mDescriptor;
+     std::atomic<int> mnDescriptorVersion;
 
      // Reference KeyFrame
      KeyFrame* mpRefKF;
@@ -0,0 +1,75 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPOINTDESCRIPTORS_H
+#define MAPPOINTDESCRIPTORS_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+class MapPoint;
+
+// Contiguous, 32 byte aligned table with the descriptors of a list of map points (row i belongs
+// to the i-th point). Used by the Tracking for the local map. On Update, rows of points that
+// were already in the previous list and whose descriptor did not change are copied from the
+// previous table. Only new or changed points are read, under their mutex.
+class MapPointDescriptors
+{
+public:
+
+    MapPointDescriptors();
+
+    void Update(const std::vector<MapPoint*> &vpMapPoints);
+
+    void Clear();
+
+    // Rows x 32 CV_8U, wrapping the table memory. Rows of points without descriptor are zero.
+    const cv::Mat& GetDescriptors() const {
+        return mDescriptors;
+    }
+
+    // Rows read from the map points in the last Update
+    int GetRefreshed() const {
+        return mnRefreshed;
+    }
+
+protected:
+
+    void Reserve(const int n);
+
+    // Current and previous tables, swapped on each Update
+    std::vector<unsigned char> mvBuffer[2];
+    unsigned char* mpTable[2];
+    std::vector<MapPoint*> mvpMapPoints[2];
+    std::vector<int> mvVersions[2];
+    int mnCurrent;
+    int mnCapacity;
+
+    cv::Mat mDescriptors;
+    int mnRefreshed;
+};
+
+} //namespace ORB_SLAM
+
+#endif // MAPPOINTDESCRIPTORS_H
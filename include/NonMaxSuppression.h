@@ -0,0 +1,96 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NONMAXSUPPRESSION_H
+#define NONMAXSUPPRESSION_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+// Grid non-maximum suppression of the GCN detections.
+// Detections are visited by decreasing confidence (ties by index) and a detection is kept
+// if no kept detection lies within dist_thresh pixels (Chebyshev distance). Kept detections
+// are stored in a coarse grid with cells of dist_thresh pixels, which can hold at most one
+// kept detection each, so only the 3x3 neighbouring cells are checked. Scratch buffers are
+// persistent and only the touched cells are cleared, so no full image is ever scanned.
+class NonMaxSuppression
+{
+public:
+
+    NonMaxSuppression(int width, int height, int distThresh, int border);
+
+    // det: Nx3 float (u, v, confidence) in network pixels. desc: Nx32 uchar.
+    // Keypoints are scaled by the given ratios to image coordinates, sorted by decreasing
+    // confidence and the confidence is stored in the response.
+    void operator()(const cv::Mat &det, const cv::Mat &desc, std::vector<cv::KeyPoint> &keypoints,
+                    cv::OutputArray descriptors, float ratioWidth=1.0f, float ratioHeight=1.0f);
+
+    // Core suppression on a raw detection array (row i at pDet+i*step). Fills vKept with the
+    // indices of the surviving detections inside the border, sorted by decreasing confidence.
+    void Suppress(const float* pDet, const int N, const size_t step, std::vector<int> &vKept);
+
+    // Cap the number of returned detections (0 disables the cap). The image is divided in
+    // nCols x nRows cells that first receive an even share of the budget, taken by confidence.
+    // The remaining budget goes to the strongest detections left.
+    void SetMaxFeatures(int nMaxFeatures, int nCols, int nRows);
+
+    int inline GetWidth(){
+        return mnWidth;}
+
+    int inline GetHeight(){
+        return mnHeight;}
+
+protected:
+
+    void DistributeBudget(const float* pDet, const size_t step, std::vector<int> &vKept);
+
+    int mnWidth;
+    int mnHeight;
+    int mnDistThresh;
+    int mnBorder;
+
+    int mnCellSize;
+    int mnCellCols;
+    int mnCellRows;
+
+    // Kept detection index per cell (-1 if empty) and cells to clear after each call
+    std::vector<int> mvCells;
+    std::vector<int> mvTouchedCells;
+
+    std::vector<std::pair<float,int> > mvOrder;
+    std::vector<int> mvKept;
+
+    // Feature budget
+    int mnMaxFeatures;
+    int mnBudgetCols;
+    int mnBudgetRows;
+    std::vector<int> mvBudgetCount;
+    std::vector<unsigned char> mvbSelected;
+};
+
+} //namespace ORB_SLAM
+
+#endif // NONMAXSUPPRESSION_H
@@ -25,6 +25,8 @@
 #include <list>
 #include <opencv/cv.h>
 
+#include "LevelTable.h"
+
 
 namespace ORB_SLAM2
 {
@@ -66,20 +68,20 @@ public:
     float inline GetScaleFactor(){
         return scaleFactor;}
 
-    std::vector<float> inline GetScaleFactors(){
-        return mvScaleFactor;
+    LevelTable inline GetScaleFactors(){
+        return mScaleFactorTable;
     }
 
-    std::vector<float> inline GetInverseScaleFactors(){
-        return mvInvScaleFactor;
+    LevelTable inline GetInverseScaleFactors(){
+        return mInvScaleFactorTable;
     }
 
-    std::vector<float> inline GetScaleSigmaSquares(){
-        return mvLevelSigma2;
+    LevelTable inline GetScaleSigmaSquares(){
+        return mLevelSigma2Table;
     }
 
-    std::vector<float> inline GetInverseScaleSigmaSquares(){
-        return mvInvLevelSigma2;
+    LevelTable inline GetInverseScaleSigmaSquares(){
+        return mInvLevelSigma2Table;
     }
 
     std::vector<cv::Mat> mvImagePyramid;
@@ -108,6 +110,12 @@ protected:
     std::vector<float> mvInvScaleFactor;    
     std::vector<float> mvLevelSigma2;
     std::vector<float> mvInvLevelSigma2;
+
+    // Tables shared with the frames
+    LevelTable mScaleFactorTable;
+    LevelTable mInvScaleFactorTable;
+    LevelTable mLevelSigma2Table;
+    LevelTable mInvLevelSigma2Table;
 };
 
 } //namespace ORB_SLAM
@@ -29,6 +29,7 @@
 #include"MapPoint.h"
 #include"KeyFrame.h"
 #include"Frame.h"
+#include"FrustumCuller.h"
 
 
 namespace ORB_SLAM2
@@ -47,6 +48,19 @@ public:
     // Used to track the local map (Tracking)
     int SearchByProjection(Frame &F, const std::vector<MapPoint*> &vpMapPoints, const float th=3);
 
+    // Same as above with the ratio test optional. If bAllLevels, candidates are taken from all
+    // scale levels (GCN keypoints are all extracted at level 0), otherwise from the predicted
+    // level and the one below. The window grows with the scale of the predicted level.
+    // Row i of MPdescriptorTable is the descriptor of vpMapPoints[i].
+    int SearchByProjectionAllLevels(Frame &F, const std::vector<MapPoint*> &vpMapPoints, const cv::Mat &MPdescriptorTable,
+                                    const float th, const bool bRatioTest, const bool bAllLevels);
+
+    // Same as above, but only the candidates of FrustumCuller::Cull are searched, with their
+    // projection (the tracking variables of the points are not read).
+    int SearchByProjectionAllLevels(Frame &F, const std::vector<MapPoint*> &vpMapPoints, const std::vector<FrustumCandidate> &vCandidates,
+                                    const cv::Mat &MPdescriptorTable, const float th, const bool bRatioTest,
+                                    const bool bAllLevels);
+
     // Project MapPoints tracked in last frame into the current frame and search matches.
     // Used to track from previous frame (Tracking)
     int SearchByProjection(Frame &CurrentFrame, const Frame &LastFrame, const float th, const bool bMono);
@@ -65,9 +79,16 @@ public:
     int SearchByBoW(KeyFrame *pKF, Frame &F, std::vector<MapPoint*> &vpMapPointMatches);
     int SearchByBoW(KeyFrame *pKF1, KeyFrame* pKF2, std::vector<MapPoint*> &vpMatches12);
 
-    int SearchByNN(KeyFrame *pKF, Frame &F, std::vector<MapPoint*> &vpMapPointMatches);
-    int SearchByNN(Frame &CurrentFrame, const Frame &LastFrame);
-    int SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints);
+    // Search matches by descriptor only (mutual nearest neighbours, brute force).
+    // If bRatioTest, the best match must also be below mfNNratio times the second best.
+    int SearchByNN(KeyFrame *pKF, Frame &F, std::vector<MapPoint*> &vpMapPointMatches, const bool bRatioTest=false);
+    int SearchByNN(Frame &CurrentFrame, const Frame &LastFrame, const bool bRatioTest=false);
+    int SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints, const bool bRatioTest=false);
+    // Row i of MPdescriptorTable is the descriptor of vpMapPoints[i] (see MapPointDescriptors).
+    int SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints, const cv::Mat &MPdescriptorTable, const bool bRatioTest=false);
+    // Only the points of the candidates of FrustumCuller::Cull are matched.
+    int SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints, const std::vector<FrustumCandidate> &vCandidates,
+                   const cv::Mat &MPdescriptorTable, const bool bRatioTest=false);
 
     // Matching for the Map Initialization (only used in the monocular case)
     int SearchForInitialization(Frame &F1, Frame &F2, std::vector<cv::Point2f> &vbPrevMatched, std::vector<int> &vnMatches12, int windowSize=10);
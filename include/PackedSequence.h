@@ -0,0 +1,122 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PACKEDSEQUENCE_H
+#define PACKEDSEQUENCE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+// RGB-D sequence packed in a single file: for each frame a gray image (8 bit) and a depth map
+// (16 bit, raw sensor units) stored uncompressed, and an index of timestamps. Readers map the
+// file and get cv::Mat views of the frames, with no decoding, copy or allocation per frame.
+//
+// File layout (little endian): a header {"RGBS", version, width, height (int32), number of
+// frames, offset of the index (int64)}, the frames, each one the gray image followed by the
+// depth map and padded to 64 bytes, and at the end the index with one entry {timestamp
+// (float64), offset of the frame (int64)} per frame.
+class PackedSequence
+{
+public:
+
+    PackedSequence();
+    ~PackedSequence();
+
+    // True if the file starts with the packed sequence signature.
+    static bool IsPackedSequence(const std::string &strFile);
+
+    // Map a packed sequence. Returns false if the file is missing or not a valid sequence.
+    bool Open(const std::string &strFile);
+
+    // Start writing a packed sequence of width x height frames. The index is written by Close.
+    bool Create(const std::string &strFile, int width, int height);
+
+    // Append a frame: gray CV_8UC1 and depth CV_16UC1 of the sequence size.
+    bool Add(const double &timestamp, const cv::Mat &imGray, const cv::Mat &imDepth);
+
+    // Finish writing (or unmap) the file.
+    void Close();
+
+    int GetFrames(){
+        return mnFrames;
+    }
+
+    int GetWidth(){
+        return mnWidth;
+    }
+
+    int GetHeight(){
+        return mnHeight;
+    }
+
+    double GetTimestamp(const int i){
+        return mpIndex[i].timestamp;
+    }
+
+    // Views of frame i, valid until Close. Pages are mapped copy-on-write, so writing to the
+    // views never modifies the file.
+    void GetFrame(const int i, cv::Mat &imGray, cv::Mat &imDepth);
+
+protected:
+
+    struct Header
+    {
+        char signature[4];
+        int32_t version;
+        int32_t width;
+        int32_t height;
+        int64_t nFrames;
+        int64_t indexOffset;
+    };
+
+    struct IndexEntry
+    {
+        double timestamp;
+        int64_t offset;
+    };
+
+    size_t FrameSize();
+
+    int mnWidth;
+    int mnHeight;
+    int mnFrames;
+
+    // Reading
+    unsigned char* mpData;
+    size_t mnSize;
+    const IndexEntry* mpIndex;
+
+    // Writing
+    std::ofstream mFile;
+    std::vector<IndexEntry> mvIndex;
+    int64_t mnOffset;
+    std::vector<unsigned char> mvPadding;
+};
+
+} //namespace ORB_SLAM
+
+#endif // PACKEDSEQUENCE_H
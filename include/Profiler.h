@@ -0,0 +1,122 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "Tracer.h"
+
+namespace ORB_SLAM2
+{
+
+// Timings of the stages of the tracking, local mapping and loop closing threads.
+// Enabled by the PROFILE environment variable, whose value is the prefix of the files written at
+// System::Shutdown (<prefix>.json and <prefix>.csv). When disabled a ScopedTimer only checks a
+// flag and reads no clock.
+//
+// Each thread records into its own log-linear histograms (64 sub-buckets per power of two, so
+// percentiles are within 1.6% of the measured time, up to 2^40 ns), which are written only by
+// that thread and need no lock. Histograms of threads with the same name are merged on export.
+// With TRACE set, every stage is also a span of the Tracer timeline.
+class Profiler
+{
+public:
+
+    enum Stage
+    {
+        // Tracking
+        FRAME=0,
+        COMPUTE_BOW,
+        TRACK,
+        TRACK_REFERENCE_KEYFRAME,
+        TRACK_MOTION_MODEL,
+        TRACK_LOCAL_MAP,
+        RELOCALIZATION,
+        CREATE_NEW_KEYFRAME,
+        // Local mapping
+        PROCESS_NEW_KEYFRAME,
+        MAPPOINT_CULLING,
+        CREATE_NEW_MAPPOINTS,
+        SEARCH_IN_NEIGHBORS,
+        LOCAL_BA,
+        KEYFRAME_CULLING,
+        // Loop closing
+        DETECT_LOOP,
+        COMPUTE_SIM3,
+        CORRECT_LOOP,
+        SEARCH_AND_FUSE,
+        GLOBAL_BA,
+        NUM_STAGES
+    };
+
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(const Stage stage): mStage(stage), mbRunning(mbEnabled || Tracer::IsEnabled())
+        {
+            if(mbRunning)
+                mStart = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTimer()
+        {
+            if(!mbRunning)
+                return;
+
+            const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            if(mbEnabled)
+                Record(mStage,std::chrono::duration_cast<std::chrono::nanoseconds>(end-mStart).count());
+            Tracer::Complete(GetStageName(mStage),"stage",mStart,end);
+        }
+
+    private:
+        const Stage mStage;
+        const bool mbRunning;
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+    static bool IsEnabled(){
+        return mbEnabled;
+    }
+
+    // Name under which the timings and trace events of the calling thread are exported (a string literal)
+    static void SetThreadName(const char* name);
+
+    // Add a duration (ns) to the histogram of the calling thread
+    static void Record(const Stage stage, const long long ns);
+
+    // Write <prefix>.json (statistics and histograms) and <prefix>.csv (statistics).
+    // Does nothing if profiling is disabled.
+    static void Save();
+
+    static const char* GetStageName(const Stage stage);
+
+protected:
+
+    static const bool mbEnabled;
+};
+
+} //namespace ORB_SLAM
+
+#endif // PROFILER_H
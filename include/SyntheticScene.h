@@ -0,0 +1,119 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYNTHETICSCENE_H
+#define SYNTHETICSCENE_H
+
+#include <vector>
+#include <string>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM2
+{
+
+// Deterministic synthetic RGB-D sequence for end-to-end performance tests without datasets or a
+// network. The world is the inner wall of a cylinder covered with points, each one with a stable
+// random 32 byte descriptor and detector response. The camera moves on a circle inside it looking
+// at the wall, with some vertical motion and yaw, for a number of laps, so every lap after the
+// first closes a loop. Each frame keeps the strongest visible points (ORBextractor.nFeatures), as
+// a detector would, and their keypoints, depth and descriptors get sensor noise.
+//
+// Parameters are read from the settings file: Camera.* as for the tracking and Synthetic.* for
+// the scene (see GCN2/Synthetic.yaml). The number of points grows with the wall area and
+// Synthetic.pointDensity, the number of frames with Synthetic.laps and Synthetic.framesPerLap.
+class SyntheticScene
+{
+public:
+
+    SyntheticScene(const std::string &strSettingsFile);
+
+    int GetFrames(){
+        return mnFrames;
+    }
+
+    int GetPoints(){
+        return mvPoints.size();
+    }
+
+    cv::Size GetImageSize(){
+        return cv::Size(mnWidth,mnHeight);
+    }
+
+    float GetFps(){
+        return mFps;
+    }
+
+    double GetTimestamp(const int i){
+        return i/mFps;
+    }
+
+    // Ground truth camera to world transformation of frame i (4x4 float)
+    cv::Mat GetPose(const int i);
+
+    // Keypoints (level 0, sorted by decreasing response), descriptors (N x 32 CV_8U) and depth
+    // of frame i. The same frame always gives the same features.
+    void GetFrame(const int i, std::vector<cv::KeyPoint> &vKeys, cv::Mat &descriptors, std::vector<float> &vDepth);
+
+protected:
+
+    struct Point
+    {
+        float x;
+        float y;
+        float z;
+        float response;
+    };
+
+    // Camera center and rotation of frame i
+    void GetCamera(const int i, cv::Matx33f &Rwc, cv::Vec3f &twc);
+
+    // Camera
+    float fx, fy, cx, cy;
+    int mnWidth;
+    int mnHeight;
+    float mFps;
+    int mnFeatures;
+
+    // Scene
+    int mnSeed;
+    float mRadius;
+    float mWallRadius;
+    float mWallHeight;
+    float mWallDepth;
+    int mnFrames;
+    int mnFramesPerLap;
+    float mBobbing;
+    float mYaw;
+
+    // Noise
+    float mPixelNoise;
+    float mDepthNoise;
+    int mnDescriptorNoise;
+
+    // Points sorted by azimuth, their azimuth and descriptors (32 bytes per point)
+    std::vector<Point> mvPoints;
+    std::vector<float> mvAzimuth;
+    std::vector<unsigned char> mvDescriptors;
+};
+
+} //namespace ORB_SLAM
+
+#endif // SYNTHETICSCENE_H
@@ -36,6 +36,8 @@
 #include "KeyFrameDatabase.h"
 #include "ORBVocabulary.h"
 #include "Viewer.h"
+#include "FeatureExtraction.h"
+#include "FeatureCache.h"
 
 namespace ORB_SLAM2
 {
@@ -46,6 +48,8 @@ class Map;
 class Tracking;
 class LocalMapping;
 class LoopClosing;
+class FeatureExtraction;
+class GCNInferenceService;
 
 class System
 {
@@ -60,7 +64,10 @@ public:
 public:
 
     // Initialize the SLAM system. It launches the Local Mapping, Loop Closing and Viewer threads.
-    System(const string &strVocFile, const string &strSettingsFile, const eSensor sensor, const bool bUseViewer = true);
+    // Several systems (one per camera stream) can share a GCN inference service, which then
+    // batches their feature extraction.
+    System(const string &strVocFile, const string &strSettingsFile, const eSensor sensor, const bool bUseViewer = true,
+           GCNInferenceService* pGCNService = NULL);
 
     // Proccess the given stereo frame. Images must be synchronized and rectified.
     // Input images: RGB (CV_8UC3) or grayscale (CV_8U). RGB is converted to grayscale.
@@ -71,10 +78,23 @@ public:
     // Input image: RGB (CV_8UC3) or grayscale (CV_8U). RGB is converted to grayscale.
     // Input depthmap: Float (CV_32F).
     // Returns the camera pose (empty if tracking fails).
+    // If Extraction.queueSize>0 in the settings, features are extracted in a separate thread ahead
+    // of the tracking and the returned pose is the one of the frame queueSize calls earlier.
     cv::Mat TrackRGBD(const cv::Mat &im, const cv::Mat &depthmap, const double &timestamp);
 
-    // Process rgbd frame with given features
-    cv::Mat TrackRGBD(const cv::Mat &im, const cv::Mat &depthmap, const cv::Mat &featmap, const double &timestamp);
+    // RGB-D with GCN only: read the features of each frame from strFile (by timestamp) instead of
+    // running the network, if strFile is a cache written with the same extraction settings.
+    // Otherwise the features extracted in this run are written to strFile at Shutdown.
+    // Call before the first frame. Returns false if the cache cannot be used.
+    bool SetFeatureCache(const string &strFile);
+
+    // Process a rgbd frame given by its features instead of images (synthetic scenes): keypoints,
+    // one descriptor row per keypoint, the depth of each keypoint (<=0 if unknown) and the size
+    // of the image they belong to. Run with USE_ORB, no network is loaded then. The inputs are
+    // copied, so the caller can reuse its buffers for the next frame.
+    // Returns the camera pose (empty if tracking fails).
+    cv::Mat TrackRGBD(const std::vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, const std::vector<float> &vDepth,
+                      const cv::Size &imageSize, const double &timestamp);
 
     // Proccess the given monocular frame
     // Input images: RGB (CV_8UC3) or grayscale (CV_8U). RGB is converted to grayscale.
@@ -94,6 +114,7 @@ public:
     void Reset();
 
     // All threads will be requested to finish.
+    // Frames still in the feature extraction queue are tracked first.
     // It waits until all threads have finished.
     // This function must be called before saving the trajectory.
     void Shutdown();
@@ -126,6 +147,10 @@ public:
     std::vector<MapPoint*> GetTrackedMapPoints();
     std::vector<cv::KeyPoint> GetTrackedKeyPointsUn();
 
+    // Size of the map
+    long unsigned int KeyFramesInMap();
+    long unsigned int MapPointsInMap();
+
 private:
 
     // Input sensor
@@ -155,14 +180,21 @@ private:
     // The viewer draws the map and the current camera pose. It uses Pangolin.
     Viewer* mpViewer;
 
+    // Feature Extraction. Optional (RGB-D only), extracts features of the next frames while tracking.
+    FeatureExtraction* mpFeatureExtraction;
+
+    // Feature cache. Optional (RGB-D with GCN only).
+    FeatureCache* mpFeatureCache;
+
     FrameDrawer* mpFrameDrawer;
     MapDrawer* mpMapDrawer;
 
-    // System threads: Local Mapping, Loop Closing, Viewer.
+    // System threads: Local Mapping, Loop Closing, Viewer and optionally Feature Extraction.
     // The Tracking thread "lives" in the main execution thread that creates the System object.
     std::thread* mptLocalMapping;
     std::thread* mptLoopClosing;
     std::thread* mptViewer;
+    std::thread* mptFeatureExtraction;
 
     // Reset flag
     std::mutex mMutexReset;
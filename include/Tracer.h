@@ -0,0 +1,106 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <chrono>
+#include <mutex>
+
+namespace ORB_SLAM2
+{
+
+// Timeline of the threads in Chrome trace_event format (chrome://tracing, Perfetto).
+// Enabled by the TRACE environment variable, whose value is the file written at
+// System::Shutdown (Trace.json if empty). Records the Profiler stages, the waits for mutexes
+// that were already held, the polling waits between threads and the depth of the keyframe
+// queues. Each thread writes its own ring buffer of the last EVENTS_PER_THREAD events without
+// locks. The buffers are read at shutdown, once the threads are idle.
+class Tracer
+{
+public:
+
+    static const int EVENTS_PER_THREAD = 1<<16;
+
+    // Span from construction to destruction on the calling thread
+    class ScopedSpan
+    {
+    public:
+        ScopedSpan(const char* name, const char* category): mName(name), mCategory(category), mbRunning(mbEnabled)
+        {
+            if(mbRunning)
+                mStart = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedSpan()
+        {
+            if(mbRunning)
+                Complete(mName,mCategory,mStart,std::chrono::steady_clock::now());
+        }
+
+    private:
+        const char* mName;
+        const char* mCategory;
+        const bool mbRunning;
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+    static bool IsEnabled(){
+        return mbEnabled;
+    }
+
+    // Name of the calling thread in the timeline (a string literal)
+    static void SetThreadName(const char* name);
+
+    // Span that started at start and ended at end on the calling thread. Names are string literals.
+    static void Complete(const char* name, const char* category, const std::chrono::steady_clock::time_point &start,
+                         const std::chrono::steady_clock::time_point &end);
+
+    // Value of a counter (queue depth) at this time
+    static void Counter(const char* name, const long long value);
+
+    // Locks the mutex. If it is held by another thread the wait is recorded as a span.
+    template<class Mutex>
+    static std::unique_lock<Mutex> Lock(Mutex &m, const char* name)
+    {
+        if(!mbEnabled)
+            return std::unique_lock<Mutex>(m);
+
+        std::unique_lock<Mutex> lock(m,std::try_to_lock);
+        if(!lock.owns_lock())
+        {
+            const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            lock.lock();
+            Complete(name,"wait",t1,std::chrono::steady_clock::now());
+        }
+        return lock;
+    }
+
+    // Write the events of all threads. Does nothing if tracing is disabled.
+    static void Save();
+
+protected:
+
+    static const bool mbEnabled;
+};
+
+} //namespace ORB_SLAM
+
+#endif // TRACER_H
@@ -37,6 +37,10 @@
 #include "Initializer.h"
 #include "MapDrawer.h"
 #include "System.h"
+#include "FeatureExtraction.h"
+#include "FeatureCache.h"
+#include "MapPointDescriptors.h"
+#include "FrustumCuller.h"
 
 #include <mutex>
 
@@ -49,22 +53,40 @@ class Map;
 class LocalMapping;
 class LoopClosing;
 class System;
+class FeatureExtraction;
 
 class Tracking
 {  
 
 public:
     Tracking(System* pSys, ORBVocabulary* pVoc, FrameDrawer* pFrameDrawer, MapDrawer* pMapDrawer, Map* pMap,
-             KeyFrameDatabase* pKFDB, const string &strSettingPath, const int sensor);
+             KeyFrameDatabase* pKFDB, const string &strSettingPath, const int sensor,
+             GCNInferenceService* pGCNService = NULL);
 
     // Preprocess the input and call Track(). Extract features and performs stereo matching.
     cv::Mat GrabImageStereo(const cv::Mat &imRectLeft,const cv::Mat &imRectRight, const double &timestamp);
     cv::Mat GrabImageRGBD(const cv::Mat &imRGB,const cv::Mat &imD, const double &timestamp);
+    // RGB-D features given directly (see System::TrackRGBD). Needs the ORB extractor (USE_ORB),
+    // which provides the scale information.
+    cv::Mat GrabFeaturesRGBD(const std::vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, const std::vector<float> &vDepth,
+                             const cv::Size &imageSize, const double &timestamp);
     cv::Mat GrabImageMonocular(const cv::Mat &im, const double &timestamp);
 
     void SetLocalMapper(LocalMapping* pLocalMapper);
     void SetLoopClosing(LoopClosing* pLoopClosing);
     void SetViewer(Viewer* pViewer);
+    void SetFeatureExtraction(FeatureExtraction* pFeatureExtraction);
+
+    // Read the GCN features of the frames from strFile if it is a cache written with the same
+    // extraction settings, otherwise write the features extracted in this run to it.
+    bool SetFeatureCache(FeatureCache* pFeatureCache, const string &strFile);
+
+    // Preprocess a RGB-D image and build its Frame (feature extraction and depth association).
+    // It does not modify the tracking state and is also called from the FeatureExtraction thread.
+    Frame CreateFrameRGBD(const cv::Mat &imRGB, const cv::Mat &imD, const double &timestamp, cv::Mat &imGray);
+
+    // Track the oldest frame of the FeatureExtraction queue. Returns an empty pose if there is none.
+    cv::Mat TrackExtractedFrame();
 
     // Load new settings
     // The focal lenght should be similar or scale prediction will fail when projecting points
@@ -153,6 +175,10 @@ protected:
     //Other Thread Pointers
     LocalMapping* mpLocalMapper;
     LoopClosing* mpLoopClosing;
+    FeatureExtraction* mpFeatureExtraction;
+
+    // Feature cache (RGB-D with GCN only)
+    FeatureCache* mpFeatureCache;
 
     //ORB
     ORBextractor* mpORBextractorLeft, *mpORBextractorRight;
@@ -170,6 +196,9 @@ protected:
     KeyFrame* mpReferenceKF;
     std::vector<KeyFrame*> mvpLocalKeyFrames;
     std::vector<MapPoint*> mvpLocalMapPoints;
+    MapPointDescriptors mLocalMapDescriptors;
+    FrustumCuller mLocalMapCuller;
+    std::vector<FrustumCandidate> mvLocalMapCandidates;
     
     // System
     System* mpSystem;
@@ -217,6 +246,13 @@ protected:
     //Color order (true RGB, false BGR, ignored if grayscale)
     bool mbRGB;
 
+    //Apply the ratio test in the NN matching against the reference keyframe and local map
+    bool mbNNRatioTest;
+
+    //Match the local map in a window around the projection of each point, instead of NN
+    //against the whole frame. NN is still used when the projection finds too few matches.
+    bool mbLocalMapByProjection;
+
     list<MapPoint*> mlpTemporalPoints;
 };
 
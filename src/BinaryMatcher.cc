@@ -0,0 +1,185 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BinaryMatcher.h"
+#include "HammingDistance.h"
+
+#include <algorithm>
+#include <climits>
+#include <thread>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+// Train descriptors per tile (8KB)
+const int TILE_SIZE = 256;
+
+// Do not split smaller problems among threads, thread creation would dominate
+const int MIN_DISTANCES_PER_THREAD = 128*1024;
+
+int BinaryMatcher::snDefaultThreads = 1;
+
+BinaryMatcher::BinaryMatcher(int maxDistance, float ratio, int nThreads):
+    mnMaxDistance(maxDistance), mfRatio(ratio), mnThreads(nThreads>0 ? nThreads : snDefaultThreads)
+{
+}
+
+void BinaryMatcher::SetDefaultThreads(int nThreads)
+{
+    snDefaultThreads = max(nThreads,1);
+}
+
+void BinaryMatcher::MatchRange(const cv::Mat &query, const cv::Mat &train, const int i0, const int i1,
+                               int* pBestTrain, int* pBestDist, int* pSecondDist,
+                               int* pBestQuery, int* pBestQueryDist)
+{
+    const int nTrain = train.rows;
+
+    for(int i=i0; i<i1; i++)
+    {
+        pBestTrain[i] = -1;
+        pBestDist[i] = INT_MAX;
+        pSecondDist[i] = INT_MAX;
+    }
+    for(int j=0; j<nTrain; j++)
+    {
+        pBestQuery[j] = -1;
+        pBestQueryDist[j] = INT_MAX;
+    }
+
+    int vDist[TILE_SIZE];
+
+    for(int j0=0; j0<nTrain; j0+=TILE_SIZE)
+    {
+        const int nj = min(TILE_SIZE,nTrain-j0);
+        const unsigned char* pTrain = train.ptr<unsigned char>(j0);
+
+        for(int i=i0; i<i1; i++)
+        {
+            HammingDistance::Distance(query.ptr<unsigned char>(i),pTrain,nj,train.step,vDist);
+
+            int bestDist = pBestDist[i];
+            int secondDist = pSecondDist[i];
+            int bestTrain = pBestTrain[i];
+
+            // Strict comparisons keep the lowest index on ties, as cv::BFMatcher
+            for(int k=0; k<nj; k++)
+            {
+                const int dist = vDist[k];
+                if(dist<bestDist)
+                {
+                    secondDist = bestDist;
+                    bestDist = dist;
+                    bestTrain = j0+k;
+                }
+                else if(dist<secondDist)
+                    secondDist = dist;
+
+                if(dist<pBestQueryDist[j0+k])
+                {
+                    pBestQueryDist[j0+k] = dist;
+                    pBestQuery[j0+k] = i;
+                }
+            }
+
+            pBestDist[i] = bestDist;
+            pSecondDist[i] = secondDist;
+            pBestTrain[i] = bestTrain;
+        }
+    }
+}
+
+int BinaryMatcher::Match(const cv::Mat &query, const cv::Mat &train, vector<int> &vMatches)
+{
+    const int nQuery = query.rows;
+    const int nTrain = train.rows;
+
+    vMatches.assign(nQuery,-1);
+
+    if(nQuery==0 || nTrain==0)
+        return 0;
+
+    CV_Assert(query.type()==CV_8UC1 && train.type()==CV_8UC1 &&
+              query.cols==HammingDistance::DESCRIPTOR_SIZE && train.cols==HammingDistance::DESCRIPTOR_SIZE);
+
+    const int nThreads = max(1,min(mnThreads,(int)(((long)nQuery*nTrain)/MIN_DISTANCES_PER_THREAD)));
+    const int nThreadsUsed = min(nThreads,nQuery);
+
+    vector<int> vBestTrain(nQuery), vBestDist(nQuery), vSecondDist(nQuery);
+    vector<int> vBestQuery(nThreadsUsed*nTrain), vBestQueryDist(nThreadsUsed*nTrain);
+
+    if(nThreadsUsed==1)
+    {
+        MatchRange(query,train,0,nQuery,&vBestTrain[0],&vBestDist[0],&vSecondDist[0],&vBestQuery[0],&vBestQueryDist[0]);
+    }
+    else
+    {
+        vector<thread> vThreads;
+        vThreads.reserve(nThreadsUsed);
+        for(int t=0; t<nThreadsUsed; t++)
+        {
+            const int i0 = (long)nQuery*t/nThreadsUsed;
+            const int i1 = (long)nQuery*(t+1)/nThreadsUsed;
+            vThreads.push_back(thread(&BinaryMatcher::MatchRange,this,cref(query),cref(train),i0,i1,
+                                      &vBestTrain[0],&vBestDist[0],&vSecondDist[0],
+                                      &vBestQuery[t*nTrain],&vBestQueryDist[t*nTrain]));
+        }
+        for(int t=0; t<nThreadsUsed; t++)
+            vThreads[t].join();
+
+        // Merge in query order, so ties keep the lowest query index
+        for(int t=1; t<nThreadsUsed; t++)
+        {
+            const int* pQuery = &vBestQuery[t*nTrain];
+            const int* pDist = &vBestQueryDist[t*nTrain];
+            for(int j=0; j<nTrain; j++)
+            {
+                if(pDist[j]<vBestQueryDist[j])
+                {
+                    vBestQueryDist[j] = pDist[j];
+                    vBestQuery[j] = pQuery[j];
+                }
+            }
+        }
+    }
+
+    int nmatches = 0;
+    for(int i=0; i<nQuery; i++)
+    {
+        const int j = vBestTrain[i];
+        if(j<0 || vBestQuery[j]!=i)
+            continue;
+
+        if(vBestDist[i]>mnMaxDistance)
+            continue;
+
+        if(mfRatio>0 && vSecondDist[i]!=INT_MAX && (float)vBestDist[i]>=mfRatio*(float)vSecondDist[i])
+            continue;
+
+        vMatches[i] = j;
+        nmatches++;
+    }
+
+    return nmatches;
+}
+
+} //namespace ORB_SLAM
@@ -0,0 +1,257 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FeatureCache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+static const char CACHE_SIGNATURE[4] = {'G','C','N','F'};
+static const int32_t CACHE_VERSION = 1;
+static const int DESCRIPTOR_SIZE = 32;
+
+// Timestamps are read from the same association files, 1 us absorbs printing round trips
+static const double TIMESTAMP_TOLERANCE = 1e-6;
+
+FeatureCache::FeatureCache():
+    mnWidth(0), mnHeight(0), mnFeatures(0), mpData(static_cast<const unsigned char*>(NULL)), mnSize(0),
+    mpIndex(static_cast<const IndexEntry*>(NULL)), mnOffset(0), mnHits(0), mnMisses(0)
+{
+}
+
+FeatureCache::~FeatureCache()
+{
+    Close();
+}
+
+bool FeatureCache::Open(const string &strFile)
+{
+    Close();
+
+    const int fd = open(strFile.c_str(), O_RDONLY);
+    if(fd<0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd,&st)!=0 || (size_t)st.st_size<sizeof(Header))
+    {
+        close(fd);
+        return false;
+    }
+
+    void* pMap = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(pMap==MAP_FAILED)
+        return false;
+
+    mpData = static_cast<const unsigned char*>(pMap);
+    mnSize = st.st_size;
+
+    Header header;
+    memcpy(&header,mpData,sizeof(header));
+    if(memcmp(header.signature,CACHE_SIGNATURE,4)!=0 || header.version!=CACHE_VERSION ||
+       header.descriptorSize!=DESCRIPTOR_SIZE || header.nFrames<0 || header.indexOffset<(int64_t)sizeof(Header) ||
+       (size_t)header.indexOffset+header.nFrames*sizeof(IndexEntry)>mnSize)
+    {
+        cerr << "FeatureCache: " << strFile << " is not a complete feature cache" << endl;
+        Close();
+        return false;
+    }
+
+    mstrFile = strFile;
+    mnWidth = header.width;
+    mnHeight = header.height;
+    mnFeatures = header.nFeatures;
+    mpIndex = reinterpret_cast<const IndexEntry*>(mpData+header.indexOffset);
+
+    mvOrder.resize(header.nFrames);
+    for(int i=0; i<header.nFrames; i++)
+    {
+        const IndexEntry &entry = mpIndex[i];
+        if(entry.N<0 || entry.offset<(int64_t)sizeof(Header) ||
+           entry.offset+entry.N*(int64_t)(3*sizeof(float)+DESCRIPTOR_SIZE)>header.indexOffset)
+        {
+            cerr << "FeatureCache: corrupted frame " << i << " in " << strFile << endl;
+            Close();
+            return false;
+        }
+        mvOrder[i] = make_pair(entry.timestamp,i);
+    }
+    sort(mvOrder.begin(),mvOrder.end());
+
+    return true;
+}
+
+bool FeatureCache::Create(const string &strFile, int width, int height, int nFeatures)
+{
+    Close();
+
+    mFile.open(strFile.c_str(), ios::out | ios::binary | ios::trunc);
+    if(!mFile.is_open())
+    {
+        cerr << "FeatureCache: failed to create " << strFile << endl;
+        return false;
+    }
+
+    mstrFile = strFile;
+    mnWidth = width;
+    mnHeight = height;
+    mnFeatures = nFeatures;
+    mvIndex.clear();
+
+    // The header is written again by Close, once the index offset is known
+    Header header;
+    memset(&header,0,sizeof(header));
+    mFile.write(reinterpret_cast<const char*>(&header),sizeof(header));
+    mnOffset = sizeof(header);
+
+    return mFile.good();
+}
+
+void FeatureCache::Close()
+{
+    unique_lock<mutex> lock(mMutex);
+
+    if(mFile.is_open())
+    {
+        // The index is 8 byte aligned in the mapped file
+        const char padding[8] = {0,0,0,0,0,0,0,0};
+        const int nPadding = (8-mnOffset%8)%8;
+        mFile.write(padding,nPadding);
+        mnOffset += nPadding;
+
+        Header header;
+        memcpy(header.signature,CACHE_SIGNATURE,4);
+        header.version = CACHE_VERSION;
+        header.width = mnWidth;
+        header.height = mnHeight;
+        header.nFeatures = mnFeatures;
+        header.descriptorSize = DESCRIPTOR_SIZE;
+        header.nFrames = mvIndex.size();
+        header.indexOffset = mnOffset;
+
+        if(!mvIndex.empty())
+            mFile.write(reinterpret_cast<const char*>(&mvIndex[0]),mvIndex.size()*sizeof(IndexEntry));
+        mFile.seekp(0);
+        mFile.write(reinterpret_cast<const char*>(&header),sizeof(header));
+        mFile.close();
+
+        cout << "Feature cache: " << mvIndex.size() << " frames written to " << mstrFile << endl;
+        mvIndex.clear();
+    }
+
+    if(mpData)
+    {
+        if(mnHits+mnMisses>0)
+        {
+            cout << "Feature cache: " << mnHits << " frames read from " << mstrFile;
+            if(mnMisses>0)
+                cout << ", " << mnMisses << " frames not cached";
+            cout << endl;
+        }
+
+        munmap(const_cast<unsigned char*>(mpData),mnSize);
+        mpData = static_cast<const unsigned char*>(NULL);
+        mpIndex = static_cast<const IndexEntry*>(NULL);
+        mnSize = 0;
+        mvOrder.clear();
+    }
+
+    mnHits = 0;
+    mnMisses = 0;
+}
+
+bool FeatureCache::Get(const double &timestamp, vector<cv::KeyPoint> &vKeys, cv::Mat &descriptors)
+{
+    unique_lock<mutex> lock(mMutex);
+
+    if(!mpData)
+        return false;
+
+    vector<pair<double,int> >::const_iterator it =
+            lower_bound(mvOrder.begin(),mvOrder.end(),make_pair(timestamp-TIMESTAMP_TOLERANCE,-1));
+    if(it==mvOrder.end() || fabs(it->first-timestamp)>TIMESTAMP_TOLERANCE)
+    {
+        mnMisses++;
+        return false;
+    }
+
+    const IndexEntry &entry = mpIndex[it->second];
+    const float* pKeys = reinterpret_cast<const float*>(mpData+entry.offset);
+    const unsigned char* pDesc = mpData+entry.offset+entry.N*3*sizeof(float);
+
+    vKeys.resize(entry.N);
+    for(int i=0; i<entry.N; i++)
+        vKeys[i] = cv::KeyPoint(pKeys[3*i],pKeys[3*i+1],1.0f,-1,pKeys[3*i+2]);
+
+    descriptors.create(entry.N,DESCRIPTOR_SIZE,CV_8U);
+    if(entry.N>0)
+        memcpy(descriptors.data,pDesc,entry.N*DESCRIPTOR_SIZE);
+
+    mnHits++;
+    return true;
+}
+
+void FeatureCache::Add(const double &timestamp, const vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors)
+{
+    unique_lock<mutex> lock(mMutex);
+
+    if(!mFile.is_open())
+        return;
+
+    const int N = vKeys.size();
+    CV_Assert(N==0 || (descriptors.rows==N && descriptors.cols==DESCRIPTOR_SIZE && descriptors.type()==CV_8U));
+
+    mvKeyBuffer.resize(3*N);
+    for(int i=0; i<N; i++)
+    {
+        mvKeyBuffer[3*i] = vKeys[i].pt.x;
+        mvKeyBuffer[3*i+1] = vKeys[i].pt.y;
+        mvKeyBuffer[3*i+2] = vKeys[i].response;
+    }
+
+    if(N>0)
+        mFile.write(reinterpret_cast<const char*>(&mvKeyBuffer[0]),3*N*sizeof(float));
+    for(int i=0; i<N; i++)
+        mFile.write(reinterpret_cast<const char*>(descriptors.ptr(i)),DESCRIPTOR_SIZE);
+
+    IndexEntry entry;
+    entry.timestamp = timestamp;
+    entry.offset = mnOffset;
+    entry.N = N;
+    entry.reserved = 0;
+    mvIndex.push_back(entry);
+
+    mnOffset += (int64_t)N*(3*sizeof(float)+DESCRIPTOR_SIZE);
+}
+
+} //namespace ORB_SLAM
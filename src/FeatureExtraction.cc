@@ -0,0 +1,206 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FeatureExtraction.h"
+#include "Tracking.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+FeatureExtraction::FeatureExtraction(Tracking *pTracker, const int nQueueSize):
+    mpTracker(pTracker), mnQueueSize(max(nQueueSize,1)), mbBusy(false), mbFinishRequested(false), mbFinished(false)
+{
+}
+
+void FeatureExtraction::Run()
+{
+    Profiler::SetThreadName("FeatureExtraction");
+
+    while(1)
+    {
+        ImageRGBD image;
+        {
+            unique_lock<mutex> lock(mMutexQueue);
+            while(mlImages.empty() && !mbFinishRequested)
+                mCondImages.wait(lock);
+
+            if(mlImages.empty())
+                break;
+
+            image = mlImages.front();
+            mlImages.pop_front();
+            mbBusy = true;
+        }
+
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+        ExtractedFrame extracted;
+        extracted.frame = mpTracker->CreateFrameRGBD(image.imRGB,image.imD,image.timestamp,extracted.imGray);
+
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+        const double textract = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+
+        {
+            unique_lock<mutex> lock(mMutexQueue);
+            mlFrames.push_back(extracted);
+            mbBusy = false;
+        }
+        mCondFrames.notify_all();
+
+        unique_lock<mutex> lock(mMutexStats);
+        mvTimesExtraction.push_back(textract);
+    }
+
+    unique_lock<mutex> lock(mMutexQueue);
+    mbFinished = true;
+    mCondFrames.notify_all();
+}
+
+void FeatureExtraction::InsertImageRGBD(const cv::Mat &imRGB, const cv::Mat &imD, const double &timestamp)
+{
+    ImageRGBD image;
+    image.imRGB = imRGB.clone();
+    image.imD = imD.clone();
+    image.timestamp = timestamp;
+
+    int nDepth;
+    {
+        unique_lock<mutex> lock(mMutexQueue);
+        while((int)(mlImages.size()+mlFrames.size()+(mbBusy ? 1 : 0))>mnQueueSize && !mbFinished)
+            mCondFrames.wait(lock);
+
+        mlImages.push_back(image);
+        nDepth = mlImages.size()+mlFrames.size()+(mbBusy ? 1 : 0);
+    }
+    mCondImages.notify_one();
+
+    unique_lock<mutex> lock(mMutexStats);
+    mvQueueDepth.push_back(nDepth);
+}
+
+bool FeatureExtraction::GetFrame(Frame &frame, cv::Mat &imGray)
+{
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    {
+        unique_lock<mutex> lock(mMutexQueue);
+        while(mlFrames.empty() && (!mlImages.empty() || mbBusy) && !mbFinished)
+            mCondFrames.wait(lock);
+
+        if(mlFrames.empty())
+            return false;
+
+        frame = mlFrames.front().frame;
+        imGray = mlFrames.front().imGray;
+        mlFrames.pop_front();
+    }
+    mCondFrames.notify_all();
+
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    const double twait = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+
+    unique_lock<mutex> lock(mMutexStats);
+    mvTimesWait.push_back(twait);
+
+    return true;
+}
+
+int FeatureExtraction::FramesPending()
+{
+    unique_lock<mutex> lock(mMutexQueue);
+    return mlImages.size()+mlFrames.size()+(mbBusy ? 1 : 0);
+}
+
+void FeatureExtraction::Clear()
+{
+    unique_lock<mutex> lock(mMutexQueue);
+    mlImages.clear();
+    while(mbBusy)
+        mCondFrames.wait(lock);
+    mlFrames.clear();
+    mCondFrames.notify_all();
+}
+
+void FeatureExtraction::AddTrackingTime(const double &t)
+{
+    unique_lock<mutex> lock(mMutexStats);
+    mvTimesTracking.push_back(t);
+}
+
+static void PrintTimes(const string &name, vector<float> vTimes)
+{
+    if(vTimes.empty())
+        return;
+
+    sort(vTimes.begin(),vTimes.end());
+    float totaltime = 0;
+    for(size_t i=0; i<vTimes.size(); i++)
+        totaltime+=vTimes[i];
+
+    cout << "median " << name << " time: " << vTimes[vTimes.size()/2] << endl;
+    cout << "mean " << name << " time: " << totaltime/vTimes.size() << endl;
+}
+
+void FeatureExtraction::PrintStatistics()
+{
+    unique_lock<mutex> lock(mMutexStats);
+
+    float meanDepth = 0;
+    int maxDepth = 0;
+    for(size_t i=0; i<mvQueueDepth.size(); i++)
+    {
+        meanDepth+=mvQueueDepth[i];
+        maxDepth = max(maxDepth,mvQueueDepth[i]);
+    }
+    if(!mvQueueDepth.empty())
+        meanDepth/=mvQueueDepth.size();
+
+    cout << "-------" << endl << endl;
+    cout << "Feature extraction pipeline (queue size " << mnQueueSize << ")" << endl;
+    cout << "frames extracted: " << mvTimesExtraction.size() << endl;
+    cout << "mean queue depth: " << meanDepth << " (max " << maxDepth << ")" << endl;
+    PrintTimes("extraction",mvTimesExtraction);
+    PrintTimes("tracking",mvTimesTracking);
+    PrintTimes("wait for extraction",mvTimesWait);
+}
+
+void FeatureExtraction::RequestFinish()
+{
+    {
+        unique_lock<mutex> lock(mMutexQueue);
+        mbFinishRequested = true;
+    }
+    mCondImages.notify_all();
+}
+
+bool FeatureExtraction::isFinished()
+{
+    unique_lock<mutex> lock(mMutexQueue);
+    return mbFinished;
+}
+
+} //namespace ORB_SLAM
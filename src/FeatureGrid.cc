@@ -0,0 +1,160 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FeatureGrid.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+FeatureGrid::FeatureGrid():
+    mnCols(0), mnRows(0), mfMinX(0), mfMinY(0), mfCellWidthInv(0), mfCellHeightInv(0)
+{
+    FrameArena::Acquire(mvCellStart);
+    FrameArena::Acquire(mvIndices);
+    mvCellStart.push_back(0);
+}
+
+FeatureGrid::FeatureGrid(const FeatureGrid &grid):
+    mnCols(grid.mnCols), mnRows(grid.mnRows), mfMinX(grid.mfMinX), mfMinY(grid.mfMinY),
+    mfCellWidthInv(grid.mfCellWidthInv), mfCellHeightInv(grid.mfCellHeightInv)
+{
+    FrameArena::Acquire(mvCellStart);
+    FrameArena::Acquire(mvIndices);
+    mvCellStart = grid.mvCellStart;
+    mvIndices = grid.mvIndices;
+}
+
+FeatureGrid::~FeatureGrid()
+{
+    FrameArena::Release(mvCellStart);
+    FrameArena::Release(mvIndices);
+}
+
+void FeatureGrid::Assign(const KeyPointArray &keysUn, const int nCols, const int nRows,
+                         const float minX, const float minY, const float cellWidthInv, const float cellHeightInv)
+{
+    mnCols = nCols;
+    mnRows = nRows;
+    mfMinX = minX;
+    mfMinY = minY;
+    mfCellWidthInv = cellWidthInv;
+    mfCellHeightInv = cellHeightInv;
+
+    const int N = keysUn.size();
+    const int nCells = mnCols*mnRows;
+
+    // Counting sort of the keypoints by cell (scratch buffers from the FrameArena)
+    vector<int> vCell;
+    FrameArena::Acquire(vCell);
+    vCell.resize(N);
+    mvCellStart.assign(nCells+1,0);
+    for(int i=0; i<N; i++)
+    {
+        const int posX = round((keysUn.X(i)-mfMinX)*mfCellWidthInv);
+        const int posY = round((keysUn.Y(i)-mfMinY)*mfCellHeightInv);
+
+        //Keypoint's coordinates are undistorted, which could cause to go out of the image
+        if(posX<0 || posX>=mnCols || posY<0 || posY>=mnRows)
+        {
+            vCell[i] = -1;
+            continue;
+        }
+
+        vCell[i] = posX*mnRows+posY;
+        mvCellStart[vCell[i]+1]++;
+    }
+
+    for(int c=0; c<nCells; c++)
+        mvCellStart[c+1] += mvCellStart[c];
+
+    mvIndices.resize(mvCellStart[nCells]);
+    vector<unsigned int> vNext;
+    FrameArena::Acquire(vNext);
+    vNext.assign(mvCellStart.begin(),mvCellStart.end()-1);
+    for(int i=0; i<N; i++)
+    {
+        if(vCell[i]>=0)
+            mvIndices[vNext[vCell[i]]++] = i;
+    }
+
+    FrameArena::Release(vCell);
+    FrameArena::Release(vNext);
+}
+
+void FeatureGrid::GetFeaturesInArea(const KeyPointArray &keysUn, const float &x, const float &y, const float &r,
+                                    const int minLevel, const int maxLevel, vector<size_t> &vIndices) const
+{
+    vIndices.clear();
+
+    const int nMinCellX = max(0,(int)floor((x-mfMinX-r)*mfCellWidthInv));
+    if(nMinCellX>=mnCols)
+        return;
+
+    const int nMaxCellX = min(mnCols-1,(int)ceil((x-mfMinX+r)*mfCellWidthInv));
+    if(nMaxCellX<0)
+        return;
+
+    const int nMinCellY = max(0,(int)floor((y-mfMinY-r)*mfCellHeightInv));
+    if(nMinCellY>=mnRows)
+        return;
+
+    const int nMaxCellY = min(mnRows-1,(int)ceil((y-mfMinY+r)*mfCellHeightInv));
+    if(nMaxCellY<0)
+        return;
+
+    const bool bCheckLevels = (minLevel>0) || (maxLevel>=0);
+
+    const float* pX = keysUn.XData();
+    const float* pY = keysUn.YData();
+    const unsigned char* pOctave = keysUn.OctaveData();
+
+    for(int ix = nMinCellX; ix<=nMaxCellX; ix++)
+    {
+        // The cells nMinCellY..nMaxCellY of a column are contiguous
+        const unsigned int* pIdx = CellBegin(ix,nMinCellY);
+        const unsigned int* pEnd = CellEnd(ix,nMaxCellY);
+
+        for(; pIdx!=pEnd; pIdx++)
+        {
+            const unsigned int idx = *pIdx;
+            if(bCheckLevels)
+            {
+                if(pOctave[idx]<minLevel)
+                    continue;
+                if(maxLevel>=0)
+                    if(pOctave[idx]>maxLevel)
+                        continue;
+            }
+
+            const float distx = pX[idx]-x;
+            const float disty = pY[idx]-y;
+
+            if(fabs(distx)<r && fabs(disty)<r)
+                vIndices.push_back(idx);
+        }
+    }
+}
+
+} //namespace ORB_SLAM
@@ -21,6 +21,7 @@
 #include "Frame.h"
 #include "Converter.h"
 #include "ORBmatcher.h"
+#include "Profiler.h"
 #include <thread>
 
 namespace ORB_SLAM2
@@ -37,31 +38,65 @@ Frame::Frame()
 
 //Copy Constructor
 Frame::Frame(const Frame &frame)
-    :mpORBvocabulary(frame.mpORBvocabulary), mpORBextractorLeft(frame.mpORBextractorLeft), mpORBextractorRight(frame.mpORBextractorRight),
-     mTimeStamp(frame.mTimeStamp), mK(frame.mK.clone()), mDistCoef(frame.mDistCoef.clone()),
-     mbf(frame.mbf), mb(frame.mb), mThDepth(frame.mThDepth), N(frame.N), mvKeys(frame.mvKeys),
-     mvKeysRight(frame.mvKeysRight), mvKeysUn(frame.mvKeysUn),  mvuRight(frame.mvuRight),
-     mvDepth(frame.mvDepth), mBowVec(frame.mBowVec), mFeatVec(frame.mFeatVec),
+    :mpORBvocabulary(frame.mpORBvocabulary), mpGCNextractor(frame.mpGCNextractor),
+     mpORBextractorLeft(frame.mpORBextractorLeft), mpORBextractorRight(frame.mpORBextractorRight),
+     mTimeStamp(frame.mTimeStamp), mK(frame.mK), mDistCoef(frame.mDistCoef),
+     mbf(frame.mbf), mb(frame.mb), mThDepth(frame.mThDepth), N(frame.N),
+     mKeysUnArray(frame.mKeysUnArray), mBowVec(frame.mBowVec), mFeatVec(frame.mFeatVec),
      mDescriptors(frame.mDescriptors.clone()), mDescriptorsRight(frame.mDescriptorsRight.clone()),
-     mvpMapPoints(frame.mvpMapPoints), mvbOutlier(frame.mvbOutlier), mnId(frame.mnId),
+     mGrid(frame.mGrid), mnId(frame.mnId),
      mpReferenceKF(frame.mpReferenceKF), mnScaleLevels(frame.mnScaleLevels),
      mfScaleFactor(frame.mfScaleFactor), mfLogScaleFactor(frame.mfLogScaleFactor),
      mvScaleFactors(frame.mvScaleFactors), mvInvScaleFactors(frame.mvInvScaleFactors),
      mvLevelSigma2(frame.mvLevelSigma2), mvInvLevelSigma2(frame.mvInvLevelSigma2)
 {
-    for(int i=0;i<FRAME_GRID_COLS;i++)
-        for(int j=0; j<FRAME_GRID_ROWS; j++)
-            mGrid[i][j]=frame.mGrid[i][j];
+    AcquireBuffers();
+    mvKeys = frame.mvKeys;
+    mvKeysRight = frame.mvKeysRight;
+    mvKeysUn = frame.mvKeysUn;
+    mvuRight = frame.mvuRight;
+    mvDepth = frame.mvDepth;
+    mvpMapPoints = frame.mvpMapPoints;
+    mvbOutlier = frame.mvbOutlier;
 
     if(!frame.mTcw.empty())
         SetPose(frame.mTcw);
 }
 
+Frame::~Frame()
+{
+    ReleaseBuffers();
+}
+
+void Frame::AcquireBuffers()
+{
+    FrameArena::Acquire(mvKeys);
+    FrameArena::Acquire(mvKeysRight);
+    FrameArena::Acquire(mvKeysUn);
+    FrameArena::Acquire(mvuRight);
+    FrameArena::Acquire(mvDepth);
+    FrameArena::Acquire(mvpMapPoints);
+    FrameArena::Acquire(mvbOutlier);
+}
+
+void Frame::ReleaseBuffers()
+{
+    FrameArena::Release(mvKeys);
+    FrameArena::Release(mvKeysRight);
+    FrameArena::Release(mvKeysUn);
+    FrameArena::Release(mvuRight);
+    FrameArena::Release(mvDepth);
+    FrameArena::Release(mvpMapPoints);
+    FrameArena::Release(mvbOutlier);
+}
+
 
 Frame::Frame(const cv::Mat &imLeft, const cv::Mat &imRight, const double &timeStamp, ORBextractor* extractorLeft, ORBextractor* extractorRight, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth)
-    :mpORBvocabulary(voc),mpORBextractorLeft(extractorLeft),mpORBextractorRight(extractorRight), mTimeStamp(timeStamp), mK(K.clone()),mDistCoef(distCoef.clone()), mbf(bf), mThDepth(thDepth),
+    :mpORBvocabulary(voc),mpORBextractorLeft(extractorLeft),mpORBextractorRight(extractorRight), mTimeStamp(timeStamp), mK(K),mDistCoef(distCoef), mbf(bf), mThDepth(thDepth),
      mpReferenceKF(static_cast<KeyFrame*>(NULL))
 {
+    AcquireBuffers();
+
     // Frame ID
     mnId=nNextId++;
 
@@ -89,8 +124,8 @@ Frame::Frame(const cv::Mat &imLeft, const cv::Mat &imRight, const double &timeSt
 
     ComputeStereoMatches();
 
-    mvpMapPoints = vector<MapPoint*>(N,static_cast<MapPoint*>(NULL));    
-    mvbOutlier = vector<bool>(N,false);
+    mvpMapPoints.assign(N,static_cast<MapPoint*>(NULL));
+    mvbOutlier.assign(N,false);
 
 
     // This is done only for the first Frame (or after a change in the calibration)
@@ -118,8 +153,10 @@ Frame::Frame(const cv::Mat &imLeft, const cv::Mat &imRight, const double &timeSt
 
 Frame::Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeStamp, ORBextractor* extractor,ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth)
     :mpORBvocabulary(voc),mpORBextractorLeft(extractor),mpORBextractorRight(static_cast<ORBextractor*>(NULL)),
-     mTimeStamp(timeStamp), mK(K.clone()),mDistCoef(distCoef.clone()), mbf(bf), mThDepth(thDepth)
+     mTimeStamp(timeStamp), mK(K),mDistCoef(distCoef), mbf(bf), mThDepth(thDepth)
 {
+    AcquireBuffers();
+
     // Frame ID
     mnId=nNextId++;
 
@@ -144,8 +181,8 @@ Frame::Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeSt
 
     ComputeStereoFromRGBD(imDepth);
 
-    mvpMapPoints = vector<MapPoint*>(N,static_cast<MapPoint*>(NULL));
-    mvbOutlier = vector<bool>(N,false);
+    mvpMapPoints.assign(N,static_cast<MapPoint*>(NULL));
+    mvbOutlier.assign(N,false);
 
     // This is done only for the first Frame (or after a change in the calibration)
     if(mbInitialComputations)
@@ -173,23 +210,113 @@ Frame::Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeSt
 
 Frame::Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeStamp, GCNextractor* extractor, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth)
     :mpORBvocabulary(voc),mpGCNextractor(extractor),mpORBextractorLeft(static_cast<ORBextractor*>(NULL)), mpORBextractorRight(static_cast<ORBextractor*>(NULL)),
-     mTimeStamp(timeStamp), mK(K.clone()),mDistCoef(distCoef.clone()), mbf(bf), mThDepth(thDepth)
+     mTimeStamp(timeStamp), mK(K),mDistCoef(distCoef), mbf(bf), mThDepth(thDepth)
+{
+    AcquireBuffers();
+
+    // Frame ID
+    mnId=nNextId++;
+
+    // ORB extraction
+    ExtractGCN(imGray);
+
+    SetupGCN(imGray,imDepth,K);
+}
+
+Frame::Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeStamp, const std::vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, GCNextractor* extractor, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth)
+    :mpORBvocabulary(voc),mpGCNextractor(extractor),mpORBextractorLeft(static_cast<ORBextractor*>(NULL)), mpORBextractorRight(static_cast<ORBextractor*>(NULL)),
+     mTimeStamp(timeStamp), mK(K),mDistCoef(distCoef), mbf(bf), mThDepth(thDepth)
+{
+    AcquireBuffers();
+
+    // Frame ID
+    mnId=nNextId++;
+
+    mvKeys = vKeys;
+    mDescriptors = descriptors;
+
+    SetupGCN(imGray,imDepth,K);
+}
+
+Frame::Frame(const std::vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, const std::vector<float> &vDepth, const cv::Size &imageSize, const double &timeStamp, ORBextractor* extractor, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth)
+    :mpORBvocabulary(voc),mpGCNextractor(static_cast<GCNextractor*>(NULL)),mpORBextractorLeft(extractor),mpORBextractorRight(static_cast<ORBextractor*>(NULL)),
+     mTimeStamp(timeStamp), mK(K),mDistCoef(distCoef), mbf(bf), mThDepth(thDepth)
 {
+    AcquireBuffers();
+
     // Frame ID
     mnId=nNextId++;
 
+    // Scale Level Info
+    mnScaleLevels = mpORBextractorLeft->GetLevels();
+    mfScaleFactor = mpORBextractorLeft->GetScaleFactor();
+    mfLogScaleFactor = log(mfScaleFactor);
+    mvScaleFactors = mpORBextractorLeft->GetScaleFactors();
+    mvInvScaleFactors = mpORBextractorLeft->GetInverseScaleFactors();
+    mvLevelSigma2 = mpORBextractorLeft->GetScaleSigmaSquares();
+    mvInvLevelSigma2 = mpORBextractorLeft->GetInverseScaleSigmaSquares();
+
+    // The caller may reuse its buffer for the next frame
+    mvKeys = vKeys;
+    mDescriptors = descriptors.clone();
+
+    N = mvKeys.size();
+
+    if(mvKeys.empty())
+        return;
+
+    UndistortKeyPoints();
+
+    // Same depth range as ComputeStereoFromRGBD
+    mvuRight.assign(N,-1);
+    mvDepth.assign(N,-1);
+    for(int i=0; i<N; i++)
+    {
+        const float d = vDepth[i];
+        if(d>0.1f && d<20.f)
+        {
+            mvDepth[i] = d;
+            mvuRight[i] = mvKeysUn[i].pt.x-mbf/d;
+        }
+    }
+
+    mvpMapPoints.assign(N,static_cast<MapPoint*>(NULL));
+    mvbOutlier.assign(N,false);
+
+    // This is done only for the first Frame (or after a change in the calibration)
+    if(mbInitialComputations)
+    {
+        ComputeImageBounds(cv::Mat(imageSize,CV_8UC1));
+
+        mfGridElementWidthInv=static_cast<float>(FRAME_GRID_COLS)/static_cast<float>(mnMaxX-mnMinX);
+        mfGridElementHeightInv=static_cast<float>(FRAME_GRID_ROWS)/static_cast<float>(mnMaxY-mnMinY);
+
+        fx = K.at<float>(0,0);
+        fy = K.at<float>(1,1);
+        cx = K.at<float>(0,2);
+        cy = K.at<float>(1,2);
+        invfx = 1.0f/fx;
+        invfy = 1.0f/fy;
+
+        mbInitialComputations=false;
+    }
+
+    mb = mbf/fx;
+
+    AssignFeaturesToGrid();
+}
+
+void Frame::SetupGCN(const cv::Mat &imGray, const cv::Mat &imDepth, cv::Mat &K)
+{
     // Scale Level Info
     mnScaleLevels = mpGCNextractor->GetLevels();
-    mfScaleFactor = mpGCNextractor->GetScaleFactor();    
+    mfScaleFactor = mpGCNextractor->GetScaleFactor();
     mfLogScaleFactor = log(mfScaleFactor);
     mvScaleFactors = mpGCNextractor->GetScaleFactors();
     mvInvScaleFactors = mpGCNextractor->GetInverseScaleFactors();
     mvLevelSigma2 = mpGCNextractor->GetScaleSigmaSquares();
     mvInvLevelSigma2 = mpGCNextractor->GetInverseScaleSigmaSquares();
 
-    // ORB extraction
-    ExtractGCN(imGray);
-
     N = mvKeys.size();
 
     if(mvKeys.empty())
@@ -199,8 +326,8 @@ Frame::Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeSt
 
     ComputeStereoFromRGBD(imDepth);
 
-    mvpMapPoints = vector<MapPoint*>(N,static_cast<MapPoint*>(NULL));
-    mvbOutlier = vector<bool>(N,false);
+    mvpMapPoints.assign(N,static_cast<MapPoint*>(NULL));
+    mvbOutlier.assign(N,false);
 
     // This is done only for the first Frame (or after a change in the calibration)
     if(mbInitialComputations)
@@ -227,8 +354,10 @@ Frame::Frame(const cv::Mat &imGray, const cv::Mat &imDepth, const double &timeSt
 
 Frame::Frame(const cv::Mat &imGray, const double &timeStamp, ORBextractor* extractor,ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth)
     :mpORBvocabulary(voc),mpORBextractorLeft(extractor),mpORBextractorRight(static_cast<ORBextractor*>(NULL)),
-     mTimeStamp(timeStamp), mK(K.clone()),mDistCoef(distCoef.clone()), mbf(bf), mThDepth(thDepth)
+     mTimeStamp(timeStamp), mK(K),mDistCoef(distCoef), mbf(bf), mThDepth(thDepth)
 {
+    AcquireBuffers();
+
     // Frame ID
     mnId=nNextId++;
 
@@ -252,11 +381,11 @@ Frame::Frame(const cv::Mat &imGray, const double &timeStamp, ORBextractor* extra
     UndistortKeyPoints();
 
     // Set no stereo information
-    mvuRight = vector<float>(N,-1);
-    mvDepth = vector<float>(N,-1);
+    mvuRight.assign(N,-1);
+    mvDepth.assign(N,-1);
 
-    mvpMapPoints = vector<MapPoint*>(N,static_cast<MapPoint*>(NULL));
-    mvbOutlier = vector<bool>(N,false);
+    mvpMapPoints.assign(N,static_cast<MapPoint*>(NULL));
+    mvbOutlier.assign(N,false);
 
     // This is done only for the first Frame (or after a change in the calibration)
     if(mbInitialComputations)
@@ -283,19 +412,7 @@ Frame::Frame(const cv::Mat &imGray, const double &timeStamp, ORBextractor* extra
 
 void Frame::AssignFeaturesToGrid()
 {
-    int nReserve = 0.5f*N/(FRAME_GRID_COLS*FRAME_GRID_ROWS);
-    for(unsigned int i=0; i<FRAME_GRID_COLS;i++)
-        for (unsigned int j=0; j<FRAME_GRID_ROWS;j++)
-            mGrid[i][j].reserve(nReserve);
-
-    for(int i=0;i<N;i++)
-    {
-        const cv::KeyPoint &kp = mvKeysUn[i];
-
-        int nGridPosX, nGridPosY;
-        if(PosInGrid(kp,nGridPosX,nGridPosY))
-            mGrid[nGridPosX][nGridPosY].push_back(i);
-    }
+    mGrid.Assign(mKeysUnArray,FRAME_GRID_COLS,FRAME_GRID_ROWS,mnMinX,mnMinY,mfGridElementWidthInv,mfGridElementHeightInv);
 }
 
 void Frame::ExtractORB(int flag, const cv::Mat &im)
@@ -323,6 +440,10 @@ void Frame::UpdatePoseMatrices()
     mRwc = mRcw.t();
     mtcw = mTcw.rowRange(0,3).col(3);
     mOw = -mRcw.t()*mtcw;
+
+    mRcwEigen = Converter::toMatrix3f(mRcw);
+    mtcwEigen = Converter::toVector3f(mtcw);
+    mOwEigen = Converter::toVector3f(mOw);
 }
 
 bool Frame::isInFrustum(MapPoint *pMP, float viewingCosLimit)
@@ -330,13 +451,13 @@ bool Frame::isInFrustum(MapPoint *pMP, float viewingCosLimit)
     pMP->mbTrackInView = false;
 
     // 3D in absolute coordinates
-    cv::Mat P = pMP->GetWorldPos(); 
+    const Eigen::Vector3f P = pMP->GetWorldPosEigen();
 
     // 3D in camera coordinates
-    const cv::Mat Pc = mRcw*P+mtcw;
-    const float &PcX = Pc.at<float>(0);
-    const float &PcY= Pc.at<float>(1);
-    const float &PcZ = Pc.at<float>(2);
+    const Eigen::Vector3f Pc = mRcwEigen*P+mtcwEigen;
+    const float &PcX = Pc(0);
+    const float &PcY= Pc(1);
+    const float &PcZ = Pc(2);
 
     // Check positive depth
     if(PcZ<0.0f)
@@ -355,14 +476,14 @@ bool Frame::isInFrustum(MapPoint *pMP, float viewingCosLimit)
     // Check distance is in the scale invariance region of the MapPoint
     const float maxDistance = pMP->GetMaxDistanceInvariance();
     const float minDistance = pMP->GetMinDistanceInvariance();
-    const cv::Mat PO = P-mOw;
-    const float dist = cv::norm(PO);
+    const Eigen::Vector3f PO = P-mOwEigen;
+    const float dist = PO.norm();
 
     if(dist<minDistance || dist>maxDistance)
         return false;
 
    // Check viewing angle
-    cv::Mat Pn = pMP->GetNormal();
+    const Eigen::Vector3f Pn = pMP->GetNormalEigen();
 
     const float viewCos = PO.dot(Pn)/dist;
 
@@ -387,57 +508,16 @@ vector<size_t> Frame::GetFeaturesInArea(const float &x, const float  &y, const f
 {
     vector<size_t> vIndices;
     vIndices.reserve(N);
-
-    const int nMinCellX = max(0,(int)floor((x-mnMinX-r)*mfGridElementWidthInv));
-    if(nMinCellX>=FRAME_GRID_COLS)
-        return vIndices;
-
-    const int nMaxCellX = min((int)FRAME_GRID_COLS-1,(int)ceil((x-mnMinX+r)*mfGridElementWidthInv));
-    if(nMaxCellX<0)
-        return vIndices;
-
-    const int nMinCellY = max(0,(int)floor((y-mnMinY-r)*mfGridElementHeightInv));
-    if(nMinCellY>=FRAME_GRID_ROWS)
-        return vIndices;
-
-    const int nMaxCellY = min((int)FRAME_GRID_ROWS-1,(int)ceil((y-mnMinY+r)*mfGridElementHeightInv));
-    if(nMaxCellY<0)
-        return vIndices;
-
-    const bool bCheckLevels = (minLevel>0) || (maxLevel>=0);
-
-    for(int ix = nMinCellX; ix<=nMaxCellX; ix++)
-    {
-        for(int iy = nMinCellY; iy<=nMaxCellY; iy++)
-        {
-            const vector<size_t> vCell = mGrid[ix][iy];
-            if(vCell.empty())
-                continue;
-
-            for(size_t j=0, jend=vCell.size(); j<jend; j++)
-            {
-                const cv::KeyPoint &kpUn = mvKeysUn[vCell[j]];
-                if(bCheckLevels)
-                {
-                    if(kpUn.octave<minLevel)
-                        continue;
-                    if(maxLevel>=0)
-                        if(kpUn.octave>maxLevel)
-                            continue;
-                }
-
-                const float distx = kpUn.pt.x-x;
-                const float disty = kpUn.pt.y-y;
-
-                if(fabs(distx)<r && fabs(disty)<r)
-                    vIndices.push_back(vCell[j]);
-            }
-        }
-    }
-
+    mGrid.GetFeaturesInArea(mKeysUnArray,x,y,r,minLevel,maxLevel,vIndices);
     return vIndices;
 }
 
+void Frame::GetFeaturesInArea(const float &x, const float  &y, const float  &r, const int minLevel, const int maxLevel,
+                              vector<size_t> &vIndices) const
+{
+    mGrid.GetFeaturesInArea(mKeysUnArray,x,y,r,minLevel,maxLevel,vIndices);
+}
+
 bool Frame::PosInGrid(const cv::KeyPoint &kp, int &posX, int &posY)
 {
     posX = round((kp.pt.x-mnMinX)*mfGridElementWidthInv);
@@ -455,6 +535,7 @@ void Frame::ComputeBoW()
 {
     if(mBowVec.empty())
     {
+        Profiler::ScopedTimer timer(Profiler::COMPUTE_BOW);
         vector<cv::Mat> vCurrentDesc = Converter::toDescriptorVector(mDescriptors);
         mpORBvocabulary->transform(vCurrentDesc,mBowVec,mFeatVec,4);
     }
@@ -465,6 +546,7 @@ void Frame::UndistortKeyPoints()
     if(mDistCoef.at<float>(0)==0.0)
     {
         mvKeysUn=mvKeys;
+        mKeysUnArray.Assign(mvKeysUn);
         return;
     }
 
@@ -490,6 +572,7 @@ void Frame::UndistortKeyPoints()
         kp.pt.y=mat.at<float>(i,1);
         mvKeysUn[i]=kp;
     }
+    mKeysUnArray.Assign(mvKeysUn);
 }
 
 void Frame::ComputeImageBounds(const cv::Mat &imLeft)
@@ -524,8 +607,8 @@ void Frame::ComputeImageBounds(const cv::Mat &imLeft)
 
 void Frame::ComputeStereoMatches()
 {
-    mvuRight = vector<float>(N,-1.0f);
-    mvDepth = vector<float>(N,-1.0f);
+    mvuRight.assign(N,-1.0f);
+    mvDepth.assign(N,-1.0f);
 
     const int thOrbDist = (ORBmatcher::TH_HIGH+ORBmatcher::TH_LOW)/2;
 
@@ -701,8 +784,8 @@ void Frame::ComputeStereoMatches()
 
 void Frame::ComputeStereoFromRGBD(const cv::Mat &imDepth)
 {
-    mvuRight = vector<float>(N,-1);
-    mvDepth = vector<float>(N,-1);
+    mvuRight.assign(N,-1);
+    mvDepth.assign(N,-1);
 
     for(int i=0; i<N; i++)
     {
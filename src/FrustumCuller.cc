@@ -0,0 +1,264 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FrustumCuller.h"
+#include "MapPoint.h"
+#include "Frame.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <functional>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+// Points tested per block, the block scratch stays in L1 cache
+const int CULL_BLOCK_SIZE = 256;
+const int MIN_POINTS_PER_THREAD = 32768;
+
+FrustumCuller::FrustumCuller(): mnCurrent(0), mnRefreshed(0), mnThreads(1)
+{
+}
+
+void FrustumCuller::Snapshot::Resize(const int n)
+{
+    vpMapPoints.resize(n);
+    vVersions.resize(n);
+    vX.resize(n); vY.resize(n); vZ.resize(n);
+    vNx.resize(n); vNy.resize(n); vNz.resize(n);
+    vMinDist2.resize(n); vMaxDist2.resize(n);
+    vMaxDistance.resize(n);
+}
+
+void FrustumCuller::Snapshot::CopyRow(const int i, const Snapshot &from, const int j)
+{
+    vVersions[i] = from.vVersions[j];
+    vX[i] = from.vX[j]; vY[i] = from.vY[j]; vZ[i] = from.vZ[j];
+    vNx[i] = from.vNx[j]; vNy[i] = from.vNy[j]; vNz[i] = from.vNz[j];
+    vMinDist2[i] = from.vMinDist2[j]; vMaxDist2[i] = from.vMaxDist2[j];
+    vMaxDistance[i] = from.vMaxDistance[j];
+}
+
+void FrustumCuller::SetThreads(int nThreads)
+{
+    mnThreads = max(nThreads,1);
+}
+
+void FrustumCuller::Update(const vector<MapPoint*> &vpMapPoints)
+{
+    // The previous snapshot becomes the current one, the current one is reused as previous
+    mnCurrent = 1-mnCurrent;
+    Snapshot &current = mSnapshots[mnCurrent];
+    const Snapshot &previous = mSnapshots[1-mnCurrent];
+
+    const int N = vpMapPoints.size();
+    current.Resize(N);
+
+    mnRefreshed = 0;
+    for(int i=0; i<N; i++)
+    {
+        MapPoint* pMP = vpMapPoints[i];
+        current.vpMapPoints[i] = pMP;
+
+        // Points without geometry get an empty distance interval and never pass
+        if(!pMP)
+        {
+            current.vVersions[i] = -1;
+            current.vX[i] = current.vY[i] = current.vZ[i] = 0;
+            current.vNx[i] = current.vNy[i] = current.vNz[i] = 0;
+            current.vMinDist2[i] = 1.0f;
+            current.vMaxDist2[i] = current.vMaxDistance[i] = 0;
+            continue;
+        }
+
+        // mnTrackFrustumRow is the row of the point in the previous snapshot, if it was there
+        const int row = pMP->mnTrackFrustumRow;
+        if(row>=0 && row<(int)previous.vpMapPoints.size() && previous.vpMapPoints[row]==pMP &&
+           previous.vVersions[row]>=0 && previous.vVersions[row]==pMP->GetPositionVersion())
+        {
+            current.CopyRow(i,previous,row);
+        }
+        else
+        {
+            Eigen::Vector3f Pos, Normal;
+            float minDistance, maxDistance;
+            current.vVersions[i] = pMP->CopyGeometry(Pos,Normal,minDistance,maxDistance);
+            current.vX[i] = Pos(0); current.vY[i] = Pos(1); current.vZ[i] = Pos(2);
+            current.vNx[i] = Normal(0); current.vNy[i] = Normal(1); current.vNz[i] = Normal(2);
+            const float minInvariance = 0.8f*minDistance;
+            const float maxInvariance = 1.2f*maxDistance;
+            current.vMinDist2[i] = minInvariance*minInvariance;
+            current.vMaxDist2[i] = maxInvariance*maxInvariance;
+            current.vMaxDistance[i] = maxDistance;
+            mnRefreshed++;
+        }
+    }
+
+    // Row indices are updated once the previous snapshot is not needed anymore (a point could
+    // appear twice in the list)
+    for(int i=0; i<N; i++)
+        if(vpMapPoints[i])
+            vpMapPoints[i]->mnTrackFrustumRow = i;
+}
+
+void FrustumCuller::Clear()
+{
+    for(int k=0; k<2; k++)
+        mSnapshots[k].Resize(0);
+    mnRefreshed = 0;
+}
+
+void FrustumCuller::Cull(const Frame &F, const float viewingCosLimit, vector<FrustumCandidate> &vCandidates)
+{
+    vCandidates.clear();
+
+    const int N = mSnapshots[mnCurrent].vpMapPoints.size();
+    if(N==0)
+        return;
+
+    const int nThreads = max(1,min(mnThreads,N/MIN_POINTS_PER_THREAD));
+
+    if(nThreads==1)
+    {
+        CullRange(F,viewingCosLimit,0,N,vCandidates);
+        return;
+    }
+
+    // Each thread culls a contiguous range, the results are concatenated in index order
+    mvThreadCandidates.resize(nThreads);
+    vector<thread> vThreads;
+    vThreads.reserve(nThreads-1);
+    for(int t=1; t<nThreads; t++)
+    {
+        const int i0 = (long)N*t/nThreads;
+        const int i1 = (long)N*(t+1)/nThreads;
+        vThreads.push_back(thread(&FrustumCuller::CullRange,this,cref(F),viewingCosLimit,i0,i1,
+                                  ref(mvThreadCandidates[t])));
+    }
+    CullRange(F,viewingCosLimit,0,N/nThreads,vCandidates);
+    for(int t=1; t<nThreads; t++)
+    {
+        vThreads[t-1].join();
+        vCandidates.insert(vCandidates.end(),mvThreadCandidates[t].begin(),mvThreadCandidates[t].end());
+    }
+}
+
+void FrustumCuller::CullRange(const Frame &F, const float viewingCosLimit, const int i0, const int i1,
+                              vector<FrustumCandidate> &vCandidates)
+{
+    vCandidates.clear();
+
+    const Snapshot &s = mSnapshots[mnCurrent];
+    const float* X = &s.vX[0];
+    const float* Y = &s.vY[0];
+    const float* Z = &s.vZ[0];
+    const float* Nx = &s.vNx[0];
+    const float* Ny = &s.vNy[0];
+    const float* Nz = &s.vNz[0];
+    const float* MinDist2 = &s.vMinDist2[0];
+    const float* MaxDist2 = &s.vMaxDist2[0];
+
+    const Eigen::Matrix3f &Rcw = F.GetRotationEigen();
+    const Eigen::Vector3f &tcw = F.GetTranslationEigen();
+    const Eigen::Vector3f &Ow = F.GetCameraCenterEigen();
+    const float r00 = Rcw(0,0), r01 = Rcw(0,1), r02 = Rcw(0,2);
+    const float r10 = Rcw(1,0), r11 = Rcw(1,1), r12 = Rcw(1,2);
+    const float r20 = Rcw(2,0), r21 = Rcw(2,1), r22 = Rcw(2,2);
+    const float t0 = tcw(0), t1 = tcw(1), t2 = tcw(2);
+    const float ox = Ow(0), oy = Ow(1), oz = Ow(2);
+    const float fx = F.fx, fy = F.fy, cx = F.cx, cy = F.cy;
+    const float minX = F.mnMinX, maxX = F.mnMaxX, minY = F.mnMinY, maxY = F.mnMaxY;
+
+    // viewCos>=limit, with viewCos = dot/dist, is tested on squares to avoid the square root
+    const bool bPositiveLimit = viewingCosLimit>=0;
+    const float limit2 = viewingCosLimit*viewingCosLimit;
+
+    float vU[CULL_BLOCK_SIZE], vV[CULL_BLOCK_SIZE], vInvz[CULL_BLOCK_SIZE];
+    float vDist2[CULL_BLOCK_SIZE], vDot[CULL_BLOCK_SIZE];
+    unsigned char vbIn[CULL_BLOCK_SIZE];
+
+    for(int b0=i0; b0<i1; b0+=CULL_BLOCK_SIZE)
+    {
+        const int n = min(CULL_BLOCK_SIZE,i1-b0);
+
+        for(int k=0; k<n; k++)
+        {
+            const int i = b0+k;
+            const float x = X[i], y = Y[i], z = Z[i];
+
+            // 3D in camera coordinates and projection
+            const float xc = r00*x+r01*y+r02*z+t0;
+            const float yc = r10*x+r11*y+r12*z+t1;
+            const float zc = r20*x+r21*y+r22*z+t2;
+            const float invz = 1.0f/zc;
+            const float u = fx*xc*invz+cx;
+            const float v = fy*yc*invz+cy;
+
+            // Distance and viewing angle from the camera center
+            const float px = x-ox, py = y-oy, pz = z-oz;
+            const float dist2 = px*px+py*py+pz*pz;
+            const float dot = px*Nx[i]+py*Ny[i]+pz*Nz[i];
+
+            // Bitwise operators only, a branch would prevent the vectorization
+            const bool bFront = dot>=0.0f;
+            const float dot2 = dot*dot;
+            const bool bCos = (bPositiveLimit & bFront & (dot2>=limit2*dist2)) |
+                              (!bPositiveLimit & (bFront | (dot2<=limit2*dist2)));
+
+            vU[k] = u;
+            vV[k] = v;
+            vInvz[k] = invz;
+            vDist2[k] = dist2;
+            vDot[k] = dot;
+            vbIn[k] = (zc>0.0f) & (u>=minX) & (u<=maxX) & (v>=minY) & (v<=maxY) &
+                      (dist2>=MinDist2[i]) & (dist2<=MaxDist2[i]) & bCos;
+        }
+
+        // Scale level and viewing cosine of the points in view
+        for(int k=0; k<n; k++)
+        {
+            if(!vbIn[k])
+                continue;
+
+            const int i = b0+k;
+            const float dist = sqrt(vDist2[k]);
+
+            int nPredictedLevel = ceil(log(s.vMaxDistance[i]/dist)/F.mfLogScaleFactor);
+            if(nPredictedLevel<0)
+                nPredictedLevel = 0;
+            else if(nPredictedLevel>=F.mnScaleLevels)
+                nPredictedLevel = F.mnScaleLevels-1;
+
+            FrustumCandidate candidate;
+            candidate.index = i;
+            candidate.u = vU[k];
+            candidate.v = vV[k];
+            candidate.ur = vU[k]-F.mbf*vInvz[k];
+            candidate.level = nPredictedLevel;
+            candidate.viewCos = vDot[k]/dist;
+            vCandidates.push_back(candidate);
+        }
+    }
+}
+
+} //namespace ORB_SLAM
@@ -0,0 +1,403 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GCNInferenceService.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+GCNInferenceService::GCNInferenceService(const string &strModelPath, int width, int height,
+                                         const string &strDevice, int nThreads,
+                                         int nMaxBatchSize, double maxLatency):
+#ifdef WITH_TORCH
+    mDevice(torch::kCPU),
+#endif
+    mpNetwork(static_cast<GCNNetwork*>(NULL)), mnWidth(width), mnHeight(height), mnMaxBatchSize(max(nMaxBatchSize,1)),
+    mMaxLatency((long)(max(maxLatency,0.0)*1000.0)), mnStreams(0), mbFinishRequested(false)
+{
+    if(GCNNetwork::IsWeightFile(strModelPath))
+    {
+        mpNetwork = new GCNNetwork(mnWidth, mnHeight, nThreads);
+        if(!mpNetwork->Load(strModelPath))
+            exit(-1);
+
+        mptInference = new thread(&GCNInferenceService::Run,this);
+        return;
+    }
+
+#ifdef WITH_TORCH
+    // Select inference device. Default to CUDA only if there is a GPU to run on.
+    if(strDevice=="cuda" || strDevice=="CUDA")
+        mDevice = torch::Device(torch::kCUDA);
+    else if(strDevice=="cpu" || strDevice=="CPU")
+        mDevice = torch::Device(torch::kCPU);
+    else
+        mDevice = torch::Device(torch::cuda::is_available() ? torch::kCUDA : torch::kCPU);
+
+    if(mDevice.is_cuda() && !torch::cuda::is_available())
+    {
+        cerr << "GCNInferenceService: CUDA requested but not available, falling back to CPU." << endl;
+        mDevice = torch::Device(torch::kCPU);
+    }
+
+    if(mDevice.is_cpu() && nThreads>0)
+        at::set_num_threads(nThreads);
+
+    module = torch::jit::load(strModelPath, mDevice);
+
+    mInputTensor = torch::zeros({mnMaxBatchSize, 1, mnHeight, mnWidth}, torch::kFloat32);
+
+    mptInference = new thread(&GCNInferenceService::Run,this);
+#else
+    cerr << "GCNInferenceService: " << strModelPath << " is not a GCNv2 weight file, and TorchScript models "
+         << "need a build with WITH_TORCH=ON." << endl;
+    exit(-1);
+#endif
+}
+
+GCNInferenceService::~GCNInferenceService()
+{
+    Shutdown();
+    delete mpNetwork;
+}
+
+bool GCNInferenceService::IsOnCPU()
+{
+#ifdef WITH_TORCH
+    if(!mpNetwork)
+        return mDevice.is_cpu();
+#endif
+    return true;
+}
+
+int GCNInferenceService::GetThreads()
+{
+    if(mpNetwork)
+        return mpNetwork->GetThreads();
+#ifdef WITH_TORCH
+    return at::get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+bool GCNInferenceService::SetPrecision(const string &strPrecision, const string &strCalibration)
+{
+    GCNNetwork::Precision precision;
+    if(!GCNNetwork::ParsePrecision(strPrecision,precision))
+    {
+        cerr << "GCNInferenceService: unknown precision " << strPrecision << endl;
+        return false;
+    }
+
+    if(precision==GCNNetwork::FP32)
+        return true;
+
+    if(!mpNetwork)
+    {
+        cerr << "GCNInferenceService: " << strPrecision << " needs exported weights (GCN2/export_gcn.py)" << endl;
+        return false;
+    }
+
+    // Every stream sets the precision, only the first one converts the network
+    unique_lock<mutex> lock(mMutexNetwork);
+    if(mpNetwork->GetPrecision()==precision)
+        return true;
+
+    if(precision==GCNNetwork::INT8 && !mpNetwork->LoadCalibration(strCalibration))
+        return false;
+
+    return mpNetwork->SetPrecision(precision);
+}
+
+string GCNInferenceService::GetPrecision()
+{
+    unique_lock<mutex> lock(mMutexNetwork);
+    return GCNNetwork::GetPrecisionName(mpNetwork ? mpNetwork->GetPrecision() : GCNNetwork::FP32);
+}
+
+void GCNInferenceService::RegisterStream()
+{
+    unique_lock<mutex> lock(mMutexRequests);
+    mnStreams++;
+}
+
+void GCNInferenceService::UnregisterStream()
+{
+    {
+        unique_lock<mutex> lock(mMutexRequests);
+        mnStreams--;
+    }
+    mCondRequests.notify_one();
+}
+
+void GCNInferenceService::Infer(const cv::Mat &input, cv::Mat &pts, cv::Mat &desc)
+{
+    CV_Assert(input.type()==CV_32FC1 && input.cols==mnWidth && input.rows==mnHeight);
+
+    Request request;
+    request.pInput = &input;
+    request.bDone = false;
+    request.tSubmit = std::chrono::steady_clock::now();
+
+    {
+        unique_lock<mutex> lock(mMutexRequests);
+        if(mbFinishRequested)
+        {
+            cerr << "GCNInferenceService: request after shutdown ignored." << endl;
+            pts = cv::Mat(0,3,CV_32F);
+            desc = cv::Mat(0,32,CV_8U);
+            return;
+        }
+        mlpRequests.push_back(&request);
+    }
+    mCondRequests.notify_one();
+
+    unique_lock<mutex> lock(mMutexRequests);
+    while(!request.bDone)
+        mCondDone.wait(lock);
+
+    pts = request.pts;
+    desc = request.desc;
+}
+
+void GCNInferenceService::Run()
+{
+    while(1)
+    {
+        vector<Request*> vpBatch;
+        {
+            unique_lock<mutex> lock(mMutexRequests);
+            while(mlpRequests.empty() && !mbFinishRequested)
+                mCondRequests.wait(lock);
+
+            if(mlpRequests.empty())
+                break;
+
+            // Wait for the other streams, but never longer than the maximum latency
+            const std::chrono::steady_clock::time_point deadline = mlpRequests.front()->tSubmit + mMaxLatency;
+            while((int)mlpRequests.size()<max(1,min(mnMaxBatchSize,mnStreams)) && !mbFinishRequested)
+            {
+                if(mCondRequests.wait_until(lock,deadline)==cv_status::timeout)
+                    break;
+            }
+
+            while(!mlpRequests.empty() && (int)vpBatch.size()<mnMaxBatchSize)
+            {
+                vpBatch.push_back(mlpRequests.front());
+                mlpRequests.pop_front();
+            }
+        }
+
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+        Forward(vpBatch);
+
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+        {
+            unique_lock<mutex> lock(mMutexRequests);
+            for(size_t i=0; i<vpBatch.size(); i++)
+                vpBatch[i]->bDone = true;
+
+            mvBatchSizes.push_back(vpBatch.size());
+            mvTimesForward.push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+        }
+        mCondDone.notify_all();
+    }
+}
+
+void GCNInferenceService::Forward(vector<Request*> &vpBatch)
+{
+    if(mpNetwork)
+        ForwardNative(vpBatch);
+#ifdef WITH_TORCH
+    else
+        ForwardModule(vpBatch);
+#endif
+}
+
+void GCNInferenceService::ForwardNative(vector<Request*> &vpBatch)
+{
+    const int n = vpBatch.size();
+
+    unique_lock<mutex> lock(mMutexNetwork);
+
+    // The inputs stay owned by the waiting extractors, outputs are handed over to them
+    mvInputs.resize(n);
+    for(int i=0; i<n; i++)
+        mvInputs[i] = *vpBatch[i]->pInput;
+
+    (*mpNetwork)(mvInputs,mvPts,mvDesc);
+
+    for(int i=0; i<n; i++)
+    {
+        vpBatch[i]->pts = mvPts[i];
+        vpBatch[i]->desc = mvDesc[i];
+        mvInputs[i].release();
+        mvPts[i].release();
+        mvDesc[i].release();
+    }
+}
+
+#ifdef WITH_TORCH
+void GCNInferenceService::Forward(const int i0, const int n, torch::Tensor &pts, torch::Tensor &desc)
+{
+    // No autograd bookkeeping is needed for inference.
+    torch::NoGradGuard no_grad;
+
+    torch::Tensor input = mInputTensor.narrow(0,i0,n);
+    if(mDevice.is_cuda())
+        input = input.to(mDevice);
+
+    std::vector<torch::jit::IValue> inputs;
+    inputs.push_back(input);
+    auto output = module->forward(inputs).toTuple();
+
+    // One row per point, also when there is a single point
+    pts = output->elements()[0].toTensor().to(torch::kCPU).squeeze().contiguous();
+    pts = pts.view({-1, pts.size(pts.dim()-1)});
+    desc = output->elements()[1].toTensor().to(torch::kCPU).squeeze().contiguous().view({-1, 32});
+}
+
+static void ToMat(const torch::Tensor &pts, const torch::Tensor &desc, cv::Mat &ptsMat, cv::Mat &descMat)
+{
+    const int N = pts.size(0);
+    ptsMat = cv::Mat(N,3,CV_32F);
+    descMat = cv::Mat(N,32,CV_8U);
+    if(N==0)
+        return;
+
+    memcpy(ptsMat.data,pts.data<float>(),N*3*sizeof(float));
+    memcpy(descMat.data,desc.data<unsigned char>(),N*32);
+}
+
+void GCNInferenceService::ForwardModule(vector<Request*> &vpBatch)
+{
+    const int n = vpBatch.size();
+    const size_t imageSize = mnWidth*mnHeight;
+    float* pInput = mInputTensor.data<float>();
+
+    for(int i=0; i<n; i++)
+    {
+        const cv::Mat &im = *vpBatch[i]->pInput;
+        for(int y=0; y<mnHeight; y++)
+            memcpy(pInput+i*imageSize+y*mnWidth,im.ptr<float>(y),mnWidth*sizeof(float));
+    }
+
+    torch::Tensor pts, desc;
+
+    if(n>1)
+    {
+        Forward(0,n,pts,desc);
+
+        if(pts.size(1)==4)
+        {
+            // Rows are (image index, u, v, confidence)
+            vector<int> vnPoints(n,0);
+            const float* pPts = pts.data<float>();
+            const int K = pts.size(0);
+            for(int k=0; k<K; k++)
+            {
+                const int b = (int)pPts[4*k];
+                if(b>=0 && b<n)
+                    vnPoints[b]++;
+            }
+
+            for(int i=0; i<n; i++)
+            {
+                vpBatch[i]->pts = cv::Mat(vnPoints[i],3,CV_32F);
+                vpBatch[i]->desc = cv::Mat(vnPoints[i],32,CV_8U);
+                vnPoints[i] = 0;
+            }
+
+            const unsigned char* pDesc = desc.data<unsigned char>();
+            for(int k=0; k<K; k++)
+            {
+                const int b = (int)pPts[4*k];
+                if(b<0 || b>=n)
+                    continue;
+                const int row = vnPoints[b]++;
+                memcpy(vpBatch[b]->pts.ptr<float>(row),pPts+4*k+1,3*sizeof(float));
+                memcpy(vpBatch[b]->desc.ptr(row),pDesc+32*k,32);
+            }
+            return;
+        }
+
+        cerr << "GCNInferenceService: the model does not return the image index of each point, "
+             << "running images one by one." << endl;
+        mnMaxBatchSize = 1;
+    }
+
+    for(int i=0; i<n; i++)
+    {
+        Forward(i,1,pts,desc);
+        ToMat(pts,desc,vpBatch[i]->pts,vpBatch[i]->desc);
+    }
+}
+#endif
+
+void GCNInferenceService::PrintStatistics()
+{
+    unique_lock<mutex> lock(mMutexRequests);
+
+    if(mvBatchSizes.empty())
+        return;
+
+    int nImages = 0;
+    float totaltime = 0;
+    for(size_t i=0; i<mvBatchSizes.size(); i++)
+    {
+        nImages += mvBatchSizes[i];
+        totaltime += mvTimesForward[i];
+    }
+
+    cout << "-------" << endl << endl;
+    cout << "GCN inference service" << endl;
+    cout << "images: " << nImages << " in " << mvBatchSizes.size() << " batches" << endl;
+    cout << "mean batch size: " << (float)nImages/mvBatchSizes.size() << endl;
+    cout << "mean forward time per batch: " << totaltime/mvBatchSizes.size() << endl;
+    cout << "mean forward time per image: " << totaltime/nImages << endl;
+}
+
+void GCNInferenceService::Shutdown()
+{
+    if(!mptInference)
+        return;
+
+    {
+        unique_lock<mutex> lock(mMutexRequests);
+        mbFinishRequested = true;
+    }
+    mCondRequests.notify_all();
+
+    mptInference->join();
+    delete mptInference;
+    mptInference = static_cast<thread*>(NULL);
+}
+
+} //namespace ORB_SLAM
@@ -0,0 +1,1366 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GCNNetwork.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+
+// As in HammingDistance.cc, SIMD kernels use per-function target attributes and are only
+// called if the CPU supports them.
+#if defined(__x86_64__) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8))
+#define GCN_X86_KERNELS
+#include <immintrin.h>
+// AVX-VNNI (vpdpwssd on 256 bit registers) needs GCC 11 or clang 12
+#if defined(__clang__) ? (__clang_major__ >= 12) : (__GNUC__ >= 11)
+#define GCN_VNNI_KERNELS
+#endif
+#endif
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+const float GCNNetwork::DETECTION_THRESHOLD = 0.1f;
+
+// Output pixels per im2col panel and output channels per GEMM block
+const int PANEL_SIZE = 16;
+const int BLOCK_SIZE = 4;
+
+// Descriptor channels and detector cell size (pixel shuffle factor)
+const int DESCRIPTOR_CHANNELS = 256;
+const int CELL_SIZE = 16;
+
+const char WEIGHT_FILE_MAGIC[4] = {'G','C','N','W'};
+const int32_t WEIGHT_FILE_VERSION = 1;
+
+static const char* LAYER_NAMES[] = {"conv1", "conv2", "conv3_1", "conv3_2", "conv4_1", "conv4_2",
+                                    "convF_1", "convF_2", "convD_1", "convD_2"};
+const int N_LAYERS = 10;
+
+// C[r][j] = act(bias[r] + sum_k W[k][r]*P[k][j]) for a block of BLOCK_SIZE channels and a panel
+// of PANEL_SIZE pixels. Only nRows x nCols outputs are stored, rows are outStride apart.
+typedef void (*GemmFunc)(const float*, const float*, const int, const float*, const bool,
+                         float*, const size_t, const int, const int);
+
+// INT8 version over nPairs pairs of k: C[r][j] = act(scale[r]*(sum_k W[k][r]*P[k][j] - offset[r]) + bias[r])
+typedef void (*GemmIntFunc)(const short*, const short*, const int, const float*, const int*, const float*,
+                            const bool, float*, const size_t, const int, const int);
+
+typedef void (*HalfToFloatFunc)(const unsigned short*, float*, const size_t);
+
+// Quantizes a float panel of K rows to 8 bit values (q = a*invScale+zero clamped to [0,255])
+// stored as pairs of rows: pixel j of rows 2i and 2i+1 goes to P[i][j][0] and P[i][j][1].
+typedef void (*QuantizeFunc)(const float*, const int, const float, const float, short*);
+
+// IEEE half precision conversions (round to nearest even)
+static unsigned short FloatToHalf(const float f)
+{
+    uint32_t x;
+    memcpy(&x,&f,sizeof(x));
+    const unsigned short sign = (unsigned short)((x>>16)&0x8000);
+    x &= 0x7FFFFFFF;
+
+    // Overflow, infinity and NaN
+    if(x>=0x47800000)
+        return sign | (x>0x7F800000 ? 0x7E00 : 0x7C00);
+
+    // Subnormal half, in units of 2^-24
+    if(x<0x38800000)
+    {
+        float a;
+        memcpy(&a,&x,sizeof(a));
+        return sign | (unsigned short)lrintf(a*16777216.f);
+    }
+
+    // Rebias the exponent and round the mantissa, a carry into the exponent is correct
+    x += 0xC8000FFF + ((x>>13)&1);
+    return sign | (unsigned short)(x>>13);
+}
+
+static float HalfToFloat(const unsigned short h)
+{
+    const uint32_t sign = (uint32_t)(h&0x8000)<<16;
+    const uint32_t exponent = (h>>10)&0x1F;
+    const uint32_t mantissa = h&0x3FF;
+
+    uint32_t x;
+    if(exponent==0)
+    {
+        float f = mantissa*(1.f/16777216.f);
+        memcpy(&x,&f,sizeof(x));
+        x |= sign;
+    }
+    else if(exponent==31)
+        x = sign | 0x7F800000 | (mantissa<<13);
+    else
+        x = sign | ((exponent+112)<<23) | (mantissa<<13);
+
+    float f;
+    memcpy(&f,&x,sizeof(f));
+    return f;
+}
+
+static void HalfToFloatScalar(const unsigned short* pSrc, float* pDst, const size_t n)
+{
+    for(size_t i=0; i<n; i++)
+        pDst[i] = HalfToFloat(pSrc[i]);
+}
+
+static void QuantizeScalar(const float* pPanel, const int K, const float invScale, const float zero, short* pDst)
+{
+    for(int k=0; k<K; k+=2)
+    {
+        const float* pRow0 = pPanel+k*PANEL_SIZE;
+        const float* pRow1 = pRow0+PANEL_SIZE;
+        for(int j=0; j<PANEL_SIZE; j++)
+        {
+            pDst[2*j] = (short)lrintf(min(max(pRow0[j]*invScale+zero,0.f),255.f));
+            pDst[2*j+1] = k+1<K ? (short)lrintf(min(max(pRow1[j]*invScale+zero,0.f),255.f)) : 0;
+        }
+        pDst += 2*PANEL_SIZE;
+    }
+}
+
+static inline float ELU(const float v)
+{
+    return v>0.f ? v : expf(v)-1.f;
+}
+
+static void GemmScalar(const float* pW, const float* pPanel, const int K, const float* pBias, const bool bELU,
+                       float* pOut, const size_t outStride, const int nRows, const int nCols)
+{
+    float acc[BLOCK_SIZE][PANEL_SIZE];
+    for(int r=0; r<BLOCK_SIZE; r++)
+        for(int j=0; j<PANEL_SIZE; j++)
+            acc[r][j] = 0.f;
+
+    for(int k=0; k<K; k++)
+    {
+        const float* w = pW+k*BLOCK_SIZE;
+        const float* p = pPanel+k*PANEL_SIZE;
+        for(int r=0; r<BLOCK_SIZE; r++)
+            for(int j=0; j<PANEL_SIZE; j++)
+                acc[r][j] += w[r]*p[j];
+    }
+
+    for(int r=0; r<nRows; r++)
+    {
+        float* out = pOut+r*outStride;
+        for(int j=0; j<nCols; j++)
+        {
+            const float v = acc[r][j]+pBias[r];
+            out[j] = bELU ? ELU(v) : v;
+        }
+    }
+}
+
+static void GemmIntScalar(const short* pW, const short* pPanel, const int nPairs, const float* pScale,
+                          const int* pOffset, const float* pBias, const bool bELU,
+                          float* pOut, const size_t outStride, const int nRows, const int nCols)
+{
+    int acc[BLOCK_SIZE][PANEL_SIZE];
+    for(int r=0; r<BLOCK_SIZE; r++)
+        for(int j=0; j<PANEL_SIZE; j++)
+            acc[r][j] = 0;
+
+    for(int k=0; k<nPairs; k++)
+    {
+        const short* w = pW+k*2*BLOCK_SIZE;
+        const short* p = pPanel+k*2*PANEL_SIZE;
+        for(int r=0; r<BLOCK_SIZE; r++)
+            for(int j=0; j<PANEL_SIZE; j++)
+                acc[r][j] += w[2*r]*p[2*j] + w[2*r+1]*p[2*j+1];
+    }
+
+    for(int r=0; r<nRows; r++)
+    {
+        float* out = pOut+r*outStride;
+        for(int j=0; j<nCols; j++)
+        {
+            const float v = pScale[r]*(float)(acc[r][j]-pOffset[r])+pBias[r];
+            out[j] = bELU ? ELU(v) : v;
+        }
+    }
+}
+
+#ifdef GCN_X86_KERNELS
+
+// exp(x) for x<=0 (Cephes polynomial, relative error ~1e-7)
+__attribute__((target("avx2,fma")))
+static inline __m256 ExpAVX2(__m256 x)
+{
+    x = _mm256_max_ps(x,_mm256_set1_ps(-87.3f));
+
+    __m256 fx = _mm256_fmadd_ps(x,_mm256_set1_ps(1.44269504088896341f),_mm256_set1_ps(0.5f));
+    fx = _mm256_floor_ps(fx);
+
+    x = _mm256_fnmadd_ps(fx,_mm256_set1_ps(0.693359375f),x);
+    x = _mm256_fnmadd_ps(fx,_mm256_set1_ps(-2.12194440e-4f),x);
+
+    __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+    y = _mm256_fmadd_ps(y,x,_mm256_set1_ps(1.3981999507E-3f));
+    y = _mm256_fmadd_ps(y,x,_mm256_set1_ps(8.3334519073E-3f));
+    y = _mm256_fmadd_ps(y,x,_mm256_set1_ps(4.1665795894E-2f));
+    y = _mm256_fmadd_ps(y,x,_mm256_set1_ps(1.6666665459E-1f));
+    y = _mm256_fmadd_ps(y,x,_mm256_set1_ps(5.0000001201E-1f));
+    y = _mm256_fmadd_ps(y,_mm256_mul_ps(x,x),_mm256_add_ps(x,_mm256_set1_ps(1.f)));
+
+    const __m256i n = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(fx),_mm256_set1_epi32(127)),23);
+    return _mm256_mul_ps(y,_mm256_castsi256_ps(n));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 BiasELUAVX2(const __m256 acc, const __m256 bias, const bool bELU)
+{
+    const __m256 v = _mm256_add_ps(acc,bias);
+    if(!bELU)
+        return v;
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 e = _mm256_sub_ps(ExpAVX2(_mm256_min_ps(v,zero)),_mm256_set1_ps(1.f));
+    return _mm256_blendv_ps(e,v,_mm256_cmp_ps(v,zero,_CMP_GT_OQ));
+}
+
+__attribute__((target("avx2,fma")))
+static void GemmAVX2(const float* pW, const float* pPanel, const int K, const float* pBias, const bool bELU,
+                     float* pOut, const size_t outStride, const int nRows, const int nCols)
+{
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+    for(int k=0; k<K; k++)
+    {
+        const __m256 b0 = _mm256_loadu_ps(pPanel);
+        const __m256 b1 = _mm256_loadu_ps(pPanel+8);
+
+        __m256 a = _mm256_broadcast_ss(pW);
+        c00 = _mm256_fmadd_ps(a,b0,c00);
+        c01 = _mm256_fmadd_ps(a,b1,c01);
+        a = _mm256_broadcast_ss(pW+1);
+        c10 = _mm256_fmadd_ps(a,b0,c10);
+        c11 = _mm256_fmadd_ps(a,b1,c11);
+        a = _mm256_broadcast_ss(pW+2);
+        c20 = _mm256_fmadd_ps(a,b0,c20);
+        c21 = _mm256_fmadd_ps(a,b1,c21);
+        a = _mm256_broadcast_ss(pW+3);
+        c30 = _mm256_fmadd_ps(a,b0,c30);
+        c31 = _mm256_fmadd_ps(a,b1,c31);
+
+        pW += BLOCK_SIZE;
+        pPanel += PANEL_SIZE;
+    }
+
+    __m256 c[BLOCK_SIZE][2] = {{c00,c01},{c10,c11},{c20,c21},{c30,c31}};
+
+    for(int r=0; r<nRows; r++)
+    {
+        const __m256 bias = _mm256_set1_ps(pBias[r]);
+        const __m256 v0 = BiasELUAVX2(c[r][0],bias,bELU);
+        const __m256 v1 = BiasELUAVX2(c[r][1],bias,bELU);
+        float* out = pOut+r*outStride;
+        if(nCols==PANEL_SIZE)
+        {
+            _mm256_storeu_ps(out,v0);
+            _mm256_storeu_ps(out+8,v1);
+        }
+        else
+        {
+            float tmp[PANEL_SIZE];
+            _mm256_storeu_ps(tmp,v0);
+            _mm256_storeu_ps(tmp+8,v1);
+            memcpy(out,tmp,nCols*sizeof(float));
+        }
+    }
+}
+
+// INT8: vpmaddwd multiplies the (k, k+1) pairs of 8 pixels by the pair of weights of a channel
+
+// Rescales the 32 bit accumulators of a 4x16 block to float and applies bias and ELU
+__attribute__((target("avx2,fma")))
+static inline void StoreIntBlockAVX2(const __m256i c[BLOCK_SIZE][2], const float* pScale, const int* pOffset,
+                                     const float* pBias, const bool bELU, float* pOut, const size_t outStride,
+                                     const int nRows, const int nCols)
+{
+    for(int r=0; r<nRows; r++)
+    {
+        const __m256i offset = _mm256_set1_epi32(pOffset[r]);
+        const __m256 scale = _mm256_set1_ps(pScale[r]);
+        const __m256 bias = _mm256_set1_ps(pBias[r]);
+        const __m256 a0 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(c[r][0],offset)),scale);
+        const __m256 a1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(c[r][1],offset)),scale);
+        const __m256 v0 = BiasELUAVX2(a0,bias,bELU);
+        const __m256 v1 = BiasELUAVX2(a1,bias,bELU);
+        float* out = pOut+r*outStride;
+        if(nCols==PANEL_SIZE)
+        {
+            _mm256_storeu_ps(out,v0);
+            _mm256_storeu_ps(out+8,v1);
+        }
+        else
+        {
+            float tmp[PANEL_SIZE];
+            _mm256_storeu_ps(tmp,v0);
+            _mm256_storeu_ps(tmp+8,v1);
+            memcpy(out,tmp,nCols*sizeof(float));
+        }
+    }
+}
+
+// INT8: 4x16 block, vpmaddwd multiplies the (k,k+1) pairs of 8 pixels and adds them to 32 bit
+__attribute__((target("avx2,fma")))
+static void GemmIntAVX2(const short* pW, const short* pPanel, const int nPairs, const float* pScale,
+                        const int* pOffset, const float* pBias, const bool bELU,
+                        float* pOut, const size_t outStride, const int nRows, const int nCols)
+{
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+
+    // The weight pair (k,k+1) of a row is broadcast as one 32 bit value
+    const float* pW32 = reinterpret_cast<const float*>(pW);
+
+    for(int k=0; k<nPairs; k++)
+    {
+        const __m256i b0 = _mm256_loadu_si256((const __m256i*)pPanel);
+        const __m256i b1 = _mm256_loadu_si256((const __m256i*)(pPanel+16));
+
+        __m256i a = _mm256_castps_si256(_mm256_broadcast_ss(pW32));
+        c00 = _mm256_add_epi32(c00,_mm256_madd_epi16(a,b0));
+        c01 = _mm256_add_epi32(c01,_mm256_madd_epi16(a,b1));
+        a = _mm256_castps_si256(_mm256_broadcast_ss(pW32+1));
+        c10 = _mm256_add_epi32(c10,_mm256_madd_epi16(a,b0));
+        c11 = _mm256_add_epi32(c11,_mm256_madd_epi16(a,b1));
+        a = _mm256_castps_si256(_mm256_broadcast_ss(pW32+2));
+        c20 = _mm256_add_epi32(c20,_mm256_madd_epi16(a,b0));
+        c21 = _mm256_add_epi32(c21,_mm256_madd_epi16(a,b1));
+        a = _mm256_castps_si256(_mm256_broadcast_ss(pW32+3));
+        c30 = _mm256_add_epi32(c30,_mm256_madd_epi16(a,b0));
+        c31 = _mm256_add_epi32(c31,_mm256_madd_epi16(a,b1));
+
+        pW32 += BLOCK_SIZE;
+        pPanel += 2*PANEL_SIZE;
+    }
+
+    const __m256i c[BLOCK_SIZE][2] = {{c00,c01},{c10,c11},{c20,c21},{c30,c31}};
+    StoreIntBlockAVX2(c,pScale,pOffset,pBias,bELU,pOut,outStride,nRows,nCols);
+}
+
+#ifdef GCN_VNNI_KERNELS
+// Same as GemmIntAVX2 with the multiply-add and the accumulation fused in vpdpwssd
+__attribute__((target("avx2,fma,avxvnni")))
+static void GemmIntVNNI(const short* pW, const short* pPanel, const int nPairs, const float* pScale,
+                        const int* pOffset, const float* pBias, const bool bELU,
+                        float* pOut, const size_t outStride, const int nRows, const int nCols)
+{
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+
+    // The weight pair (k,k+1) of a row is broadcast as one 32 bit value
+    const float* pW32 = reinterpret_cast<const float*>(pW);
+
+    for(int k=0; k<nPairs; k++)
+    {
+        const __m256i b0 = _mm256_loadu_si256((const __m256i*)pPanel);
+        const __m256i b1 = _mm256_loadu_si256((const __m256i*)(pPanel+16));
+
+        __m256i a = _mm256_castps_si256(_mm256_broadcast_ss(pW32));
+        c00 = _mm256_dpwssd_avx_epi32(c00,a,b0);
+        c01 = _mm256_dpwssd_avx_epi32(c01,a,b1);
+        a = _mm256_castps_si256(_mm256_broadcast_ss(pW32+1));
+        c10 = _mm256_dpwssd_avx_epi32(c10,a,b0);
+        c11 = _mm256_dpwssd_avx_epi32(c11,a,b1);
+        a = _mm256_castps_si256(_mm256_broadcast_ss(pW32+2));
+        c20 = _mm256_dpwssd_avx_epi32(c20,a,b0);
+        c21 = _mm256_dpwssd_avx_epi32(c21,a,b1);
+        a = _mm256_castps_si256(_mm256_broadcast_ss(pW32+3));
+        c30 = _mm256_dpwssd_avx_epi32(c30,a,b0);
+        c31 = _mm256_dpwssd_avx_epi32(c31,a,b1);
+
+        pW32 += BLOCK_SIZE;
+        pPanel += 2*PANEL_SIZE;
+    }
+
+    const __m256i c[BLOCK_SIZE][2] = {{c00,c01},{c10,c11},{c20,c21},{c30,c31}};
+    StoreIntBlockAVX2(c,pScale,pOffset,pBias,bELU,pOut,outStride,nRows,nCols);
+}
+#endif
+
+// Values are in [0,255], so row 2i+1 is shifted to the upper 16 bits of each 32 bit pair
+__attribute__((target("avx2,fma")))
+static void QuantizeAVX2(const float* pPanel, const int K, const float invScale, const float zero, short* pDst)
+{
+    const __m256 s = _mm256_set1_ps(invScale);
+    const __m256 z = _mm256_set1_ps(zero);
+    const __m256 lo = _mm256_setzero_ps();
+    const __m256 hi = _mm256_set1_ps(255.f);
+
+    for(int k=0; k<K; k+=2)
+    {
+        const float* pRow0 = pPanel+k*PANEL_SIZE;
+        const float* pRow1 = pRow0+PANEL_SIZE;
+        for(int j=0; j<PANEL_SIZE; j+=8)
+        {
+            const __m256 a0 = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(_mm256_loadu_ps(pRow0+j),s,z),lo),hi);
+            __m256i q = _mm256_cvtps_epi32(a0);
+            if(k+1<K)
+            {
+                const __m256 a1 = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(_mm256_loadu_ps(pRow1+j),s,z),lo),hi);
+                q = _mm256_or_si256(q,_mm256_slli_epi32(_mm256_cvtps_epi32(a1),16));
+            }
+            _mm256_storeu_si256((__m256i*)(pDst+2*j),q);
+        }
+        pDst += 2*PANEL_SIZE;
+    }
+}
+
+__attribute__((target("avx2,f16c")))
+static void HalfToFloatAVX2(const unsigned short* pSrc, float* pDst, const size_t n)
+{
+    size_t i=0;
+    for(; i+8<=n; i+=8)
+        _mm256_storeu_ps(pDst+i,_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(pSrc+i))));
+    for(; i<n; i++)
+        pDst[i] = HalfToFloat(pSrc[i]);
+}
+
+#endif
+
+struct GemmKernel
+{
+    GCNNetwork::Kernel kernel;
+    GemmFunc gemm;
+    GemmIntFunc gemmInt;
+    HalfToFloatFunc halfToFloat;
+    QuantizeFunc quantize;
+};
+
+static GemmKernel GetGemmKernel(GCNNetwork::Kernel kernel)
+{
+    GemmKernel k;
+    k.kernel = kernel;
+    k.gemm = GemmScalar;
+    k.gemmInt = GemmIntScalar;
+    k.halfToFloat = HalfToFloatScalar;
+    k.quantize = QuantizeScalar;
+
+#ifdef GCN_X86_KERNELS
+    if(kernel==GCNNetwork::AVX2)
+    {
+        k.gemm = GemmAVX2;
+        k.gemmInt = GemmIntAVX2;
+        k.halfToFloat = HalfToFloatAVX2;
+        k.quantize = QuantizeAVX2;
+    }
+#endif
+#ifdef GCN_VNNI_KERNELS
+    if(kernel==GCNNetwork::AVX_VNNI)
+    {
+        k.gemm = GemmAVX2;
+        k.gemmInt = GemmIntVNNI;
+        k.halfToFloat = HalfToFloatAVX2;
+        k.quantize = QuantizeAVX2;
+    }
+#endif
+
+    return k;
+}
+
+static GemmKernel SelectGemmKernel()
+{
+    if(GCNNetwork::IsSupported(GCNNetwork::AVX_VNNI))
+        return GetGemmKernel(GCNNetwork::AVX_VNNI);
+
+    if(GCNNetwork::IsSupported(GCNNetwork::AVX2))
+        return GetGemmKernel(GCNNetwork::AVX2);
+
+    return GetGemmKernel(GCNNetwork::SCALAR);
+}
+
+// Selected on first use, so static initializers of other translation units can call it too
+static GemmKernel& SelectedGemmKernel()
+{
+    static GemmKernel kernel = SelectGemmKernel();
+    return kernel;
+}
+
+bool GCNNetwork::IsSupported(Kernel kernel)
+{
+    if(kernel==SCALAR)
+        return true;
+
+#ifdef GCN_X86_KERNELS
+    __builtin_cpu_init();
+    if(kernel==AVX2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+#endif
+#ifdef GCN_VNNI_KERNELS
+    if(kernel==AVX_VNNI)
+        return IsSupported(AVX2) && __builtin_cpu_supports("avxvnni");
+#endif
+
+    return false;
+}
+
+GCNNetwork::Kernel GCNNetwork::GetKernel()
+{
+    return SelectedGemmKernel().kernel;
+}
+
+const char* GCNNetwork::GetKernelName(Kernel kernel)
+{
+    switch(kernel)
+    {
+    case SCALAR:
+        return "scalar";
+    case AVX2:
+        return "avx2";
+    case AVX_VNNI:
+        return "avx-vnni";
+    }
+    return "unknown";
+}
+
+bool GCNNetwork::SetKernel(Kernel kernel)
+{
+    if(!IsSupported(kernel))
+        return false;
+
+    SelectedGemmKernel() = GetGemmKernel(kernel);
+    return true;
+}
+
+GCNNetwork::GCNNetwork(int width, int height, int nThreads, float detThreshold):
+    mnWidth(width), mnHeight(height), mnThreads(nThreads), mfDetThreshold(detThreshold), mbLoaded(false),
+    mPrecision(FP32), mbCalibrated(false), mbCalibrating(false), mnBatchCapacity(0),
+    mnActivationSize(0), mnEncoderSize(0), mnPanelsSize(0), mnPanelsIntSize(0),
+    mpJob(static_cast<const std::function<void(int)>*>(NULL)), mnJob(0), mnPending(0), mbFinish(false)
+{
+    if(mnThreads<=0)
+        mnThreads = max((int)thread::hardware_concurrency(),1);
+
+    for(int i=1; i<mnThreads; i++)
+        mvpWorkers.push_back(new thread(&GCNNetwork::Worker,this,i));
+}
+
+GCNNetwork::~GCNNetwork()
+{
+    {
+        unique_lock<mutex> lock(mMutexWorkers);
+        mbFinish = true;
+    }
+    mCondWork.notify_all();
+
+    for(size_t i=0; i<mvpWorkers.size(); i++)
+    {
+        mvpWorkers[i]->join();
+        delete mvpWorkers[i];
+    }
+}
+
+void GCNNetwork::Worker(const int i)
+{
+    unsigned long nJob = 0;
+    while(1)
+    {
+        const std::function<void(int)>* pJob;
+        {
+            unique_lock<mutex> lock(mMutexWorkers);
+            while(mnJob==nJob && !mbFinish)
+                mCondWork.wait(lock);
+
+            if(mbFinish)
+                return;
+
+            nJob = mnJob;
+            pJob = mpJob;
+        }
+
+        (*pJob)(i);
+
+        unique_lock<mutex> lock(mMutexWorkers);
+        if(--mnPending==0)
+            mCondDone.notify_one();
+    }
+}
+
+void GCNNetwork::Parallel(const std::function<void(int)> &job)
+{
+    if(mnThreads==1)
+    {
+        job(0);
+        return;
+    }
+
+    {
+        unique_lock<mutex> lock(mMutexWorkers);
+        mpJob = &job;
+        mnPending = mnThreads-1;
+        mnJob++;
+    }
+    mCondWork.notify_all();
+
+    job(0);
+
+    unique_lock<mutex> lock(mMutexWorkers);
+    while(mnPending>0)
+        mCondDone.wait(lock);
+}
+
+bool GCNNetwork::IsWeightFile(const string &strFile)
+{
+    ifstream f(strFile.c_str(), ios::in | ios::binary);
+    char magic[4];
+    if(!f.read(magic,4))
+        return false;
+    return memcmp(magic,WEIGHT_FILE_MAGIC,4)==0;
+}
+
+template<typename T>
+static bool Read(ifstream &f, T* p, const size_t n)
+{
+    return (bool)f.read(reinterpret_cast<char*>(p),n*sizeof(T));
+}
+
+bool GCNNetwork::Load(const string &strFile)
+{
+    mbLoaded = false;
+    mPrecision = FP32;
+    mbCalibrated = false;
+
+    if(mnWidth%CELL_SIZE!=0 || mnHeight%CELL_SIZE!=0)
+    {
+        cerr << "GCNNetwork: input size must be a multiple of " << CELL_SIZE << endl;
+        return false;
+    }
+
+    ifstream f(strFile.c_str(), ios::in | ios::binary);
+    if(!f.is_open())
+    {
+        cerr << "GCNNetwork: failed to open " << strFile << endl;
+        return false;
+    }
+
+    char magic[4];
+    int32_t version, nLayers;
+    if(!Read(f,magic,4) || memcmp(magic,WEIGHT_FILE_MAGIC,4)!=0 || !Read(f,&version,1) || !Read(f,&nLayers,1) ||
+       version!=WEIGHT_FILE_VERSION || nLayers!=N_LAYERS)
+    {
+        cerr << "GCNNetwork: " << strFile << " is not a GCNv2 weight file (version " << WEIGHT_FILE_VERSION << ")" << endl;
+        return false;
+    }
+
+    mvLayers.resize(N_LAYERS);
+
+    size_t maxActivation = 0;
+    size_t maxPanels = 0;
+    int h = mnHeight, w = mnWidth;
+    int hEncoder = 0, wEncoder = 0;
+
+    for(int l=0; l<N_LAYERS; l++)
+    {
+        Layer &layer = mvLayers[l];
+
+        int32_t nameLength;
+        int32_t header[5];
+        if(!Read(f,&nameLength,1) || nameLength<=0 || nameLength>64)
+        {
+            cerr << "GCNNetwork: corrupted weight file " << strFile << endl;
+            return false;
+        }
+        vector<char> vName(nameLength);
+        if(!Read(f,&vName[0],nameLength) || !Read(f,header,5))
+        {
+            cerr << "GCNNetwork: corrupted weight file " << strFile << endl;
+            return false;
+        }
+
+        layer.name = string(vName.begin(),vName.end());
+        layer.nOut = header[0];
+        layer.nIn = header[1];
+        layer.kernel = header[2];
+        layer.stride = header[3];
+        layer.pad = header[4];
+        layer.bELU = layer.name!="convF_2" && layer.name!="convD_2";
+        layer.inputMin = numeric_limits<float>::max();
+        layer.inputMax = -numeric_limits<float>::max();
+        layer.inputScale = 1.f;
+        layer.inputZero = 0;
+
+        // Each layer reads the previous one, except the two heads which read the encoder
+        const int nInExpected = l==0 ? 1 : (l==6 || l==8) ? mvLayers[5].nOut : mvLayers[l-1].nOut;
+        if(layer.name!=LAYER_NAMES[l] || layer.nIn!=nInExpected || layer.nOut<=0 || layer.kernel<=0 || layer.stride<=0)
+        {
+            cerr << "GCNNetwork: unexpected layer " << layer.name << " in " << strFile << endl;
+            return false;
+        }
+
+        const int K = layer.nIn*layer.kernel*layer.kernel;
+        vector<float> vWeights(layer.nOut*K);
+        layer.vBias.assign(((layer.nOut+BLOCK_SIZE-1)/BLOCK_SIZE)*BLOCK_SIZE,0.f);
+        if(!Read(f,&vWeights[0],vWeights.size()) || !Read(f,&layer.vBias[0],layer.nOut))
+        {
+            cerr << "GCNNetwork: truncated weight file " << strFile << endl;
+            return false;
+        }
+
+        // Interleave blocks of output channels so the GEMM kernel reads one stream
+        const int nBlocks = (layer.nOut+BLOCK_SIZE-1)/BLOCK_SIZE;
+        layer.vWeights.assign(nBlocks*K*BLOCK_SIZE,0.f);
+        for(int o=0; o<layer.nOut; o++)
+        {
+            float* pDst = &layer.vWeights[(o/BLOCK_SIZE)*K*BLOCK_SIZE+o%BLOCK_SIZE];
+            const float* pSrc = &vWeights[o*K];
+            for(int k=0; k<K; k++)
+                pDst[k*BLOCK_SIZE] = pSrc[k];
+        }
+
+        if(l==6 || l==8)
+        {
+            h = hEncoder;
+            w = wEncoder;
+        }
+
+        h = (h+2*layer.pad-layer.kernel)/layer.stride+1;
+        w = (w+2*layer.pad-layer.kernel)/layer.stride+1;
+        if(h<=0 || w<=0)
+        {
+            cerr << "GCNNetwork: input too small for layer " << layer.name << endl;
+            return false;
+        }
+
+        if(l==5)
+        {
+            hEncoder = h;
+            wEncoder = w;
+        }
+
+        maxActivation = max(maxActivation,(size_t)layer.nOut*h*w);
+        maxPanels = max(maxPanels,(size_t)((h*w+PANEL_SIZE-1)/PANEL_SIZE)*PANEL_SIZE*K);
+    }
+
+    if(hEncoder*CELL_SIZE!=mnHeight || wEncoder*CELL_SIZE!=mnWidth ||
+       mvLayers[7].nOut!=DESCRIPTOR_CHANNELS || mvLayers[9].nOut!=CELL_SIZE*CELL_SIZE)
+    {
+        cerr << "GCNNetwork: " << strFile << " does not have the GCNv2 output layout" << endl;
+        return false;
+    }
+
+    mnActivationSize = maxActivation;
+    mnEncoderSize = (size_t)mvLayers[5].nOut*hEncoder*wEncoder;
+    mnPanelsSize = maxPanels;
+    mnPanelsIntSize = 0;
+    mvPanelsInt.clear();
+    mvWeightsFloat.clear();
+
+    mDetectionMap.create(mnHeight,mnWidth,CV_32F);
+    mDescriptorMap.create(DESCRIPTOR_CHANNELS,hEncoder*wEncoder,CV_32F);
+
+    mnBatchCapacity = 0;
+    Reserve(1);
+
+    mbLoaded = true;
+    return true;
+}
+
+void GCNNetwork::Reserve(const int nImages)
+{
+    if(nImages<=mnBatchCapacity)
+        return;
+
+    const size_t nCells = (size_t)(mnHeight/CELL_SIZE)*(mnWidth/CELL_SIZE);
+    mvInput.resize((size_t)nImages*mnWidth*mnHeight);
+    mvBufferA.resize(nImages*mnActivationSize);
+    mvBufferB.resize(nImages*mnActivationSize);
+    mvEncoder.resize(nImages*mnEncoderSize);
+    mvPanels.resize(nImages*mnPanelsSize);
+    mvPanelsInt.resize(nImages*mnPanelsIntSize);
+    mvCellDescriptors.resize(nImages*nCells*DESCRIPTOR_CHANNELS);
+    mnBatchCapacity = nImages;
+}
+
+void GCNNetwork::Im2Col(const Layer &layer, const float* pIn, const int inH, const int inW,
+                        const int outH, const int outW, const int p0, const int p1)
+{
+    const int k = layer.kernel;
+    const int K = layer.nIn*k*k;
+    const int outHW = outH*outW;
+    const int inHW = inH*inW;
+    const int nPanels = (outHW+PANEL_SIZE-1)/PANEL_SIZE;
+
+    for(int p=p0; p<p1; p++)
+    {
+        // Panel q of image b
+        const int b = p/nPanels;
+        const int q = p-b*nPanels;
+        const float* pImage = pIn+(size_t)b*layer.nIn*inHW;
+
+        float* pDst = &mvPanels[(size_t)p*K*PANEL_SIZE];
+        const int n = min(PANEL_SIZE,outHW-q*PANEL_SIZE);
+
+        // 1x1 convolutions read contiguous pixels
+        if(k==1 && layer.stride==1 && layer.pad==0)
+        {
+            for(int c=0; c<layer.nIn; c++, pDst+=PANEL_SIZE)
+            {
+                memcpy(pDst,pImage+c*inHW+q*PANEL_SIZE,n*sizeof(float));
+                for(int j=n; j<PANEL_SIZE; j++)
+                    pDst[j] = 0.f;
+            }
+            continue;
+        }
+
+        int iy0[PANEL_SIZE], ix0[PANEL_SIZE];
+        for(int j=0; j<PANEL_SIZE; j++)
+        {
+            if(j<n)
+            {
+                const int idx = q*PANEL_SIZE+j;
+                iy0[j] = (idx/outW)*layer.stride-layer.pad;
+                ix0[j] = (idx%outW)*layer.stride-layer.pad;
+            }
+            else
+            {
+                // Out of range for every tap, the padding column is zero
+                iy0[j] = -inH-k;
+                ix0[j] = -inW-k;
+            }
+        }
+
+        // Panels within one output row read one input row per tap, only its ends can be padding
+        const bool bSameRow = n==PANEL_SIZE && iy0[0]==iy0[PANEL_SIZE-1];
+        const int s = layer.stride;
+
+        for(int c=0; c<layer.nIn; c++)
+        {
+            const float* pChannel = pImage+c*inHW;
+            for(int ky=0; ky<k; ky++)
+            {
+                if(bSameRow)
+                {
+                    const int iy = iy0[0]+ky;
+                    if((unsigned)iy>=(unsigned)inH)
+                    {
+                        memset(pDst,0,k*PANEL_SIZE*sizeof(float));
+                        pDst += k*PANEL_SIZE;
+                        continue;
+                    }
+
+                    const float* pRow = pChannel+iy*inW;
+                    for(int kx=0; kx<k; kx++, pDst+=PANEL_SIZE)
+                    {
+                        const int ix = ix0[0]+kx;
+                        if(ix>=0 && ix0[PANEL_SIZE-1]+kx<inW)
+                        {
+                            for(int j=0; j<PANEL_SIZE; j++)
+                                pDst[j] = pRow[ix+j*s];
+                        }
+                        else
+                        {
+                            for(int j=0; j<PANEL_SIZE; j++)
+                                pDst[j] = (unsigned)(ix+j*s)<(unsigned)inW ? pRow[ix+j*s] : 0.f;
+                        }
+                    }
+                    continue;
+                }
+
+                for(int kx=0; kx<k; kx++, pDst+=PANEL_SIZE)
+                {
+                    for(int j=0; j<PANEL_SIZE; j++)
+                    {
+                        const int iy = iy0[j]+ky;
+                        const int ix = ix0[j]+kx;
+                        pDst[j] = ((unsigned)iy<(unsigned)inH && (unsigned)ix<(unsigned)inW) ? pChannel[iy*inW+ix] : 0.f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void GCNNetwork::Convolution(Layer &layer, const float* pIn, const int nImages, const int inH, const int inW, float* pOut)
+{
+    const int outH = (inH+2*layer.pad-layer.kernel)/layer.stride+1;
+    const int outW = (inW+2*layer.pad-layer.kernel)/layer.stride+1;
+    const int outHW = outH*outW;
+    const int K = layer.nIn*layer.kernel*layer.kernel;
+    const int nPanels = (outHW+PANEL_SIZE-1)/PANEL_SIZE;
+    const int nBatchPanels = nImages*nPanels;
+    const size_t outSize = (size_t)layer.nOut*outHW;
+    const int nBlocks = (layer.nOut+BLOCK_SIZE-1)/BLOCK_SIZE;
+    const int nPairs = (K+1)/2;
+    const int nThreads = mnThreads;
+    const Precision precision = mPrecision;
+
+    if(mbCalibrating)
+    {
+        const float* pEnd = pIn+(size_t)nImages*layer.nIn*inH*inW;
+        layer.inputMin = min(layer.inputMin,*min_element(pIn,pEnd));
+        layer.inputMax = max(layer.inputMax,*max_element(pIn,pEnd));
+    }
+
+    const std::function<void(int)> im2col = [&](int i)
+    {
+        const int p0 = (long)nBatchPanels*i/nThreads;
+        const int p1 = (long)nBatchPanels*(i+1)/nThreads;
+        Im2Col(layer,pIn,inH,inW,outH,outW,p0,p1);
+        if(precision==INT8)
+            QuantizePanels(layer,p0,p1);
+    };
+    Parallel(im2col);
+
+    // Output channels are split among threads. Each panel is reused by all blocks of a thread and
+    // the weights of a thread are expanded once for the whole batch.
+    const GemmFunc gemm = SelectedGemmKernel().gemm;
+    const GemmIntFunc gemmInt = SelectedGemmKernel().gemmInt;
+    const HalfToFloatFunc halfToFloat = SelectedGemmKernel().halfToFloat;
+    const std::function<void(int)> gemmBlocks = [&](int i)
+    {
+        const int b0 = (long)nBlocks*i/nThreads;
+        const int b1 = (long)nBlocks*(i+1)/nThreads;
+        const size_t blockSize = (size_t)K*BLOCK_SIZE;
+
+        // FP16 weights of the blocks of this thread are expanded right before use
+        const float* pWeights = &layer.vWeights[0];
+        if(precision==FP16)
+        {
+            halfToFloat(&layer.vWeightsHalf[b0*blockSize],&mvWeightsFloat[b0*blockSize],(b1-b0)*blockSize);
+            pWeights = &mvWeightsFloat[0];
+        }
+
+        for(int p=0; p<nBatchPanels; p++)
+        {
+            const int q = p%nPanels;
+            float* pImageOut = pOut+(p/nPanels)*outSize+q*PANEL_SIZE;
+            const int nCols = min(PANEL_SIZE,outHW-q*PANEL_SIZE);
+            if(precision==INT8)
+            {
+                const short* pPanel = &mvPanelsInt[(size_t)p*nPairs*2*PANEL_SIZE];
+                for(int b=b0; b<b1; b++)
+                {
+                    gemmInt(&layer.vWeightsInt[(size_t)b*nPairs*2*BLOCK_SIZE],pPanel,nPairs,
+                            &layer.vScale[b*BLOCK_SIZE],&layer.vOffset[b*BLOCK_SIZE],&layer.vBias[b*BLOCK_SIZE],layer.bELU,
+                            pImageOut+(size_t)b*BLOCK_SIZE*outHW,outHW,min(BLOCK_SIZE,layer.nOut-b*BLOCK_SIZE),nCols);
+                }
+                continue;
+            }
+
+            const float* pPanel = &mvPanels[(size_t)p*K*PANEL_SIZE];
+            for(int b=b0; b<b1; b++)
+            {
+                gemm(pWeights+b*blockSize,pPanel,K,&layer.vBias[b*BLOCK_SIZE],layer.bELU,
+                     pImageOut+(size_t)b*BLOCK_SIZE*outHW,outHW,min(BLOCK_SIZE,layer.nOut-b*BLOCK_SIZE),nCols);
+            }
+        }
+    };
+    Parallel(gemmBlocks);
+}
+
+void GCNNetwork::QuantizePanels(const Layer &layer, const int p0, const int p1)
+{
+    const int K = layer.nIn*layer.kernel*layer.kernel;
+    const int nPairs = (K+1)/2;
+    const QuantizeFunc quantize = SelectedGemmKernel().quantize;
+
+    // The zero point is exact, so padding stays exactly zero after quantization
+    for(int p=p0; p<p1; p++)
+        quantize(&mvPanels[(size_t)p*K*PANEL_SIZE],K,1.f/layer.inputScale,(float)layer.inputZero,
+                 &mvPanelsInt[(size_t)p*nPairs*2*PANEL_SIZE]);
+}
+
+void GCNNetwork::QuantizeWeights(Layer &layer)
+{
+    const int K = layer.nIn*layer.kernel*layer.kernel;
+    const int nPairs = (K+1)/2;
+    const int nBlocks = (layer.nOut+BLOCK_SIZE-1)/BLOCK_SIZE;
+
+    // 8 bit input in [0,255] with the calibrated range (which always contains 0)
+    const float inputMin = min(layer.inputMin,0.f);
+    const float inputMax = max(layer.inputMax,0.f);
+    layer.inputScale = max(inputMax-inputMin,1e-6f)/255.f;
+    layer.inputZero = (int)floor(-inputMin/layer.inputScale+0.5f);
+
+    layer.vWeightsInt.assign((size_t)nBlocks*nPairs*2*BLOCK_SIZE,0);
+    layer.vScale.assign(nBlocks*BLOCK_SIZE,0.f);
+    layer.vOffset.assign(nBlocks*BLOCK_SIZE,0);
+
+    for(int o=0; o<layer.nOut; o++)
+    {
+        const int b = o/BLOCK_SIZE;
+        const int r = o%BLOCK_SIZE;
+        const float* pW = &layer.vWeights[(size_t)b*K*BLOCK_SIZE+r];
+
+        float maxAbs = 0.f;
+        for(int k=0; k<K; k++)
+            maxAbs = max(maxAbs,fabs(pW[k*BLOCK_SIZE]));
+        const float scale = maxAbs>0.f ? maxAbs/127.f : 1.f;
+
+        int sum = 0;
+        short* pDst = &layer.vWeightsInt[(size_t)b*nPairs*2*BLOCK_SIZE+2*r];
+        for(int k=0; k<K; k++)
+        {
+            const short q = (short)lrintf(pW[k*BLOCK_SIZE]/scale);
+            pDst[(k/2)*2*BLOCK_SIZE+(k%2)] = q;
+            sum += q;
+        }
+
+        layer.vScale[o] = scale*layer.inputScale;
+        layer.vOffset[o] = sum*layer.inputZero;
+    }
+}
+
+bool GCNNetwork::SetPrecision(Precision precision)
+{
+    if(!mbLoaded || precision==mPrecision)
+        return mbLoaded;
+
+    if(mPrecision!=FP32)
+    {
+        cerr << "GCNNetwork: the precision can only be reduced once after loading" << endl;
+        return false;
+    }
+
+    if(precision==INT8 && !mbCalibrated)
+    {
+        cerr << "GCNNetwork: INT8 needs a calibration" << endl;
+        return false;
+    }
+
+    size_t maxWeights = 0;
+    size_t maxPanels = 0;
+    int h = mnHeight, w = mnWidth;
+    int hEncoder = 0, wEncoder = 0;
+
+    for(int l=0; l<N_LAYERS; l++)
+    {
+        Layer &layer = mvLayers[l];
+        const int K = layer.nIn*layer.kernel*layer.kernel;
+
+        if(l==6 || l==8)
+        {
+            h = hEncoder;
+            w = wEncoder;
+        }
+        h = (h+2*layer.pad-layer.kernel)/layer.stride+1;
+        w = (w+2*layer.pad-layer.kernel)/layer.stride+1;
+        if(l==5)
+        {
+            hEncoder = h;
+            wEncoder = w;
+        }
+
+        maxWeights = max(maxWeights,layer.vWeights.size());
+        maxPanels = max(maxPanels,(size_t)((h*w+PANEL_SIZE-1)/PANEL_SIZE)*PANEL_SIZE*((K+1)/2)*2);
+
+        if(precision==FP16)
+        {
+            layer.vWeightsHalf.resize(layer.vWeights.size());
+            for(size_t i=0; i<layer.vWeights.size(); i++)
+                layer.vWeightsHalf[i] = FloatToHalf(layer.vWeights[i]);
+        }
+        else
+            QuantizeWeights(layer);
+
+        vector<float>().swap(layer.vWeights);
+    }
+
+    if(precision==FP16)
+        mvWeightsFloat.resize(maxWeights);
+    else
+    {
+        mnPanelsIntSize = maxPanels;
+        mvPanelsInt.resize(mnBatchCapacity*mnPanelsIntSize);
+    }
+
+    mPrecision = precision;
+    return true;
+}
+
+void GCNNetwork::Calibrate(const vector<cv::Mat> &vImages)
+{
+    if(!mbLoaded || mPrecision!=FP32)
+    {
+        cerr << "GCNNetwork: calibration needs the FP32 network" << endl;
+        return;
+    }
+
+    for(int l=0; l<N_LAYERS; l++)
+    {
+        mvLayers[l].inputMin = numeric_limits<float>::max();
+        mvLayers[l].inputMax = -numeric_limits<float>::max();
+    }
+
+    cv::Mat pts, desc;
+    mbCalibrating = true;
+    for(size_t i=0; i<vImages.size(); i++)
+        (*this)(vImages[i],pts,desc);
+    mbCalibrating = false;
+
+    mbCalibrated = !vImages.empty();
+}
+
+bool GCNNetwork::SaveCalibration(const string &strFile)
+{
+    if(!mbCalibrated)
+        return false;
+
+    cv::FileStorage fs(strFile, cv::FileStorage::WRITE);
+    if(!fs.isOpened())
+    {
+        cerr << "GCNNetwork: failed to write " << strFile << endl;
+        return false;
+    }
+
+    // Input range of each layer
+    for(int l=0; l<N_LAYERS; l++)
+        fs << mvLayers[l].name << "[" << mvLayers[l].inputMin << mvLayers[l].inputMax << "]";
+
+    return true;
+}
+
+bool GCNNetwork::LoadCalibration(const string &strFile)
+{
+    cv::FileStorage fs(strFile, cv::FileStorage::READ);
+    if(!mbLoaded || !fs.isOpened())
+    {
+        cerr << "GCNNetwork: failed to read calibration " << strFile << endl;
+        return false;
+    }
+
+    for(int l=0; l<N_LAYERS; l++)
+    {
+        cv::FileNode node = fs[mvLayers[l].name];
+        if(node.type()!=cv::FileNode::SEQ || node.size()!=2)
+        {
+            cerr << "GCNNetwork: no range for " << mvLayers[l].name << " in " << strFile << endl;
+            return false;
+        }
+        mvLayers[l].inputMin = (float)node[0];
+        mvLayers[l].inputMax = (float)node[1];
+    }
+
+    mbCalibrated = true;
+    return true;
+}
+
+bool GCNNetwork::ParsePrecision(const string &str, Precision &precision)
+{
+    if(str.empty() || str=="fp32" || str=="FP32")
+        precision = FP32;
+    else if(str=="fp16" || str=="FP16")
+        precision = FP16;
+    else if(str=="int8" || str=="INT8")
+        precision = INT8;
+    else
+        return false;
+    return true;
+}
+
+const char* GCNNetwork::GetPrecisionName(Precision precision)
+{
+    switch(precision)
+    {
+    case FP32:
+        return "fp32";
+    case FP16:
+        return "fp16";
+    case INT8:
+        return "int8";
+    }
+    return "unknown";
+}
+
+void GCNNetwork::Binarize(const float* pDesc, unsigned char* pBits)
+{
+    for(int i=0; i<DESCRIPTOR_CHANNELS/8; i++)
+    {
+        unsigned char byte = 0;
+        for(int j=0; j<8; j++)
+            if(pDesc[8*i+j]>0.f)
+                byte |= (unsigned char)(1<<j);
+        pBits[i] = byte;
+    }
+}
+
+void GCNNetwork::operator()(const cv::Mat &input, cv::Mat &pts, cv::Mat &desc)
+{
+    vector<cv::Mat> vInputs(1,input), vPts(1,pts), vDesc(1,desc);
+    (*this)(vInputs,vPts,vDesc);
+    pts = vPts[0];
+    desc = vDesc[0];
+}
+
+void GCNNetwork::operator()(const vector<cv::Mat> &vInputs, vector<cv::Mat> &vPts, vector<cv::Mat> &vDesc)
+{
+    CV_Assert(mbLoaded);
+
+    const int nImages = vInputs.size();
+    vPts.resize(nImages);
+    vDesc.resize(nImages);
+    if(nImages==0)
+        return;
+
+    Reserve(nImages);
+
+    // The images of the batch are stored one after the other in every buffer
+    const size_t imageSize = (size_t)mnWidth*mnHeight;
+    for(int b=0; b<nImages; b++)
+    {
+        const cv::Mat &input = vInputs[b];
+        CV_Assert(input.type()==CV_32FC1 && input.cols==mnWidth && input.rows==mnHeight);
+        for(int v=0; v<mnHeight; v++)
+            memcpy(&mvInput[b*imageSize+v*mnWidth],input.ptr<float>(v),mnWidth*sizeof(float));
+    }
+
+    // Encoder
+    const float* pIn = &mvInput[0];
+    float* pBuffers[2] = {&mvBufferA[0], &mvBufferB[0]};
+    int h = mnHeight, w = mnWidth;
+    for(int l=0; l<6; l++)
+    {
+        Layer &layer = mvLayers[l];
+        float* pOut = l==5 ? &mvEncoder[0] : pBuffers[l%2];
+        Convolution(layer,pIn,nImages,h,w,pOut);
+        h = (h+2*layer.pad-layer.kernel)/layer.stride+1;
+        w = (w+2*layer.pad-layer.kernel)/layer.stride+1;
+        pIn = pOut;
+    }
+
+    const int nCells = h*w;
+    const int hCells = h;
+    const int wCells = w;
+
+    // Descriptor head, L2 normalized per cell
+    Convolution(mvLayers[6],&mvEncoder[0],nImages,hCells,wCells,pBuffers[0]);
+    Convolution(mvLayers[7],pBuffers[0],nImages,hCells,wCells,pBuffers[1]);
+
+    for(int b=0; b<nImages; b++)
+    {
+        const float* pDescRaw = pBuffers[1]+(size_t)b*DESCRIPTOR_CHANNELS*nCells;
+        const bool bLast = b==nImages-1;
+        for(int i=0; i<nCells; i++)
+        {
+            float norm = 0.f;
+            for(int c=0; c<DESCRIPTOR_CHANNELS; c++)
+                norm += pDescRaw[c*nCells+i]*pDescRaw[c*nCells+i];
+            norm = norm>0.f ? 1.f/sqrt(norm) : 0.f;
+
+            float* pCell = &mvCellDescriptors[((size_t)b*nCells+i)*DESCRIPTOR_CHANNELS];
+            for(int c=0; c<DESCRIPTOR_CHANNELS; c++)
+                pCell[c] = pDescRaw[c*nCells+i]*norm;
+
+            if(bLast)
+            {
+                for(int c=0; c<DESCRIPTOR_CHANNELS; c++)
+                    mDescriptorMap.at<float>(c,i) = pCell[c];
+            }
+        }
+    }
+
+    // Detector head: sigmoid and pixel shuffle, channel i*16+j of a cell is pixel (j,i) in it
+    Convolution(mvLayers[8],&mvEncoder[0],nImages,hCells,wCells,pBuffers[0]);
+    Convolution(mvLayers[9],pBuffers[0],nImages,hCells,wCells,pBuffers[1]);
+
+    for(int b=0; b<nImages; b++)
+    {
+        const float* pDetRaw = pBuffers[1]+(size_t)b*CELL_SIZE*CELL_SIZE*nCells;
+        for(int c=0; c<CELL_SIZE*CELL_SIZE; c++)
+        {
+            const int i = c/CELL_SIZE;
+            const int j = c%CELL_SIZE;
+            for(int cy=0; cy<hCells; cy++)
+            {
+                float* pRow = mDetectionMap.ptr<float>(cy*CELL_SIZE+i)+j;
+                const float* pRaw = pDetRaw+c*nCells+cy*wCells;
+                for(int cx=0; cx<wCells; cx++)
+                    pRow[cx*CELL_SIZE] = 1.f/(1.f+expf(-pRaw[cx]));
+            }
+        }
+
+        ExtractKeypoints(&mvCellDescriptors[(size_t)b*nCells*DESCRIPTOR_CHANNELS],hCells,wCells,vPts[b],vDesc[b]);
+    }
+}
+
+void GCNNetwork::ExtractKeypoints(const float* pCells, const int hCells, const int wCells, cv::Mat &pts, cv::Mat &desc)
+{
+    // Keypoints in raster order
+    int N = 0;
+    for(int v=0; v<mnHeight; v++)
+    {
+        const float* pRow = mDetectionMap.ptr<float>(v);
+        for(int u=0; u<mnWidth; u++)
+            if(pRow[u]>mfDetThreshold)
+                N++;
+    }
+
+    pts.create(N,3,CV_32F);
+    desc.create(N,DESCRIPTOR_CHANNELS/8,CV_8U);
+
+    vector<float> vSample(DESCRIPTOR_CHANNELS);
+    int n = 0;
+    for(int v=0; v<mnHeight; v++)
+    {
+        const float* pRow = mDetectionMap.ptr<float>(v);
+        for(int u=0; u<mnWidth; u++)
+        {
+            if(!(pRow[u]>mfDetThreshold))
+                continue;
+
+            float* p = pts.ptr<float>(n);
+            p[0] = u;
+            p[1] = v;
+            p[2] = pRow[u];
+
+            // Bilinear interpolation between cell centres
+            const float x = min(max((u+0.5f)/CELL_SIZE-0.5f,0.f),(float)(wCells-1));
+            const float y = min(max((v+0.5f)/CELL_SIZE-0.5f,0.f),(float)(hCells-1));
+            const int x0 = (int)x;
+            const int y0 = (int)y;
+            const int x1 = min(x0+1,wCells-1);
+            const int y1 = min(y0+1,hCells-1);
+            const float ax = x-x0;
+            const float ay = y-y0;
+
+            const float* d00 = pCells+(y0*wCells+x0)*DESCRIPTOR_CHANNELS;
+            const float* d01 = pCells+(y0*wCells+x1)*DESCRIPTOR_CHANNELS;
+            const float* d10 = pCells+(y1*wCells+x0)*DESCRIPTOR_CHANNELS;
+            const float* d11 = pCells+(y1*wCells+x1)*DESCRIPTOR_CHANNELS;
+            const float w00 = (1.f-ax)*(1.f-ay), w01 = ax*(1.f-ay), w10 = (1.f-ax)*ay, w11 = ax*ay;
+            for(int c=0; c<DESCRIPTOR_CHANNELS; c++)
+                vSample[c] = w00*d00[c]+w01*d01[c]+w10*d10[c]+w11*d11[c];
+
+            Binarize(&vSample[0],desc.ptr(n));
+            n++;
+        }
+    }
+}
+
+} //namespace ORB_SLAM
@@ -59,8 +59,11 @@
 #include <opencv2/features2d/features2d.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <vector>
+#include <iostream>
 
 #include "GCNextractor.h"
+#include "ImagePreprocessing.h"
+#include "GCNInferenceService.h"
 
 
 using namespace cv;
@@ -72,94 +75,20 @@ const int PATCH_SIZE = 31;
 const int HALF_PATCH_SIZE = 15;
 const int EDGE_THRESHOLD = 19;
 
-
-void nms(cv::Mat det, cv::Mat desc, std::vector<cv::KeyPoint>& pts, cv::Mat& descriptors,
-        int border, int dist_thresh, int img_width, int img_height, float ratio_width, float ratio_height){
-
-    std::vector<cv::Point2f> pts_raw;
-
-    for (int i = 0; i < det.rows; i++){
-
-        int u = (int) det.at<float>(i, 0);
-        int v = (int) det.at<float>(i, 1);
-        // float conf = det.at<float>(i, 2);
-
-        pts_raw.push_back(cv::Point2f(u, v));
-    }
-
-    cv::Mat grid = cv::Mat(cv::Size(img_width, img_height), CV_8UC1);
-    cv::Mat inds = cv::Mat(cv::Size(img_width, img_height), CV_16UC1);
-
-    grid.setTo(0);
-    inds.setTo(0);
-
-    for (int i = 0; i < pts_raw.size(); i++)
-    {   
-        int uu = (int) pts_raw[i].x;
-        int vv = (int) pts_raw[i].y;
-
-        grid.at<char>(vv, uu) = 1;
-        inds.at<unsigned short>(vv, uu) = i;
-    }
-    
-    cv::copyMakeBorder(grid, grid, dist_thresh, dist_thresh, dist_thresh, dist_thresh, cv::BORDER_CONSTANT, 0);
-
-    for (int i = 0; i < pts_raw.size(); i++)
-    {   
-        int uu = (int) pts_raw[i].x + dist_thresh;
-        int vv = (int) pts_raw[i].y + dist_thresh;
-
-        if (grid.at<char>(vv, uu) != 1)
-            continue;
-
-        for(int k = -dist_thresh; k < (dist_thresh+1); k++)
-            for(int j = -dist_thresh; j < (dist_thresh+1); j++)
-            {
-                if(j==0 && k==0) continue;
-
-                grid.at<char>(vv + k, uu + j) = 0;
-                
-            }
-        grid.at<char>(vv, uu) = 2;
-    }
-
-    size_t valid_cnt = 0;
-    std::vector<int> select_indice;
-
-    for (int v = 0; v < (img_height + dist_thresh); v++){
-        for (int u = 0; u < (img_width + dist_thresh); u++)
-        {
-            if (u -dist_thresh>= (img_width - border) || u-dist_thresh < border || v-dist_thresh >= (img_height - border) || v-dist_thresh < border)
-            continue;
-
-            if (grid.at<char>(v,u) == 2)
-            {
-                int select_ind = (int) inds.at<unsigned short>(v-dist_thresh, u-dist_thresh);
-                pts.push_back(cv::KeyPoint(pts_raw[select_ind].x * ratio_width, pts_raw[select_ind].y * ratio_height, 1.0f));
-
-                select_indice.push_back(select_ind);
-                valid_cnt++;
-            }
-        }
-    }
-    
-    descriptors.create(select_indice.size(), 32, CV_8U);
-
-    for (int i=0; i<select_indice.size(); i++)
-    {
-        for (int j=0; j<32; j++)
-        {
-            descriptors.at<unsigned char>(i, j) = desc.at<unsigned char>(select_indice[i], j);
-        }
-    }
-}
-
+// Cells used to spread the feature budget over the image
+const int BUDGET_GRID_COLS = 8;
+const int BUDGET_GRID_ROWS = 6;
 
 
 GCNextractor::GCNextractor(int _nfeatures, float _scaleFactor, int _nlevels,
-         int _iniThFAST, int _minThFAST):
+         int _iniThFAST, int _minThFAST, const std::string &strDevice, int nThreads,
+         GCNInferenceService* pService):
     nfeatures(_nfeatures), scaleFactor(_scaleFactor), nlevels(_nlevels),
-    iniThFAST(_iniThFAST), minThFAST(_minThFAST)
+    iniThFAST(_iniThFAST), minThFAST(_minThFAST), mpNetwork(static_cast<GCNNetwork*>(NULL)),
+#ifdef WITH_TORCH
+    mDevice(torch::kCPU),
+#endif
+    mpService(pService), mpPreparedImage(static_cast<const uchar*>(NULL))
 {
     mvScaleFactor.resize(nlevels);
     mvLevelSigma2.resize(nlevels);
@@ -179,6 +108,11 @@ GCNextractor::GCNextractor(int _nfeatures, float _scaleFactor, int _nlevels,
         mvInvLevelSigma2[i]=1.0f/mvLevelSigma2[i];
     }
 
+    mScaleFactorTable = LevelTable(mvScaleFactor);
+    mInvScaleFactorTable = LevelTable(mvInvScaleFactor);
+    mLevelSigma2Table = LevelTable(mvLevelSigma2);
+    mInvLevelSigma2Table = LevelTable(mvInvLevelSigma2);
+
     mvImagePyramid.resize(nlevels);
 
     mnFeaturesPerLevel.resize(nlevels);
@@ -213,60 +147,219 @@ GCNextractor::GCNextractor(int _nfeatures, float _scaleFactor, int _nlevels,
         ++v0;
     }
 
+    mnInputWidth = 320;
+    mnInputHeight = 240;
+
+    if (getenv("FULL_RESOLUTION") != nullptr)
+    {
+        mnInputWidth = 640;
+        mnInputHeight = 480;
+    }
+
     const char *net_fn = getenv("GCN_PATH");
     net_fn = (net_fn == nullptr) ? "gcn2.pt" : net_fn;
-    module = torch::jit::load(net_fn);
 
+    if(mpService)
+    {
+        mnInputWidth = mpService->GetWidth();
+        mnInputHeight = mpService->GetHeight();
+        mpService->RegisterStream();
+    }
+    else if(GCNNetwork::IsWeightFile(net_fn))
+    {
+        mpNetwork = new GCNNetwork(mnInputWidth, mnInputHeight, nThreads);
+        if(!mpNetwork->Load(net_fn))
+            exit(-1);
+    }
+    else
+    {
+#ifdef WITH_TORCH
+        // Select inference device. Default to CUDA only if there is a GPU to run on.
+        if(strDevice=="cuda" || strDevice=="CUDA")
+            mDevice = torch::Device(torch::kCUDA);
+        else if(strDevice=="cpu" || strDevice=="CPU")
+            mDevice = torch::Device(torch::kCPU);
+        else
+            mDevice = torch::Device(torch::cuda::is_available() ? torch::kCUDA : torch::kCPU);
+
+        if(mDevice.is_cuda() && !torch::cuda::is_available())
+        {
+            cerr << "GCNextractor: CUDA requested but not available, falling back to CPU." << endl;
+            mDevice = torch::Device(torch::kCPU);
+        }
+
+        if(mDevice.is_cpu() && nThreads>0)
+            at::set_num_threads(nThreads);
+
+        // Map the weights onto the selected device, models may have been exported from a GPU.
+        module = torch::jit::load(net_fn, mDevice);
+#else
+        cerr << "GCNextractor: " << net_fn << " is not a GCNv2 weight file, and TorchScript models "
+             << "need a build with WITH_TORCH=ON." << endl;
+        exit(-1);
+#endif
+    }
+
+    // NMS border and distance scale with the input width (8 and 4 pixels at 320x240)
+    mnBorder = cvRound(8.f*mnInputWidth/320.f);
+    mnDistThresh = cvRound(4.f*mnInputWidth/320.f);
+
+    mpNMS = new NonMaxSuppression(mnInputWidth, mnInputHeight, mnDistThresh, mnBorder);
+    // All GCN keypoints are extracted at level 0, so the whole budget applies to a single image.
+    mpNMS->SetMaxFeatures(nfeatures, BUDGET_GRID_COLS, BUDGET_GRID_ROWS);
+
+    // The input tensor is allocated once and reused for every frame.
+#ifdef WITH_TORCH
+    if(!mpNetwork)
+    {
+        mInputTensor = torch::zeros({1, 1, mnInputHeight, mnInputWidth}, torch::kFloat32);
+        mInputMat = cv::Mat(mnInputHeight, mnInputWidth, CV_32FC1, mInputTensor.data<float>());
+        if(!mpService && mDevice.is_cuda())
+            mDeviceInput = mInputTensor.to(mDevice);
+        else
+            mDeviceInput = mInputTensor;
+    }
+    else
+#endif
+        mInputMat = cv::Mat(mnInputHeight, mnInputWidth, CV_32FC1);
+}
+
+GCNextractor::~GCNextractor()
+{
+    if(mpService)
+        mpService->UnregisterStream();
+    delete mpNetwork;
+    delete mpNMS;
 }
 
-void GCNextractor::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& _keypoints, OutputArray _descriptors)
-{ 
+bool GCNextractor::IsOnCPU()
+{
+    if(mpService)
+        return mpService->IsOnCPU();
+#ifdef WITH_TORCH
+    if(!mpNetwork)
+        return mDevice.is_cpu();
+#endif
+    return true;
+}
+
+int GCNextractor::GetThreads()
+{
+    if(mpService)
+        return mpService->GetThreads();
+    if(mpNetwork)
+        return mpNetwork->GetThreads();
+#ifdef WITH_TORCH
+    return at::get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+bool GCNextractor::SetPrecision(const string &strPrecision, const string &strCalibration)
+{
+    GCNNetwork::Precision precision;
+    if(!GCNNetwork::ParsePrecision(strPrecision,precision))
+    {
+        cerr << "GCNextractor: unknown precision " << strPrecision << endl;
+        return false;
+    }
+
+    if(precision==GCNNetwork::FP32)
+        return true;
+
+    if(mpService)
+        return mpService->SetPrecision(strPrecision,strCalibration);
+
+    if(!mpNetwork)
+    {
+        cerr << "GCNextractor: " << strPrecision << " needs exported weights (GCN2/export_gcn.py)" << endl;
+        return false;
+    }
+
+    if(precision==GCNNetwork::INT8 && !mpNetwork->LoadCalibration(strCalibration))
+        return false;
+
+    return mpNetwork->SetPrecision(precision);
+}
 
-    torch::DeviceType device_type;
-    device_type = torch::kCUDA;
-    torch::Device device(device_type);
+string GCNextractor::GetPrecision()
+{
+    if(mpService)
+        return mpService->GetPrecision();
+    return GCNNetwork::GetPrecisionName(mpNetwork ? mpNetwork->GetPrecision() : GCNNetwork::FP32);
+}
 
+bool GCNextractor::Preprocess(const cv::Mat &im, const bool bRGB, cv::Mat &imGray)
+{
+    const bool bNetworkSize = imGray.cols==mnInputWidth && imGray.rows==mnInputHeight;
+    float* pInput = bNetworkSize ? mInputMat.ptr<float>() : static_cast<float*>(NULL);
+
+    mpPreparedImage = static_cast<const uchar*>(NULL);
+    if(!ImagePreprocessing::ToGray(im,bRGB,imGray,pInput))
+        return false;
+
+    if(bNetworkSize)
+        mpPreparedImage = imGray.data;
+    return true;
+}
+
+void GCNextractor::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& _keypoints, OutputArray _descriptors)
+{ 
     if(_image.empty())
         return;
 
     Mat image = _image.getMat();
     assert(image.type() == CV_8UC1 );
 
-    cv::Mat img;
-    image.convertTo(img, CV_32FC1, 1.f / 255.f , 0);
+    const int img_width = mnInputWidth;
+    const int img_height = mnInputHeight;
 
-    int img_width = 320;
-    int img_height = 240;
+    float ratio_width = float(image.cols) / float(img_width);
+    float ratio_height = float(image.rows) / float(img_height);
 
-    int border = 8;
-    int dist_thresh = 4;
+    // Normalize straight into the persistent input tensor (no reallocation, no permute:
+    // a single channel HxW image has the same memory layout as 1x1xHxW).
+    if(image.data==mpPreparedImage && image.cols==img_width && image.rows==img_height)
+    {
+        // Already written by Preprocess
+    }
+    else if(image.cols==img_width && image.rows==img_height)
+    {
+        image.convertTo(mInputMat, CV_32FC1, 1.f / 255.f , 0);
+    }
+    else
+    {
+        image.convertTo(mImFloat, CV_32FC1, 1.f / 255.f , 0);
+        cv::resize(mImFloat, mInputMat, cv::Size(img_width, img_height));
+    }
+    mpPreparedImage = static_cast<const uchar*>(NULL);
 
-    if (getenv("FULL_RESOLUTION") != nullptr)
+    if(mpNetwork)
     {
-        img_width = 640;
-        img_height = 480;
+        cv::Mat pts_mat, desc_mat;
+        (*mpNetwork)(mInputMat, pts_mat, desc_mat);
+        (*mpNMS)(pts_mat, desc_mat, _keypoints, _descriptors, ratio_width, ratio_height);
+        return;
+    }
 
-        border = 16;
-        dist_thresh = 8;
+    if(mpService)
+    {
+        cv::Mat pts_mat, desc_mat;
+        mpService->Infer(mInputMat, pts_mat, desc_mat);
+        (*mpNMS)(pts_mat, desc_mat, _keypoints, _descriptors, ratio_width, ratio_height);
+        return;
     }
-    
-    float ratio_width = float(img.cols) / float(img_width);
-    float ratio_height = float(img.rows) / float(img_height);
-    
-    cv::resize(img, img, cv::Size(img_width, img_height));
-
-    #if defined(TORCH_NEW_API)
-        std::vector<int64_t> dims = {1, img_height, img_width, 1};
-        auto img_var = torch::from_blob(img.data, dims, torch::kFloat32).to(device);
-        img_var = img_var.permute({0,3,1,2});
-    #else 
-        auto img_tensor = torch::CPU(torch::kFloat32).tensorFromBlob(img.data, {1, img_height, img_width, 1});
-        img_tensor = img_tensor.permute({0,3,1,2});
-        auto img_var = torch::autograd::make_variable(img_tensor, false).to(device);
-    #endif
+
+#ifdef WITH_TORCH
+    if(mDevice.is_cuda())
+        mDeviceInput.copy_(mInputTensor);
+
+    // No autograd bookkeeping is needed for inference.
+    torch::NoGradGuard no_grad;
 
     std::vector<torch::jit::IValue> inputs;
-    inputs.push_back(img_var);
+    inputs.push_back(mDeviceInput);
     auto output = module->forward(inputs).toTuple();
 
     auto pts  = output->elements()[0].toTensor().to(torch::kCPU).squeeze();
@@ -275,21 +368,8 @@ void GCNextractor::operator()( InputArray _image, InputArray _mask, vector<KeyPo
     cv::Mat pts_mat(cv::Size(3, pts.size(0)), CV_32FC1, pts.data<float>());
     cv::Mat desc_mat(cv::Size(32, pts.size(0)), CV_8UC1, desc.data<unsigned char>());
 
-    std::vector<cv::KeyPoint> keypoints;
-    cv::Mat descriptors;
-    nms(pts_mat, desc_mat, keypoints, descriptors, border, dist_thresh, img_width, img_height, ratio_width, ratio_height);
-
-    _keypoints.insert(_keypoints.end(), keypoints.begin(), keypoints.end());
-    
-    int nkeypoints = keypoints.size();
-    _descriptors.create(nkeypoints, 32, CV_8U);
-    descriptors.copyTo(_descriptors.getMat());
-
-    // std::cout << descriptors << std::endl;
-    // std::cout << pts.size(0) << std::endl;
-    // std::cout << keypoints.size() << std::endl;
-    // cv::waitKey();
-
+    (*mpNMS)(pts_mat, desc_mat, _keypoints, _descriptors, ratio_width, ratio_height);
+#endif
 }
 
 } //namespace ORB_SLAM
@@ -0,0 +1,350 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HammingDistance.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+
+// SIMD kernels are compiled with per-function target attributes and only called if the CPU
+// supports them, so the library does not depend on the instruction set of the build machine.
+#if defined(__x86_64__) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8))
+#define HAMMING_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+// Descriptors of B per tile in DistanceMatrix (8KB, fits in L1 with the output row)
+const int TILE_SIZE = 256;
+
+typedef int (*DistanceFunc)(const unsigned char*, const unsigned char*);
+typedef void (*DistanceManyFunc)(const unsigned char*, const unsigned char*, const int, const size_t, int*);
+
+static inline uint64_t Load64(const unsigned char* p)
+{
+    uint64_t v;
+    memcpy(&v,p,sizeof(v));
+    return v;
+}
+
+// Scalar: SWAR popcount on 64 bit words
+
+static inline int PopCount64(uint64_t v)
+{
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((v * 0x0101010101010101ULL) >> 56);
+}
+
+static int DistanceScalar(const unsigned char* a, const unsigned char* b)
+{
+    return PopCount64(Load64(a) ^ Load64(b)) + PopCount64(Load64(a+8) ^ Load64(b+8)) +
+           PopCount64(Load64(a+16) ^ Load64(b+16)) + PopCount64(Load64(a+24) ^ Load64(b+24));
+}
+
+static void DistanceManyScalar(const unsigned char* a, const unsigned char* B, const int nB, const size_t strideB, int* dist)
+{
+    for(int i=0; i<nB; i++)
+        dist[i] = DistanceScalar(a,B+i*strideB);
+}
+
+#ifdef HAMMING_X86_KERNELS
+
+// SSE4.2: hardware popcnt on 64 bit words
+
+__attribute__((target("popcnt")))
+static int DistanceSSE42(const unsigned char* a, const unsigned char* b)
+{
+    return (int)(_mm_popcnt_u64(Load64(a) ^ Load64(b)) + _mm_popcnt_u64(Load64(a+8) ^ Load64(b+8)) +
+                 _mm_popcnt_u64(Load64(a+16) ^ Load64(b+16)) + _mm_popcnt_u64(Load64(a+24) ^ Load64(b+24)));
+}
+
+__attribute__((target("popcnt")))
+static void DistanceManySSE42(const unsigned char* a, const unsigned char* B, const int nB, const size_t strideB, int* dist)
+{
+    const uint64_t a0 = Load64(a);
+    const uint64_t a1 = Load64(a+8);
+    const uint64_t a2 = Load64(a+16);
+    const uint64_t a3 = Load64(a+24);
+
+    for(int i=0; i<nB; i++)
+    {
+        const unsigned char* b = B+i*strideB;
+        dist[i] = (int)(_mm_popcnt_u64(a0 ^ Load64(b)) + _mm_popcnt_u64(a1 ^ Load64(b+8)) +
+                        _mm_popcnt_u64(a2 ^ Load64(b+16)) + _mm_popcnt_u64(a3 ^ Load64(b+24)));
+    }
+}
+
+// AVX2: per byte popcount with a nibble lookup table (vpshufb), summed with vpsadbw
+
+__attribute__((target("avx2")))
+static inline __m256i PopCountBytesAVX2(const __m256i v)
+{
+    const __m256i lut = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                         0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+
+    const __m256i lo = _mm256_and_si256(v,low);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v,4),low);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(lut,lo),_mm256_shuffle_epi8(lut,hi));
+}
+
+__attribute__((target("avx2")))
+static inline int PopCountAVX2(const __m256i v)
+{
+    const __m256i sum = _mm256_sad_epu8(PopCountBytesAVX2(v),_mm256_setzero_si256());
+    const __m128i sum2 = _mm_add_epi64(_mm256_castsi256_si128(sum),_mm256_extracti128_si256(sum,1));
+    return _mm_cvtsi128_si32(sum2) + _mm_extract_epi32(sum2,2);
+}
+
+__attribute__((target("avx2")))
+static int DistanceAVX2(const unsigned char* a, const unsigned char* b)
+{
+    const __m256i va = _mm256_loadu_si256((const __m256i*)a);
+    const __m256i vb = _mm256_loadu_si256((const __m256i*)b);
+    return PopCountAVX2(_mm256_xor_si256(va,vb));
+}
+
+__attribute__((target("avx2")))
+static void DistanceManyAVX2(const unsigned char* a, const unsigned char* B, const int nB, const size_t strideB, int* dist)
+{
+    const __m256i va = _mm256_loadu_si256((const __m256i*)a);
+    const __m256i zero = _mm256_setzero_si256();
+
+    // Four descriptors per iteration so the horizontal reduction is shared
+    int i=0;
+    for(; i+3<nB; i+=4)
+    {
+        const unsigned char* b = B+i*strideB;
+        const __m256i s0 = _mm256_sad_epu8(PopCountBytesAVX2(_mm256_xor_si256(va,_mm256_loadu_si256((const __m256i*)b))),zero);
+        const __m256i s1 = _mm256_sad_epu8(PopCountBytesAVX2(_mm256_xor_si256(va,_mm256_loadu_si256((const __m256i*)(b+strideB)))),zero);
+        const __m256i s2 = _mm256_sad_epu8(PopCountBytesAVX2(_mm256_xor_si256(va,_mm256_loadu_si256((const __m256i*)(b+2*strideB)))),zero);
+        const __m256i s3 = _mm256_sad_epu8(PopCountBytesAVX2(_mm256_xor_si256(va,_mm256_loadu_si256((const __m256i*)(b+3*strideB)))),zero);
+
+        // Partial sums fit in 32 bits: interleave them and reduce the four descriptors together
+        const __m256i s01 = _mm256_blend_epi32(s0,_mm256_slli_epi64(s1,32),0xAA);
+        const __m256i s23 = _mm256_blend_epi32(s2,_mm256_slli_epi64(s3,32),0xAA);
+        const __m256i s = _mm256_add_epi32(_mm256_unpacklo_epi64(s01,s23),_mm256_unpackhi_epi64(s01,s23));
+        const __m128i d = _mm_add_epi32(_mm256_castsi256_si128(s),_mm256_extracti128_si256(s,1));
+        _mm_storeu_si128((__m128i*)(dist+i),d);
+    }
+
+    for(; i<nB; i++)
+        dist[i] = PopCountAVX2(_mm256_xor_si256(va,_mm256_loadu_si256((const __m256i*)(B+i*strideB))));
+}
+
+// AVX-512: VPOPCNTDQ on 64 bit lanes, two descriptors per 512 bit register
+
+// Some GCC versions warn about the undefined upper lanes used inside the 512 bit intrinsics
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f,avx512vl,avx512vpopcntdq")))
+static inline int Sum4AVX512(const __m256i v)
+{
+    const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(v),_mm256_extracti128_si256(v,1));
+    return (int)(_mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum,1));
+}
+
+__attribute__((target("avx512f,avx512vl,avx512vpopcntdq")))
+static int DistanceAVX512(const unsigned char* a, const unsigned char* b)
+{
+    const __m256i va = _mm256_loadu_si256((const __m256i*)a);
+    const __m256i vb = _mm256_loadu_si256((const __m256i*)b);
+    return Sum4AVX512(_mm256_popcnt_epi64(_mm256_xor_si256(va,vb)));
+}
+
+__attribute__((target("avx512f,avx512vl,avx512vpopcntdq")))
+static inline __m512i LoadPairAVX512(const unsigned char* b, const size_t strideB)
+{
+    if(strideB==HammingDistance::DESCRIPTOR_SIZE)
+        return _mm512_loadu_si512((const void*)b);
+
+    const __m256i b0 = _mm256_loadu_si256((const __m256i*)b);
+    const __m256i b1 = _mm256_loadu_si256((const __m256i*)(b+strideB));
+    return _mm512_inserti64x4(_mm512_castsi256_si512(b0),b1,1);
+}
+
+__attribute__((target("avx512f,avx512vl,avx512vpopcntdq")))
+static void DistanceManyAVX512(const unsigned char* a, const unsigned char* B, const int nB, const size_t strideB, int* dist)
+{
+    const __m512i va = _mm512_broadcast_i64x4(_mm256_loadu_si256((const __m256i*)a));
+    const __m256i order = _mm256_setr_epi32(0,4,1,5,2,6,3,7);
+
+    // Four descriptors (two registers) per iteration so the horizontal reduction is shared
+    int i=0;
+    for(; i+3<nB; i+=4)
+    {
+        const unsigned char* b = B+i*strideB;
+        const __m512i c01 = _mm512_popcnt_epi64(_mm512_xor_si512(va,LoadPairAVX512(b,strideB)));
+        const __m512i c23 = _mm512_popcnt_epi64(_mm512_xor_si512(va,LoadPairAVX512(b+2*strideB,strideB)));
+
+        // [d0 d2 | d0 d2 | d1 d3 | d1 d3] after adding lanes pairwise and then 128 bit blocks
+        const __m512i s = _mm512_add_epi64(_mm512_unpacklo_epi64(c01,c23),_mm512_unpackhi_epi64(c01,c23));
+        const __m512i t = _mm512_add_epi64(s,_mm512_shuffle_i64x2(s,s,_MM_SHUFFLE(2,3,0,1)));
+        const __m256i d = _mm256_permutevar8x32_epi32(_mm512_cvtepi64_epi32(t),order);
+        _mm_storeu_si128((__m128i*)(dist+i),_mm256_castsi256_si128(d));
+    }
+
+    for(; i<nB; i++)
+        dist[i] = DistanceAVX512(a,B+i*strideB);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // HAMMING_X86_KERNELS
+
+struct Kernels
+{
+    HammingDistance::Kernel kernel;
+    DistanceFunc distance;
+    DistanceManyFunc distanceMany;
+};
+
+static Kernels GetKernels(HammingDistance::Kernel kernel)
+{
+    Kernels k;
+    k.kernel = kernel;
+    k.distance = DistanceScalar;
+    k.distanceMany = DistanceManyScalar;
+
+#ifdef HAMMING_X86_KERNELS
+    if(kernel==HammingDistance::SSE42)
+    {
+        k.distance = DistanceSSE42;
+        k.distanceMany = DistanceManySSE42;
+    }
+    else if(kernel==HammingDistance::AVX2)
+    {
+        k.distance = DistanceAVX2;
+        k.distanceMany = DistanceManyAVX2;
+    }
+    else if(kernel==HammingDistance::AVX512)
+    {
+        k.distance = DistanceAVX512;
+        k.distanceMany = DistanceManyAVX512;
+    }
+#endif
+
+    return k;
+}
+
+static Kernels SelectKernels()
+{
+    for(int k=HammingDistance::AVX512; k>HammingDistance::SCALAR; k--)
+        if(HammingDistance::IsSupported((HammingDistance::Kernel)k))
+            return GetKernels((HammingDistance::Kernel)k);
+
+    return GetKernels(HammingDistance::SCALAR);
+}
+
+// Selected on first use, so static initializers of other translation units can call it too
+static Kernels& Selected()
+{
+    static Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+bool HammingDistance::IsSupported(Kernel kernel)
+{
+    if(kernel==SCALAR)
+        return true;
+
+#ifdef HAMMING_X86_KERNELS
+    __builtin_cpu_init();
+    if(kernel==SSE42)
+        return __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("sse4.2");
+    if(kernel==AVX2)
+        return __builtin_cpu_supports("avx2");
+    if(kernel==AVX512)
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+               __builtin_cpu_supports("avx512vpopcntdq");
+#endif
+
+    return false;
+}
+
+HammingDistance::Kernel HammingDistance::GetKernel()
+{
+    return Selected().kernel;
+}
+
+bool HammingDistance::SetKernel(Kernel kernel)
+{
+    if(!IsSupported(kernel))
+        return false;
+
+    Selected() = GetKernels(kernel);
+    return true;
+}
+
+const char* HammingDistance::GetKernelName(Kernel kernel)
+{
+    switch(kernel)
+    {
+    case SCALAR:
+        return "scalar";
+    case SSE42:
+        return "sse4.2";
+    case AVX2:
+        return "avx2";
+    case AVX512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+int HammingDistance::Distance(const unsigned char* a, const unsigned char* b)
+{
+    return Selected().distance(a,b);
+}
+
+void HammingDistance::Distance(const unsigned char* a, const unsigned char* B, const int nB, const size_t strideB, int* dist)
+{
+    Selected().distanceMany(a,B,nB,strideB,dist);
+}
+
+void HammingDistance::DistanceMatrix(const unsigned char* A, const int nA, const size_t strideA,
+                                     const unsigned char* B, const int nB, const size_t strideB,
+                                     int* D, const size_t strideD)
+{
+    const DistanceManyFunc distanceMany = Selected().distanceMany;
+
+    for(int j0=0; j0<nB; j0+=TILE_SIZE)
+    {
+        const int nj = min(TILE_SIZE,nB-j0);
+        const unsigned char* Bt = B+j0*strideB;
+        for(int i=0; i<nA; i++)
+            distanceMany(A+i*strideA,Bt,nj,strideB,D+i*strideD+j0);
+    }
+}
+
+} //namespace ORB_SLAM
@@ -0,0 +1,150 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ImagePreprocessing.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+// Fixed point coefficients of cvtColor (14 bits)
+const int GRAY_SHIFT = 14;
+const int GRAY_R = 4899;
+const int GRAY_G = 9617;
+const int GRAY_B = 1868;
+
+static inline int Gray(const uchar* p, const int iR, const int iB)
+{
+    return (p[iR]*GRAY_R + p[1]*GRAY_G + p[iB]*GRAY_B + (1 << (GRAY_SHIFT-1))) >> GRAY_SHIFT;
+}
+
+template<int CN>
+static void ToGrayRow(const uchar* pSrc0, const uchar* pSrc1, uchar* pDst, float* pNorm,
+                      const int width, const int scale, const int iR, const int iB)
+{
+    const float invNorm = 1.0f/255.0f;
+
+    for(int x=0; x<width; x++)
+    {
+        int g;
+        if(scale==1)
+        {
+            const uchar* p = pSrc0+x*CN;
+            g = CN==1 ? p[0] : Gray(p,iR,iB);
+        }
+        else
+        {
+            // For an exact 2x downscale a bilinear resize averages the 2x2 block
+            const uchar* p0 = pSrc0+2*x*CN;
+            const uchar* p1 = pSrc1+2*x*CN;
+            if(CN==1)
+                g = (p0[0] + p0[1] + p1[0] + p1[1] + 2) >> 2;
+            else
+                g = (Gray(p0,iR,iB) + Gray(p0+CN,iR,iB) + Gray(p1,iR,iB) + Gray(p1+CN,iR,iB) + 2) >> 2;
+        }
+
+        pDst[x] = (uchar) g;
+        if(pNorm)
+            pNorm[x] = g*invNorm;
+    }
+}
+
+bool ImagePreprocessing::ToGray(const cv::Mat &im, const bool bRGB, cv::Mat &imGray, float* pNormalized)
+{
+    if(im.depth()!=CV_8U || imGray.type()!=CV_8UC1 || imGray.empty())
+        return false;
+
+    const int cn = im.channels();
+    if(cn!=1 && cn!=3 && cn!=4)
+        return false;
+
+    const int width = imGray.cols;
+    const int height = imGray.rows;
+
+    int scale;
+    if(im.cols==width && im.rows==height)
+        scale = 1;
+    else if(im.cols==2*width && im.rows==2*height)
+        scale = 2;
+    else
+        return false;
+
+    const int iR = bRGB ? 0 : 2;
+    const int iB = bRGB ? 2 : 0;
+
+    for(int y=0; y<height; y++)
+    {
+        const uchar* pSrc0 = im.ptr<uchar>(scale*y);
+        const uchar* pSrc1 = im.ptr<uchar>(scale*y+scale-1);
+        uchar* pDst = imGray.ptr<uchar>(y);
+        float* pNorm = pNormalized ? pNormalized+y*width : NULL;
+
+        if(cn==1)
+            ToGrayRow<1>(pSrc0,pSrc1,pDst,pNorm,width,scale,iR,iB);
+        else if(cn==3)
+            ToGrayRow<3>(pSrc0,pSrc1,pDst,pNorm,width,scale,iR,iB);
+        else
+            ToGrayRow<4>(pSrc0,pSrc1,pDst,pNorm,width,scale,iR,iB);
+    }
+
+    return true;
+}
+
+template<typename T>
+static void ToDepthRows(const cv::Mat &imD, const float depthFactor, const vector<int> &vSrcX, cv::Mat &imDepth)
+{
+    const int width = imDepth.cols;
+    const int height = imDepth.rows;
+    const double scaleY = (double)imD.rows/height;
+
+    for(int y=0; y<height; y++)
+    {
+        const T* pSrc = imD.ptr<T>(min(cvFloor(y*scaleY),imD.rows-1));
+        float* pDst = imDepth.ptr<float>(y);
+        for(int x=0; x<width; x++)
+            pDst[x] = pSrc[vSrcX[x]]*depthFactor;
+    }
+}
+
+bool ImagePreprocessing::ToDepth(const cv::Mat &imD, const float depthFactor, cv::Mat &imDepth)
+{
+    if(imD.channels()!=1 || (imD.depth()!=CV_16U && imD.depth()!=CV_32F) || imDepth.type()!=CV_32FC1 || imDepth.empty())
+        return false;
+
+    // Source column of each output column, as computed by resize(INTER_NEAREST)
+    const int width = imDepth.cols;
+    const double scaleX = (double)imD.cols/width;
+    vector<int> vSrcX(width);
+    for(int x=0; x<width; x++)
+        vSrcX[x] = min(cvFloor(x*scaleX),imD.cols-1);
+
+    if(imD.depth()==CV_16U)
+        ToDepthRows<unsigned short>(imD,depthFactor,vSrcX,imDepth);
+    else
+        ToDepthRows<float>(imD,depthFactor,vSrcX,imDepth);
+
+    return true;
+}
+
+} //namespace ORB_SLAM
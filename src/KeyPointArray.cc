@@ -0,0 +1,74 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "KeyPointArray.h"
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+KeyPointArray::KeyPointArray()
+{
+    FrameArena::Acquire(mvX);
+    FrameArena::Acquire(mvY);
+    FrameArena::Acquire(mvOctave);
+    FrameArena::Acquire(mvAngle);
+}
+
+KeyPointArray::KeyPointArray(const KeyPointArray &keys)
+{
+    FrameArena::Acquire(mvX);
+    FrameArena::Acquire(mvY);
+    FrameArena::Acquire(mvOctave);
+    FrameArena::Acquire(mvAngle);
+    mvX = keys.mvX;
+    mvY = keys.mvY;
+    mvOctave = keys.mvOctave;
+    mvAngle = keys.mvAngle;
+}
+
+KeyPointArray::~KeyPointArray()
+{
+    FrameArena::Release(mvX);
+    FrameArena::Release(mvY);
+    FrameArena::Release(mvOctave);
+    FrameArena::Release(mvAngle);
+}
+
+void KeyPointArray::Assign(const vector<cv::KeyPoint> &vKeys)
+{
+    const size_t N = vKeys.size();
+    mvX.resize(N);
+    mvY.resize(N);
+    mvOctave.resize(N);
+    mvAngle.resize(N);
+
+    for(size_t i=0; i<N; i++)
+    {
+        const cv::KeyPoint &kp = vKeys[i];
+        mvX[i] = kp.pt.x;
+        mvY[i] = kp.pt.y;
+        mvOctave[i] = (unsigned char) kp.octave;
+        mvAngle[i] = kp.angle;
+    }
+}
+
+} //namespace ORB_SLAM
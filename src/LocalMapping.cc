@@ -22,6 +22,8 @@
 #include "LoopClosing.h"
 #include "ORBmatcher.h"
 #include "Optimizer.h"
+#include "Profiler.h"
+#include "Converter.h"
 
 #include<mutex>
 
@@ -46,6 +48,7 @@ void LocalMapping::SetTracker(Tracking *pTracker)
 
 void LocalMapping::Run()
 {
+    Profiler::SetThreadName("LocalMapping");
 
     mbFinished = false;
 
@@ -78,7 +81,10 @@ void LocalMapping::Run()
             {
                 // Local BA
                 if(mpMap->KeyFramesInMap()>2)
+                {
+                    Profiler::ScopedTimer timer(Profiler::LOCAL_BA);
                     Optimizer::LocalBundleAdjustment(mpCurrentKeyFrame,&mbAbortBA, mpMap);
+                }
 
                 // Check redundant local Keyframes
                 KeyFrameCulling();
@@ -89,6 +95,7 @@ void LocalMapping::Run()
         else if(Stop())
         {
             // Safe area to stop
+            Tracer::ScopedSpan span("Stopped","wait");
             while(isStopped() && !CheckFinish())
             {
                 usleep(3000);
@@ -115,6 +122,7 @@ void LocalMapping::InsertKeyFrame(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexNewKFs);
     mlNewKeyFrames.push_back(pKF);
+    Tracer::Counter("mlNewKeyFrames",mlNewKeyFrames.size());
     mbAbortBA=true;
 }
 
@@ -127,10 +135,13 @@ bool LocalMapping::CheckNewKeyFrames()
 
 void LocalMapping::ProcessNewKeyFrame()
 {
+    Profiler::ScopedTimer timer(Profiler::PROCESS_NEW_KEYFRAME);
+
     {
         unique_lock<mutex> lock(mMutexNewKFs);
         mpCurrentKeyFrame = mlNewKeyFrames.front();
         mlNewKeyFrames.pop_front();
+        Tracer::Counter("mlNewKeyFrames",mlNewKeyFrames.size());
     }
 
     // Compute Bags of Words structures
@@ -169,6 +180,8 @@ void LocalMapping::ProcessNewKeyFrame()
 
 void LocalMapping::MapPointCulling()
 {
+    Profiler::ScopedTimer timer(Profiler::MAPPOINT_CULLING);
+
     // Check Recent Added MapPoints
     list<MapPoint*>::iterator lit = mlpRecentAddedMapPoints.begin();
     const unsigned long int nCurrentKFid = mpCurrentKeyFrame->mnId;
@@ -206,6 +219,8 @@ void LocalMapping::MapPointCulling()
 
 void LocalMapping::CreateNewMapPoints()
 {
+    Profiler::ScopedTimer timer(Profiler::CREATE_NEW_MAPPOINTS);
+
     // Retrieve neighbor keyframes in covisibility graph
     int nn = 10;
     if(mbMonocular)
@@ -214,13 +229,14 @@ void LocalMapping::CreateNewMapPoints()
 
     ORBmatcher matcher(0.6,false);
 
-    cv::Mat Rcw1 = mpCurrentKeyFrame->GetRotation();
-    cv::Mat Rwc1 = Rcw1.t();
-    cv::Mat tcw1 = mpCurrentKeyFrame->GetTranslation();
-    cv::Mat Tcw1(3,4,CV_32F);
-    Rcw1.copyTo(Tcw1.colRange(0,3));
-    tcw1.copyTo(Tcw1.col(3));
-    cv::Mat Ow1 = mpCurrentKeyFrame->GetCameraCenter();
+    // Poses are read once as fixed-size Eigen types, so the per match work below does not allocate
+    Eigen::Matrix3f Rcw1;
+    Eigen::Vector3f tcw1;
+    mpCurrentKeyFrame->GetPoseEigen(Rcw1,tcw1);
+    const Eigen::Matrix3f Rwc1 = Rcw1.transpose();
+    Eigen::Matrix<float,3,4> Tcw1;
+    Tcw1 << Rcw1, tcw1;
+    const Eigen::Vector3f Ow1 = mpCurrentKeyFrame->GetCameraCenterEigen();
 
     const float &fx1 = mpCurrentKeyFrame->fx;
     const float &fy1 = mpCurrentKeyFrame->fy;
@@ -242,9 +258,8 @@ void LocalMapping::CreateNewMapPoints()
         KeyFrame* pKF2 = vpNeighKFs[i];
 
         // Check first that baseline is not too short
-        cv::Mat Ow2 = pKF2->GetCameraCenter();
-        cv::Mat vBaseline = Ow2-Ow1;
-        const float baseline = cv::norm(vBaseline);
+        const Eigen::Vector3f Ow2 = pKF2->GetCameraCenterEigen();
+        const float baseline = (Ow2-Ow1).norm();
 
         if(!mbMonocular)
         {
@@ -267,12 +282,12 @@ void LocalMapping::CreateNewMapPoints()
         vector<pair<size_t,size_t> > vMatchedIndices;
         matcher.SearchForTriangulation(mpCurrentKeyFrame,pKF2,F12,vMatchedIndices,false);
 
-        cv::Mat Rcw2 = pKF2->GetRotation();
-        cv::Mat Rwc2 = Rcw2.t();
-        cv::Mat tcw2 = pKF2->GetTranslation();
-        cv::Mat Tcw2(3,4,CV_32F);
-        Rcw2.copyTo(Tcw2.colRange(0,3));
-        tcw2.copyTo(Tcw2.col(3));
+        Eigen::Matrix3f Rcw2;
+        Eigen::Vector3f tcw2;
+        pKF2->GetPoseEigen(Rcw2,tcw2);
+        const Eigen::Matrix3f Rwc2 = Rcw2.transpose();
+        Eigen::Matrix<float,3,4> Tcw2;
+        Tcw2 << Rcw2, tcw2;
 
         const float &fx2 = pKF2->fx;
         const float &fy2 = pKF2->fy;
@@ -297,12 +312,12 @@ void LocalMapping::CreateNewMapPoints()
             bool bStereo2 = kp2_ur>=0;
 
             // Check parallax between rays
-            cv::Mat xn1 = (cv::Mat_<float>(3,1) << (kp1.pt.x-cx1)*invfx1, (kp1.pt.y-cy1)*invfy1, 1.0);
-            cv::Mat xn2 = (cv::Mat_<float>(3,1) << (kp2.pt.x-cx2)*invfx2, (kp2.pt.y-cy2)*invfy2, 1.0);
+            const Eigen::Vector3f xn1((kp1.pt.x-cx1)*invfx1, (kp1.pt.y-cy1)*invfy1, 1.0f);
+            const Eigen::Vector3f xn2((kp2.pt.x-cx2)*invfx2, (kp2.pt.y-cy2)*invfy2, 1.0f);
 
-            cv::Mat ray1 = Rwc1*xn1;
-            cv::Mat ray2 = Rwc2*xn2;
-            const float cosParallaxRays = ray1.dot(ray2)/(cv::norm(ray1)*cv::norm(ray2));
+            const Eigen::Vector3f ray1 = Rwc1*xn1;
+            const Eigen::Vector3f ray2 = Rwc2*xn2;
+            const float cosParallaxRays = ray1.dot(ray2)/(ray1.norm()*ray2.norm());
 
             float cosParallaxStereo = cosParallaxRays+1;
             float cosParallaxStereo1 = cosParallaxStereo;
@@ -315,54 +330,56 @@ void LocalMapping::CreateNewMapPoints()
 
             cosParallaxStereo = min(cosParallaxStereo1,cosParallaxStereo2);
 
-            cv::Mat x3D;
+            Eigen::Vector3f x3D;
             if(cosParallaxRays<cosParallaxStereo && cosParallaxRays>0 && (bStereo1 || bStereo2 || cosParallaxRays<0.9998))
             {
                 // Linear Triangulation Method
-                cv::Mat A(4,4,CV_32F);
-                A.row(0) = xn1.at<float>(0)*Tcw1.row(2)-Tcw1.row(0);
-                A.row(1) = xn1.at<float>(1)*Tcw1.row(2)-Tcw1.row(1);
-                A.row(2) = xn2.at<float>(0)*Tcw2.row(2)-Tcw2.row(0);
-                A.row(3) = xn2.at<float>(1)*Tcw2.row(2)-Tcw2.row(1);
-
-                cv::Mat w,u,vt;
-                cv::SVD::compute(A,w,u,vt,cv::SVD::MODIFY_A| cv::SVD::FULL_UV);
+                Eigen::Matrix4f A;
+                A.row(0) = xn1(0)*Tcw1.row(2)-Tcw1.row(0);
+                A.row(1) = xn1(1)*Tcw1.row(2)-Tcw1.row(1);
+                A.row(2) = xn2(0)*Tcw2.row(2)-Tcw2.row(0);
+                A.row(3) = xn2(1)*Tcw2.row(2)-Tcw2.row(1);
 
-                x3D = vt.row(3).t();
+                // Null space of A, i.e. the right singular vector of the smallest singular value
+                Eigen::JacobiSVD<Eigen::Matrix4f> svd(A,Eigen::ComputeFullV);
+                const Eigen::Vector4f x3Dh = svd.matrixV().col(3);
 
-                if(x3D.at<float>(3)==0)
+                if(x3Dh(3)==0)
                     continue;
 
                 // Euclidean coordinates
-                x3D = x3D.rowRange(0,3)/x3D.at<float>(3);
+                x3D = x3Dh.head<3>()/x3Dh(3);
 
             }
             else if(bStereo1 && cosParallaxStereo1<cosParallaxStereo2)
             {
-                x3D = mpCurrentKeyFrame->UnprojectStereo(idx1);                
+                // Same as KeyFrame::UnprojectStereo, with the pose already read above
+                const float z = mpCurrentKeyFrame->mvDepth[idx1];
+                const cv::Point2f &pt = mpCurrentKeyFrame->mvKeys[idx1].pt;
+                x3D = Rwc1*Eigen::Vector3f((pt.x-cx1)*z*invfx1, (pt.y-cy1)*z*invfy1, z)+Ow1;
             }
             else if(bStereo2 && cosParallaxStereo2<cosParallaxStereo1)
             {
-                x3D = pKF2->UnprojectStereo(idx2);
+                const float z = pKF2->mvDepth[idx2];
+                const cv::Point2f &pt = pKF2->mvKeys[idx2].pt;
+                x3D = Rwc2*Eigen::Vector3f((pt.x-cx2)*z*invfx2, (pt.y-cy2)*z*invfy2, z)+Ow2;
             }
             else
                 continue; //No stereo and very low parallax
 
-            cv::Mat x3Dt = x3D.t();
-
             //Check triangulation in front of cameras
-            float z1 = Rcw1.row(2).dot(x3Dt)+tcw1.at<float>(2);
+            float z1 = Rcw1.row(2).dot(x3D)+tcw1(2);
             if(z1<=0)
                 continue;
 
-            float z2 = Rcw2.row(2).dot(x3Dt)+tcw2.at<float>(2);
+            float z2 = Rcw2.row(2).dot(x3D)+tcw2(2);
             if(z2<=0)
                 continue;
 
             //Check reprojection error in first keyframe
             const float &sigmaSquare1 = mpCurrentKeyFrame->mvLevelSigma2[kp1.octave];
-            const float x1 = Rcw1.row(0).dot(x3Dt)+tcw1.at<float>(0);
-            const float y1 = Rcw1.row(1).dot(x3Dt)+tcw1.at<float>(1);
+            const float x1 = Rcw1.row(0).dot(x3D)+tcw1(0);
+            const float y1 = Rcw1.row(1).dot(x3D)+tcw1(1);
             const float invz1 = 1.0/z1;
 
             if(!bStereo1)
@@ -388,8 +405,8 @@ void LocalMapping::CreateNewMapPoints()
 
             //Check reprojection error in second keyframe
             const float sigmaSquare2 = pKF2->mvLevelSigma2[kp2.octave];
-            const float x2 = Rcw2.row(0).dot(x3Dt)+tcw2.at<float>(0);
-            const float y2 = Rcw2.row(1).dot(x3Dt)+tcw2.at<float>(1);
+            const float x2 = Rcw2.row(0).dot(x3D)+tcw2(0);
+            const float y2 = Rcw2.row(1).dot(x3D)+tcw2(1);
             const float invz2 = 1.0/z2;
             if(!bStereo2)
             {
@@ -413,11 +430,8 @@ void LocalMapping::CreateNewMapPoints()
             }
 
             //Check scale consistency
-            cv::Mat normal1 = x3D-Ow1;
-            float dist1 = cv::norm(normal1);
-
-            cv::Mat normal2 = x3D-Ow2;
-            float dist2 = cv::norm(normal2);
+            const float dist1 = (x3D-Ow1).norm();
+            const float dist2 = (x3D-Ow2).norm();
 
             if(dist1==0 || dist2==0)
                 continue;
@@ -431,7 +445,7 @@ void LocalMapping::CreateNewMapPoints()
                 continue;
 
             // Triangulation is succesfull
-            MapPoint* pMP = new MapPoint(x3D,mpCurrentKeyFrame,mpMap);
+            MapPoint* pMP = new MapPoint(Converter::toCvMat(x3D),mpCurrentKeyFrame,mpMap);
 
             pMP->AddObservation(mpCurrentKeyFrame,idx1);            
             pMP->AddObservation(pKF2,idx2);
@@ -453,6 +467,8 @@ void LocalMapping::CreateNewMapPoints()
 
 void LocalMapping::SearchInNeighbors()
 {
+    Profiler::ScopedTimer timer(Profiler::SEARCH_IN_NEIGHBORS);
+
     // Retrieve neighbor keyframes
     int nn = 10;
     if(mbMonocular)
@@ -535,21 +551,24 @@ void LocalMapping::SearchInNeighbors()
 
 cv::Mat LocalMapping::ComputeF12(KeyFrame *&pKF1, KeyFrame *&pKF2)
 {
-    cv::Mat R1w = pKF1->GetRotation();
-    cv::Mat t1w = pKF1->GetTranslation();
-    cv::Mat R2w = pKF2->GetRotation();
-    cv::Mat t2w = pKF2->GetTranslation();
+    Eigen::Matrix3f R1w, R2w;
+    Eigen::Vector3f t1w, t2w;
+    pKF1->GetPoseEigen(R1w,t1w);
+    pKF2->GetPoseEigen(R2w,t2w);
 
-    cv::Mat R12 = R1w*R2w.t();
-    cv::Mat t12 = -R1w*R2w.t()*t2w+t1w;
+    const Eigen::Matrix3f R12 = R1w*R2w.transpose();
+    const Eigen::Vector3f t12 = -R12*t2w+t1w;
 
-    cv::Mat t12x = SkewSymmetricMatrix(t12);
+    Eigen::Matrix3f t12x;
+    t12x <<      0, -t12(2),  t12(1),
+            t12(2),       0, -t12(0),
+           -t12(1),  t12(0),       0;
 
-    const cv::Mat &K1 = pKF1->mK;
-    const cv::Mat &K2 = pKF2->mK;
+    const Eigen::Matrix3f K1 = Converter::toMatrix3f(pKF1->mK);
+    const Eigen::Matrix3f K2 = Converter::toMatrix3f(pKF2->mK);
 
-
-    return K1.t().inv()*t12x*R12*K2.inv();
+    const Eigen::Matrix3f F12 = K1.transpose().inverse()*t12x*R12*K2.inverse();
+    return Converter::toCvMat(Eigen::Matrix3d(F12.cast<double>()));
 }
 
 void LocalMapping::RequestStop()
@@ -631,6 +650,8 @@ void LocalMapping::InterruptBA()
 
 void LocalMapping::KeyFrameCulling()
 {
+    Profiler::ScopedTimer timer(Profiler::KEYFRAME_CULLING);
+
     // Check redundant keyframes (only local keyframes)
     // A keyframe is considered redundant if the 90% of the MapPoints it sees, are seen
     // in at least other 3 keyframes (in the same or finer scale)
@@ -695,13 +716,6 @@ void LocalMapping::KeyFrameCulling()
     }
 }
 
-cv::Mat LocalMapping::SkewSymmetricMatrix(const cv::Mat &v)
-{
-    return (cv::Mat_<float>(3,3) <<             0, -v.at<float>(2), v.at<float>(1),
-            v.at<float>(2),               0,-v.at<float>(0),
-            -v.at<float>(1),  v.at<float>(0),              0);
-}
-
 void LocalMapping::RequestReset()
 {
     {
@@ -0,0 +1,118 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "LockProfiler.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+namespace
+{
+
+const char* LOCK_NAMES[LockProfiler::NUM_LOCKS] =
+{
+    "Map::mMutexMapUpdate",
+    "MapPoint::mGlobalMutex",
+    "KeyFrame::mMutexConnections",
+    "KeyFrame::mMutexFeatures",
+    "KeyFrame::mMutexPose",
+    "KeyFrameDatabase::mMutex"
+};
+
+// Instances of the same lock (one per keyframe) are recorded from several threads at once
+struct LockStats
+{
+    LockStats(): nCount(0), nContended(0), nWait(0), nMaxWait(0), nHold(0), nMaxHold(0) {}
+
+    atomic<unsigned long long> nCount;
+    atomic<unsigned long long> nContended;
+    atomic<long long> nWait;
+    atomic<long long> nMaxWait;
+    atomic<long long> nHold;
+    atomic<long long> nMaxHold;
+};
+
+LockStats gvStats[LockProfiler::NUM_LOCKS];
+
+void UpdateMax(atomic<long long> &a, const long long v)
+{
+    long long current = a.load(memory_order_relaxed);
+    while(v>current && !a.compare_exchange_weak(current,v,memory_order_relaxed));
+}
+
+} // namespace
+
+void LockProfiler::Record(const Lock lock, const long long wait, const long long hold, const bool bContended)
+{
+    LockStats &stats = gvStats[lock];
+    stats.nCount.fetch_add(1,memory_order_relaxed);
+    if(bContended)
+    {
+        stats.nContended.fetch_add(1,memory_order_relaxed);
+        stats.nWait.fetch_add(wait,memory_order_relaxed);
+        UpdateMax(stats.nMaxWait,wait);
+    }
+    stats.nHold.fetch_add(hold,memory_order_relaxed);
+    UpdateMax(stats.nMaxHold,hold);
+}
+
+const char* LockProfiler::GetLockName(const Lock lock)
+{
+    return LOCK_NAMES[lock];
+}
+
+void LockProfiler::PrintReport()
+{
+#ifdef LOCK_PROFILING
+    // Most waited for first
+    vector<pair<long long,int> > vOrder;
+    for(int i=0; i<NUM_LOCKS; i++)
+        vOrder.push_back(make_pair(-gvStats[i].nWait.load(),i));
+    sort(vOrder.begin(),vOrder.end());
+
+    cout << "-------" << endl << endl;
+    cout << "Lock contention (times in ms)" << endl;
+    cout << left << setw(30) << "lock" << right << setw(12) << "acquired" << setw(12) << "contended"
+         << setw(12) << "wait" << setw(12) << "max wait" << setw(12) << "hold" << setw(12) << "max hold" << endl;
+    cout << fixed << setprecision(3);
+    for(int k=0; k<NUM_LOCKS; k++)
+    {
+        const LockStats &stats = gvStats[vOrder[k].second];
+        const unsigned long long nCount = stats.nCount.load();
+        const unsigned long long nContended = stats.nContended.load();
+        cout << left << setw(30) << LOCK_NAMES[vOrder[k].second] << right << setw(12) << nCount
+             << setw(11) << (nCount>0 ? 100.0*nContended/nCount : 0.0) << "%"
+             << setw(12) << stats.nWait.load()*1e-6 << setw(12) << stats.nMaxWait.load()*1e-6
+             << setw(12) << stats.nHold.load()*1e-6 << setw(12) << stats.nMaxHold.load()*1e-6 << endl;
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+#endif
+}
+
+} //namespace ORB_SLAM
@@ -28,6 +28,8 @@
 
 #include "ORBmatcher.h"
 
+#include "Profiler.h"
+
 #include<mutex>
 #include<thread>
 
@@ -56,6 +58,7 @@ void LoopClosing::SetLocalMapper(LocalMapping *pLocalMapper)
 
 void LoopClosing::Run()
 {
+    Profiler::SetThreadName("LoopClosing");
     mbFinished =false;
 
     while(1)
@@ -92,6 +95,7 @@ void LoopClosing::InsertKeyFrame(KeyFrame *pKF)
     unique_lock<mutex> lock(mMutexLoopQueue);
     if(pKF->mnId!=0)
         mlpLoopKeyFrameQueue.push_back(pKF);
+    Tracer::Counter("mlpLoopKeyFrameQueue",mlpLoopKeyFrameQueue.size());
 }
 
 bool LoopClosing::CheckNewKeyFrames()
@@ -102,11 +106,14 @@ bool LoopClosing::CheckNewKeyFrames()
 
 bool LoopClosing::DetectLoop()
 {
+    Profiler::ScopedTimer timer(Profiler::DETECT_LOOP);
+
     // return false;
     {
         unique_lock<mutex> lock(mMutexLoopQueue);
         mpCurrentKF = mlpLoopKeyFrameQueue.front();
         mlpLoopKeyFrameQueue.pop_front();
+        Tracer::Counter("mlpLoopKeyFrameQueue",mlpLoopKeyFrameQueue.size());
         // Avoid that a keyframe can be erased while it is being process by this thread
         mpCurrentKF->SetNotErase();
     }
@@ -231,6 +238,8 @@ bool LoopClosing::DetectLoop()
 
 bool LoopClosing::ComputeSim3()
 {
+    Profiler::ScopedTimer timer(Profiler::COMPUTE_SIM3);
+
     // For each consistent loop candidate we try to compute a Sim3
 
     const int nInitialCandidates = mvpEnoughConsistentCandidates.size();
@@ -402,6 +411,8 @@ bool LoopClosing::ComputeSim3()
 
 void LoopClosing::CorrectLoop()
 {
+    Profiler::ScopedTimer timer(Profiler::CORRECT_LOOP);
+
     cout << "Loop detected!" << endl;
 
     // Send a stop signal to Local Mapping
@@ -424,9 +435,12 @@ void LoopClosing::CorrectLoop()
     }
 
     // Wait until Local Mapping has effectively stopped
-    while(!mpLocalMapper->isStopped())
     {
-        usleep(1000);
+        Tracer::ScopedSpan span("wait LocalMapping stop","wait");
+        while(!mpLocalMapper->isStopped())
+        {
+            usleep(1000);
+        }
     }
 
     // Ensure current keyframe is updated
@@ -443,7 +457,7 @@ void LoopClosing::CorrectLoop()
 
     {
         // Get Map Mutex
-        unique_lock<mutex> lock(mpMap->mMutexMapUpdate);
+        unique_lock<MapUpdateMutex> lock(Tracer::Lock(mpMap->mMutexMapUpdate,"mMutexMapUpdate"));
 
         for(vector<KeyFrame*>::iterator vit=mvpCurrentConnectedKFs.begin(), vend=mvpCurrentConnectedKFs.end(); vit!=vend; vit++)
         {
@@ -587,6 +601,8 @@ void LoopClosing::CorrectLoop()
 
 void LoopClosing::SearchAndFuse(const KeyFrameAndPose &CorrectedPosesMap)
 {
+    Profiler::ScopedTimer timer(Profiler::SEARCH_AND_FUSE);
+
     ORBmatcher matcher(0.8);
 
     for(KeyFrameAndPose::const_iterator mit=CorrectedPosesMap.begin(), mend=CorrectedPosesMap.end(); mit!=mend;mit++)
@@ -600,7 +616,7 @@ void LoopClosing::SearchAndFuse(const KeyFrameAndPose &CorrectedPosesMap)
         matcher.Fuse(pKF,cvScw,mvpLoopMapPoints,4,vpReplacePoints);
 
         // Get Map Mutex
-        unique_lock<mutex> lock(mpMap->mMutexMapUpdate);
+        unique_lock<MapUpdateMutex> lock(Tracer::Lock(mpMap->mMutexMapUpdate,"mMutexMapUpdate"));
         const int nLP = mvpLoopMapPoints.size();
         for(int i=0; i<nLP;i++)
         {
@@ -645,6 +661,9 @@ void LoopClosing::ResetIfRequested()
 
 void LoopClosing::RunGlobalBundleAdjustment(unsigned long nLoopKF)
 {
+    Profiler::SetThreadName("GlobalBA");
+    Profiler::ScopedTimer timer(Profiler::GLOBAL_BA);
+
     cout << "Starting Global Bundle Adjustment" << endl;
 
     int idx =  mnFullBAIdx;
@@ -665,14 +684,16 @@ void LoopClosing::RunGlobalBundleAdjustment(unsigned long nLoopKF)
             cout << "Updating map ..." << endl;
             mpLocalMapper->RequestStop();
             // Wait until Local Mapping has effectively stopped
-
-            while(!mpLocalMapper->isStopped() && !mpLocalMapper->isFinished())
             {
-                usleep(1000);
+                Tracer::ScopedSpan span("wait LocalMapping stop","wait");
+                while(!mpLocalMapper->isStopped() && !mpLocalMapper->isFinished())
+                {
+                    usleep(1000);
+                }
             }
 
             // Get Map Mutex
-            unique_lock<mutex> lock(mpMap->mMutexMapUpdate);
+            unique_lock<MapUpdateMutex> lock(Tracer::Lock(mpMap->mMutexMapUpdate,"mMutexMapUpdate"));
 
             // Correct keyframes starting at map first keyframe
             list<KeyFrame*> lpKFtoCheck(mpMap->mvpKeyFrameOrigins.begin(),mpMap->mvpKeyFrameOrigins.end());
@@ -20,23 +20,28 @@
 
 #include "MapPoint.h"
 #include "ORBmatcher.h"
+#include "HammingDistance.h"
+#include "Converter.h"
 
 #include<mutex>
+#include<cstring>
 
 namespace ORB_SLAM2
 {
 
 long unsigned int MapPoint::nNextId=0;
-mutex MapPoint::mGlobalMutex;
+MapPointGlobalMutex MapPoint::mGlobalMutex;
 
 MapPoint::MapPoint(const cv::Mat &Pos, KeyFrame *pRefKF, Map* pMap):
     mnFirstKFid(pRefKF->mnId), mnFirstFrame(pRefKF->mnFrameId), nObs(0), mnTrackReferenceForFrame(0),
-    mnLastFrameSeen(0), mnBALocalForKF(0), mnFuseCandidateForKF(0), mnLoopPointForKF(0), mnCorrectedByKF(0),
+    mnLastFrameSeen(0), mnTrackDescriptorRow(-1), mnTrackFrustumRow(-1), mnBALocalForKF(0), mnFuseCandidateForKF(0), mnLoopPointForKF(0), mnCorrectedByKF(0),
     mnCorrectedReference(0), mnBAGlobalForKF(0), mpRefKF(pRefKF), mnVisible(1), mnFound(1), mbBad(false),
     mpReplaced(static_cast<MapPoint*>(NULL)), mfMinDistance(0), mfMaxDistance(0), mpMap(pMap)
 {
-    Pos.copyTo(mWorldPos);
-    mNormalVector = cv::Mat::zeros(3,1,CV_32F);
+    mnDescriptorVersion = 0;
+    mnPositionVersion = 0;
+    mWorldPos = Converter::toVector3f(Pos);
+    mNormalVector.setZero();
 
     // MapPoints can be created from Tracking and Local Mapping. This mutex avoid conflicts with id.
     unique_lock<mutex> lock(mpMap->mMutexPointCreation);
@@ -45,17 +50,16 @@ MapPoint::MapPoint(const cv::Mat &Pos, KeyFrame *pRefKF, Map* pMap):
 
 MapPoint::MapPoint(const cv::Mat &Pos, Map* pMap, Frame* pFrame, const int &idxF):
     mnFirstKFid(-1), mnFirstFrame(pFrame->mnId), nObs(0), mnTrackReferenceForFrame(0), mnLastFrameSeen(0),
-    mnBALocalForKF(0), mnFuseCandidateForKF(0),mnLoopPointForKF(0), mnCorrectedByKF(0),
+    mnTrackDescriptorRow(-1), mnTrackFrustumRow(-1), mnBALocalForKF(0), mnFuseCandidateForKF(0),mnLoopPointForKF(0), mnCorrectedByKF(0),
     mnCorrectedReference(0), mnBAGlobalForKF(0), mpRefKF(static_cast<KeyFrame*>(NULL)), mnVisible(1),
     mnFound(1), mbBad(false), mpReplaced(NULL), mpMap(pMap)
 {
-    Pos.copyTo(mWorldPos);
-    cv::Mat Ow = pFrame->GetCameraCenter();
-    mNormalVector = mWorldPos - Ow;
-    mNormalVector = mNormalVector/cv::norm(mNormalVector);
-
-    cv::Mat PC = Pos - Ow;
-    const float dist = cv::norm(PC);
+    mnDescriptorVersion = 0;
+    mnPositionVersion = 0;
+    mWorldPos = Converter::toVector3f(Pos);
+    const Eigen::Vector3f PC = mWorldPos - pFrame->GetCameraCenterEigen();
+    const float dist = PC.norm();
+    mNormalVector = PC/dist;
     const int level = pFrame->mvKeysUn[idxF].octave;
     const float levelScaleFactor =  pFrame->mvScaleFactors[level];
     const int nLevels = pFrame->mnScaleLevels;
@@ -72,21 +76,34 @@ MapPoint::MapPoint(const cv::Mat &Pos, Map* pMap, Frame* pFrame, const int &idxF
 
 void MapPoint::SetWorldPos(const cv::Mat &Pos)
 {
-    unique_lock<mutex> lock2(mGlobalMutex);
+    unique_lock<MapPointGlobalMutex> lock2(mGlobalMutex);
     unique_lock<mutex> lock(mMutexPos);
-    Pos.copyTo(mWorldPos);
+    mWorldPos = Converter::toVector3f(Pos);
+    mnPositionVersion++;
 }
 
 cv::Mat MapPoint::GetWorldPos()
 {
     unique_lock<mutex> lock(mMutexPos);
-    return mWorldPos.clone();
+    return Converter::toCvMat(mWorldPos);
 }
 
 cv::Mat MapPoint::GetNormal()
 {
     unique_lock<mutex> lock(mMutexPos);
-    return mNormalVector.clone();
+    return Converter::toCvMat(mNormalVector);
+}
+
+Eigen::Vector3f MapPoint::GetWorldPosEigen()
+{
+    unique_lock<mutex> lock(mMutexPos);
+    return mWorldPos;
+}
+
+Eigen::Vector3f MapPoint::GetNormalEigen()
+{
+    unique_lock<mutex> lock(mMutexPos);
+    return mNormalVector;
 }
 
 KeyFrame* MapPoint::GetReferenceKeyFrame()
@@ -272,24 +289,19 @@ void MapPoint::ComputeDistinctiveDescriptors()
     // Compute distances between them
     const size_t N = vDescriptors.size();
 
-    float Distances[N][N];
+    cv::Mat descriptors(N,HammingDistance::DESCRIPTOR_SIZE,CV_8U);
     for(size_t i=0;i<N;i++)
-    {
-        Distances[i][i]=0;
-        for(size_t j=i+1;j<N;j++)
-        {
-            int distij = ORBmatcher::DescriptorDistance(vDescriptors[i],vDescriptors[j]);
-            Distances[i][j]=distij;
-            Distances[j][i]=distij;
-        }
-    }
+        vDescriptors[i].copyTo(descriptors.row(i));
+
+    vector<int> vDistances(N*N);
+    HammingDistance::DistanceMatrix(descriptors.data,N,descriptors.step,descriptors.data,N,descriptors.step,&vDistances[0],N);
 
     // Take the descriptor with least median distance to the rest
     int BestMedian = INT_MAX;
     int BestIdx = 0;
     for(size_t i=0;i<N;i++)
     {
-        vector<int> vDists(Distances[i],Distances[i]+N);
+        vector<int> vDists(vDistances.begin()+i*N,vDistances.begin()+(i+1)*N);
         sort(vDists.begin(),vDists.end());
         int median = vDists[0.5*(N-1)];
 
@@ -303,6 +315,7 @@ void MapPoint::ComputeDistinctiveDescriptors()
     {
         unique_lock<mutex> lock(mMutexFeatures);
         mDescriptor = vDescriptors[BestIdx].clone();
+        mnDescriptorVersion++;
     }
 }
 
@@ -312,6 +325,15 @@ cv::Mat MapPoint::GetDescriptor()
     return mDescriptor.clone();
 }
 
+int MapPoint::CopyDescriptor(unsigned char* pDescriptor)
+{
+    unique_lock<mutex> lock(mMutexFeatures);
+    if(mDescriptor.empty())
+        return -1;
+    memcpy(pDescriptor,mDescriptor.data,mDescriptor.cols);
+    return mnDescriptorVersion;
+}
+
 int MapPoint::GetIndexInKeyFrame(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexFeatures);
@@ -331,7 +353,7 @@ void MapPoint::UpdateNormalAndDepth()
 {
     map<KeyFrame*,size_t> observations;
     KeyFrame* pRefKF;
-    cv::Mat Pos;
+    Eigen::Vector3f Pos;
     {
         unique_lock<mutex> lock1(mMutexFeatures);
         unique_lock<mutex> lock2(mMutexPos);
@@ -339,25 +361,24 @@ void MapPoint::UpdateNormalAndDepth()
             return;
         observations=mObservations;
         pRefKF=mpRefKF;
-        Pos = mWorldPos.clone();
+        Pos = mWorldPos;
     }
 
     if(observations.empty())
         return;
 
-    cv::Mat normal = cv::Mat::zeros(3,1,CV_32F);
+    Eigen::Vector3f normal = Eigen::Vector3f::Zero();
     int n=0;
     for(map<KeyFrame*,size_t>::iterator mit=observations.begin(), mend=observations.end(); mit!=mend; mit++)
     {
         KeyFrame* pKF = mit->first;
-        cv::Mat Owi = pKF->GetCameraCenter();
-        cv::Mat normali = mWorldPos - Owi;
-        normal = normal + normali/cv::norm(normali);
+        const Eigen::Vector3f normali = Pos - pKF->GetCameraCenterEigen();
+        normal = normal + normali/normali.norm();
         n++;
     }
 
-    cv::Mat PC = Pos - pRefKF->GetCameraCenter();
-    const float dist = cv::norm(PC);
+    const Eigen::Vector3f PC = Pos - pRefKF->GetCameraCenterEigen();
+    const float dist = PC.norm();
     const int level = pRefKF->mvKeysUn[observations[pRefKF]].octave;
     const float levelScaleFactor =  pRefKF->mvScaleFactors[level];
     const int nLevels = pRefKF->mnScaleLevels;
@@ -366,10 +387,21 @@ void MapPoint::UpdateNormalAndDepth()
         unique_lock<mutex> lock3(mMutexPos);
         mfMaxDistance = dist*levelScaleFactor;
         mfMinDistance = mfMaxDistance/pRefKF->mvScaleFactors[nLevels-1];
-        mNormalVector = normal/n;
+        mNormalVector = normal/(float)n;
+        mnPositionVersion++;
     }
 }
 
+int MapPoint::CopyGeometry(Eigen::Vector3f &Pos, Eigen::Vector3f &Normal, float &minDistance, float &maxDistance)
+{
+    unique_lock<mutex> lock(mMutexPos);
+    Pos = mWorldPos;
+    Normal = mNormalVector;
+    minDistance = mfMinDistance;
+    maxDistance = mfMaxDistance;
+    return mnPositionVersion;
+}
+
 float MapPoint::GetMinDistanceInvariance()
 {
     unique_lock<mutex> lock(mMutexPos);
@@ -0,0 +1,131 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MapPointDescriptors.h"
+#include "MapPoint.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+const int DESCRIPTOR_SIZE = 32;
+const int TABLE_ALIGNMENT = 32;
+
+MapPointDescriptors::MapPointDescriptors(): mnCurrent(0), mnCapacity(0), mnRefreshed(0)
+{
+    mpTable[0] = mpTable[1] = static_cast<unsigned char*>(NULL);
+}
+
+void MapPointDescriptors::Reserve(const int n)
+{
+    if(n<=mnCapacity)
+        return;
+
+    // Grow geometrically. The previous table is kept for the rows that are reused.
+    const int capacity = max(n,2*mnCapacity);
+    const int previous = 1-mnCurrent;
+
+    vector<unsigned char> vPrevious(capacity*DESCRIPTOR_SIZE+TABLE_ALIGNMENT);
+    unsigned char* pPrevious = cv::alignPtr(&vPrevious[0],TABLE_ALIGNMENT);
+    if(mpTable[previous])
+        memcpy(pPrevious,mpTable[previous],mvpMapPoints[previous].size()*DESCRIPTOR_SIZE);
+    mvBuffer[previous].swap(vPrevious);
+    mpTable[previous] = pPrevious;
+
+    mvBuffer[mnCurrent].assign(capacity*DESCRIPTOR_SIZE+TABLE_ALIGNMENT,0);
+    mpTable[mnCurrent] = cv::alignPtr(&mvBuffer[mnCurrent][0],TABLE_ALIGNMENT);
+
+    mnCapacity = capacity;
+}
+
+void MapPointDescriptors::Update(const vector<MapPoint*> &vpMapPoints)
+{
+    // The previous table becomes the current one, the current one is reused as previous
+    mnCurrent = 1-mnCurrent;
+    const int previous = 1-mnCurrent;
+
+    const int N = vpMapPoints.size();
+    Reserve(N);
+
+    unsigned char* pTable = mpTable[mnCurrent];
+    const unsigned char* pPreviousTable = mpTable[previous];
+    const vector<MapPoint*> &vpPrevious = mvpMapPoints[previous];
+    const vector<int> &vPreviousVersions = mvVersions[previous];
+
+    vector<MapPoint*> &vpCurrent = mvpMapPoints[mnCurrent];
+    vector<int> &vVersions = mvVersions[mnCurrent];
+    vpCurrent = vpMapPoints;
+    vVersions.resize(N);
+
+    mnRefreshed = 0;
+    for(int i=0; i<N; i++)
+    {
+        MapPoint* pMP = vpMapPoints[i];
+        unsigned char* pRow = pTable+i*DESCRIPTOR_SIZE;
+
+        if(!pMP)
+        {
+            memset(pRow,0,DESCRIPTOR_SIZE);
+            vVersions[i] = -1;
+            continue;
+        }
+
+        // mnTrackDescriptorRow is the row of the point in the previous table, if it was there
+        const int row = pMP->mnTrackDescriptorRow;
+        if(row>=0 && row<(int)vpPrevious.size() && vpPrevious[row]==pMP &&
+           vPreviousVersions[row]>=0 && vPreviousVersions[row]==pMP->GetDescriptorVersion())
+        {
+            memcpy(pRow,pPreviousTable+row*DESCRIPTOR_SIZE,DESCRIPTOR_SIZE);
+            vVersions[i] = vPreviousVersions[row];
+        }
+        else
+        {
+            vVersions[i] = pMP->CopyDescriptor(pRow);
+            if(vVersions[i]<0)
+                memset(pRow,0,DESCRIPTOR_SIZE);
+            mnRefreshed++;
+        }
+    }
+
+    // Row indices are updated once the previous table is not needed anymore (a point could
+    // appear twice in the list)
+    for(int i=0; i<N; i++)
+        if(vpMapPoints[i])
+            vpMapPoints[i]->mnTrackDescriptorRow = i;
+
+    mDescriptors = cv::Mat(N,DESCRIPTOR_SIZE,CV_8U,pTable);
+}
+
+void MapPointDescriptors::Clear()
+{
+    for(int k=0; k<2; k++)
+    {
+        mvpMapPoints[k].clear();
+        mvVersions[k].clear();
+    }
+    mDescriptors = cv::Mat();
+    mnRefreshed = 0;
+}
+
+} //namespace ORB_SLAM
@@ -0,0 +1,199 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "NonMaxSuppression.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+NonMaxSuppression::NonMaxSuppression(int width, int height, int distThresh, int border):
+    mnWidth(width), mnHeight(height), mnDistThresh(distThresh), mnBorder(border),
+    mnMaxFeatures(0), mnBudgetCols(1), mnBudgetRows(1)
+{
+    // Two detections in the same cell are always closer than mnDistThresh
+    mnCellSize = max(mnDistThresh,1);
+    mnCellCols = (mnWidth+mnCellSize-1)/mnCellSize;
+    mnCellRows = (mnHeight+mnCellSize-1)/mnCellSize;
+
+    mvCells.assign(mnCellCols*mnCellRows,-1);
+    mvTouchedCells.reserve(mnCellCols*mnCellRows);
+}
+
+void NonMaxSuppression::Suppress(const float* pDet, const int N, const size_t step, vector<int> &vKept)
+{
+    vKept.clear();
+
+    // Strongest detections first. The index breaks ties so the result does not depend on the sort.
+    mvOrder.resize(N);
+    for(int i=0; i<N; i++)
+        mvOrder[i] = make_pair(-pDet[i*step+2],i);
+    sort(mvOrder.begin(),mvOrder.end());
+
+    const int r = mnDistThresh;
+
+    for(int k=0; k<N; k++)
+    {
+        const int i = mvOrder[k].second;
+        const int u = (int) pDet[i*step];
+        const int v = (int) pDet[i*step+1];
+
+        if(u<0 || u>=mnWidth || v<0 || v>=mnHeight)
+            continue;
+
+        const int cx = u/mnCellSize;
+        const int cy = v/mnCellSize;
+
+        const int minCx = max(cx-1,0);
+        const int maxCx = min(cx+1,mnCellCols-1);
+        const int minCy = max(cy-1,0);
+        const int maxCy = min(cy+1,mnCellRows-1);
+
+        bool bSuppressed = false;
+        for(int iy=minCy; iy<=maxCy && !bSuppressed; iy++)
+        {
+            const int* pRow = &mvCells[iy*mnCellCols];
+            for(int ix=minCx; ix<=maxCx; ix++)
+            {
+                const int j = pRow[ix];
+                if(j<0)
+                    continue;
+
+                const int du = (int) pDet[j*step] - u;
+                const int dv = (int) pDet[j*step+1] - v;
+                if(du<=r && du>=-r && dv<=r && dv>=-r)
+                {
+                    bSuppressed = true;
+                    break;
+                }
+            }
+        }
+
+        if(bSuppressed)
+            continue;
+
+        const int cell = cy*mnCellCols+cx;
+        mvCells[cell] = i;
+        mvTouchedCells.push_back(cell);
+
+        // Detections close to the border suppress others but are not returned
+        if(u<mnBorder || u>=mnWidth-mnBorder || v<mnBorder || v>=mnHeight-mnBorder)
+            continue;
+
+        vKept.push_back(i);
+    }
+
+    for(size_t k=0, kend=mvTouchedCells.size(); k<kend; k++)
+        mvCells[mvTouchedCells[k]] = -1;
+    mvTouchedCells.clear();
+
+    if(mnMaxFeatures>0 && (int)vKept.size()>mnMaxFeatures)
+        DistributeBudget(pDet,step,vKept);
+}
+
+void NonMaxSuppression::SetMaxFeatures(int nMaxFeatures, int nCols, int nRows)
+{
+    mnMaxFeatures = max(nMaxFeatures,0);
+    mnBudgetCols = max(nCols,1);
+    mnBudgetRows = max(nRows,1);
+    mvBudgetCount.resize(mnBudgetCols*mnBudgetRows);
+}
+
+void NonMaxSuppression::DistributeBudget(const float* pDet, const size_t step, vector<int> &vKept)
+{
+    const int N = vKept.size();
+    const int nCells = mnBudgetCols*mnBudgetRows;
+    const int nQuota = mnMaxFeatures/nCells;
+
+    fill(mvBudgetCount.begin(),mvBudgetCount.end(),0);
+    mvbSelected.assign(N,0);
+
+    // vKept is sorted by decreasing confidence, so each cell takes its strongest detections
+    int nSelected = 0;
+    if(nQuota>0)
+    {
+        for(int k=0; k<N && nSelected<mnMaxFeatures; k++)
+        {
+            const int i = vKept[k];
+            const int cx = min(((int) pDet[i*step])*mnBudgetCols/mnWidth,mnBudgetCols-1);
+            const int cy = min(((int) pDet[i*step+1])*mnBudgetRows/mnHeight,mnBudgetRows-1);
+            int &count = mvBudgetCount[cy*mnBudgetCols+cx];
+            if(count<nQuota)
+            {
+                count++;
+                mvbSelected[k] = 1;
+                nSelected++;
+            }
+        }
+    }
+
+    // Cells with few detections leave budget that goes to the strongest remaining ones
+    for(int k=0; k<N && nSelected<mnMaxFeatures; k++)
+    {
+        if(!mvbSelected[k])
+        {
+            mvbSelected[k] = 1;
+            nSelected++;
+        }
+    }
+
+    int j = 0;
+    for(int k=0; k<N; k++)
+        if(mvbSelected[k])
+            vKept[j++] = vKept[k];
+    vKept.resize(j);
+}
+
+void NonMaxSuppression::operator()(const cv::Mat &det, const cv::Mat &desc, vector<cv::KeyPoint> &keypoints,
+                                   cv::OutputArray _descriptors, float ratioWidth, float ratioHeight)
+{
+    keypoints.clear();
+
+    if(det.empty())
+    {
+        _descriptors.release();
+        return;
+    }
+
+    CV_Assert(det.type()==CV_32FC1 && det.cols>=3 && desc.type()==CV_8UC1 && desc.rows==det.rows);
+
+    Suppress(det.ptr<float>(),det.rows,det.step1(),mvKept);
+
+    const int nKept = mvKept.size();
+    const size_t descSize = desc.cols;
+
+    keypoints.reserve(nKept);
+    _descriptors.create(nKept,desc.cols,CV_8U);
+    cv::Mat descriptors = _descriptors.getMat();
+
+    for(int k=0; k<nKept; k++)
+    {
+        const int i = mvKept[k];
+        const float* d = det.ptr<float>(i);
+        keypoints.push_back(cv::KeyPoint((float)((int)d[0])*ratioWidth,(float)((int)d[1])*ratioHeight,1.0f,-1,d[2]));
+        memcpy(descriptors.ptr(k),desc.ptr(i),descSize);
+    }
+}
+
+} //namespace ORB_SLAM
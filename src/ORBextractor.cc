@@ -433,6 +433,11 @@ ORBextractor::ORBextractor(int _nfeatures, float _scaleFactor, int _nlevels,
         mvInvLevelSigma2[i]=1.0f/mvLevelSigma2[i];
     }
 
+    mScaleFactorTable = LevelTable(mvScaleFactor);
+    mInvScaleFactorTable = LevelTable(mvInvScaleFactor);
+    mLevelSigma2Table = LevelTable(mvLevelSigma2);
+    mInvLevelSigma2Table = LevelTable(mvInvLevelSigma2);
+
     mvImagePyramid.resize(nlevels);
 
     mnFeaturesPerLevel.resize(nlevels);
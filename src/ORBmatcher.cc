@@ -19,6 +19,9 @@
 */
 
 #include "ORBmatcher.h"
+#include "HammingDistance.h"
+#include "BinaryMatcher.h"
+#include "Converter.h"
 
 #include<limits.h>
 
@@ -28,6 +31,7 @@
 #include "Thirdparty/DBoW2/DBoW2/FeatureVector.h"
 
 #include<stdint-gcc.h>
+#include<cstring>
 
 #include <opencv2/features2d.hpp>
 
@@ -50,6 +54,9 @@ int ORBmatcher::SearchByProjection(Frame &F, const vector<MapPoint*> &vpMapPoint
 
     const bool bFactor = th!=1.0;
 
+    vector<size_t> vIndices;
+    vIndices.reserve(F.N);
+
     for(size_t iMP=0; iMP<vpMapPoints.size(); iMP++)
     {
         MapPoint* pMP = vpMapPoints[iMP];
@@ -67,8 +74,7 @@ int ORBmatcher::SearchByProjection(Frame &F, const vector<MapPoint*> &vpMapPoint
         if(bFactor)
             r*=th;
 
-        const vector<size_t> vIndices =
-                F.GetFeaturesInArea(pMP->mTrackProjX,pMP->mTrackProjY,r*F.mvScaleFactors[nPredictedLevel],nPredictedLevel-1,nPredictedLevel);
+        F.GetFeaturesInArea(pMP->mTrackProjX,pMP->mTrackProjY,r*F.mvScaleFactors[nPredictedLevel],nPredictedLevel-1,nPredictedLevel,vIndices);
 
         if(vIndices.empty())
             continue;
@@ -106,12 +112,12 @@ int ORBmatcher::SearchByProjection(Frame &F, const vector<MapPoint*> &vpMapPoint
                 bestDist2=bestDist;
                 bestDist=dist;
                 bestLevel2 = bestLevel;
-                bestLevel = F.mvKeysUn[idx].octave;
+                bestLevel = F.mKeysUnArray.Octave(idx);
                 bestIdx=idx;
             }
             else if(dist<bestDist2)
             {
-                bestLevel2 = F.mvKeysUn[idx].octave;
+                bestLevel2 = F.mKeysUnArray.Octave(idx);
                 bestDist2=dist;
             }
         }
@@ -133,6 +139,113 @@ int ORBmatcher::SearchByProjection(Frame &F, const vector<MapPoint*> &vpMapPoint
     return nmatches;
 }
 
+// Candidates from the tracking variables filled by Frame::isInFrustum
+static void GetTrackedInView(const vector<MapPoint*> &vpMapPoints, vector<FrustumCandidate> &vCandidates)
+{
+    vCandidates.clear();
+    for(size_t iMP=0; iMP<vpMapPoints.size(); iMP++)
+    {
+        MapPoint* pMP = vpMapPoints[iMP];
+        if(!pMP || !pMP->mbTrackInView)
+            continue;
+
+        FrustumCandidate candidate;
+        candidate.index = iMP;
+        candidate.u = pMP->mTrackProjX;
+        candidate.v = pMP->mTrackProjY;
+        candidate.ur = pMP->mTrackProjXR;
+        candidate.level = pMP->mnTrackScaleLevel;
+        candidate.viewCos = pMP->mTrackViewCos;
+        vCandidates.push_back(candidate);
+    }
+}
+
+int ORBmatcher::SearchByProjectionAllLevels(Frame &F, const vector<MapPoint*> &vpMapPoints, const cv::Mat &MPdescriptorTable,
+                                            const float th, const bool bRatioTest, const bool bAllLevels)
+{
+    vector<FrustumCandidate> vCandidates;
+    GetTrackedInView(vpMapPoints,vCandidates);
+    return SearchByProjectionAllLevels(F,vpMapPoints,vCandidates,MPdescriptorTable,th,bRatioTest,bAllLevels);
+}
+
+int ORBmatcher::SearchByProjectionAllLevels(Frame &F, const vector<MapPoint*> &vpMapPoints, const vector<FrustumCandidate> &vCandidates,
+                                            const cv::Mat &MPdescriptorTable, const float th, const bool bRatioTest,
+                                            const bool bAllLevels)
+{
+    int nmatches=0;
+
+    vector<size_t> vIndices;
+    vIndices.reserve(F.N);
+
+    for(size_t k=0; k<vCandidates.size(); k++)
+    {
+        const FrustumCandidate &candidate = vCandidates[k];
+        MapPoint* pMP = vpMapPoints[candidate.index];
+
+        if(pMP->isBad())
+            continue;
+
+        // The size of the window will depend on the viewing direction and the predicted scale
+        const int &nPredictedLevel = candidate.level;
+        const float r = RadiusByViewingCos(candidate.viewCos)*th*F.mvScaleFactors[nPredictedLevel];
+
+        if(bAllLevels)
+            F.GetFeaturesInArea(candidate.u,candidate.v,r,-1,-1,vIndices);
+        else
+            F.GetFeaturesInArea(candidate.u,candidate.v,r,nPredictedLevel-1,nPredictedLevel,vIndices);
+
+        if(vIndices.empty())
+            continue;
+
+        const unsigned char* pMPdescriptor = MPdescriptorTable.ptr(candidate.index);
+
+        int bestDist=256;
+        int bestDist2=256;
+        int bestIdx =-1 ;
+
+        // Get best and second matches with near keypoints
+        for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
+        {
+            const size_t idx = *vit;
+
+            if(F.mvpMapPoints[idx])
+                if(F.mvpMapPoints[idx]->Observations()>0)
+                    continue;
+
+            if(F.mvuRight[idx]>0)
+            {
+                const float er = fabs(candidate.ur-F.mvuRight[idx]);
+                if(er>r)
+                    continue;
+            }
+
+            const int dist = HammingDistance::Distance(pMPdescriptor,F.mDescriptors.ptr<unsigned char>(idx));
+
+            if(dist<bestDist)
+            {
+                bestDist2=bestDist;
+                bestDist=dist;
+                bestIdx=idx;
+            }
+            else if(dist<bestDist2)
+            {
+                bestDist2=dist;
+            }
+        }
+
+        if(bestDist<=TH_HIGH)
+        {
+            if(bRatioTest && bestDist>mfNNratio*bestDist2)
+                continue;
+
+            F.mvpMapPoints[bestIdx]=pMP;
+            nmatches++;
+        }
+    }
+
+    return nmatches;
+}
+
 float ORBmatcher::RadiusByViewingCos(const float &viewCos)
 {
     if(viewCos>0.998)
@@ -144,55 +257,61 @@ float ORBmatcher::RadiusByViewingCos(const float &viewCos)
 
 
 
-int ORBmatcher::SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints)
+int ORBmatcher::SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints, const bool bRatioTest)
 {
-    // std::cout << "Matching Localmap" << std::endl;
-    // std::cout << vpMapPoints.size() << std::endl;
-    // std::cout << F.mDescriptors.rows << std::endl;
-
-    std::vector<cv::Mat> MPdescriptorAll;
-    std::vector<int> select_indice;
+    cv::Mat MPdescriptors = cv::Mat::zeros(vpMapPoints.size(), 32, CV_8U);
     for(size_t iMP=0; iMP<vpMapPoints.size(); iMP++)
     {
         MapPoint* pMP = vpMapPoints[iMP];
 
-        if(!pMP)
+        if(!pMP || !pMP->mbTrackInView || pMP->isBad())
             continue;
 
-        if(!pMP->mbTrackInView)
-            continue;
+        pMP->CopyDescriptor(MPdescriptors.ptr(iMP));
+    }
+
+    return SearchByNN(F, vpMapPoints, MPdescriptors, bRatioTest);
+}
+
+int ORBmatcher::SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints, const cv::Mat &MPdescriptorTable, const bool bRatioTest)
+{
+    vector<FrustumCandidate> vCandidates;
+    GetTrackedInView(vpMapPoints,vCandidates);
+    return SearchByNN(F,vpMapPoints,vCandidates,MPdescriptorTable,bRatioTest);
+}
+
+int ORBmatcher::SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints, const vector<FrustumCandidate> &vCandidates,
+                           const cv::Mat &MPdescriptorTable, const bool bRatioTest)
+{
+    // Gather the descriptors of the points in view
+    cv::Mat MPdescriptors(vCandidates.size(), 32, CV_8U);
+    std::vector<int> select_indice;
+    select_indice.reserve(vCandidates.size());
+    for(size_t k=0; k<vCandidates.size(); k++)
+    {
+        const int iMP = vCandidates[k].index;
+        MapPoint* pMP = vpMapPoints[iMP];
 
         if(pMP->isBad())
             continue;
 
-        const cv::Mat MPdescriptor = pMP->GetDescriptor();
-        MPdescriptorAll.push_back(MPdescriptor);
+        memcpy(MPdescriptors.ptr(select_indice.size()), MPdescriptorTable.ptr(iMP), 32);
         select_indice.push_back(iMP);
     }
+    MPdescriptors = MPdescriptors.rowRange(0, select_indice.size());
 
-    cv::Mat MPdescriptors;
-    MPdescriptors.create(MPdescriptorAll.size(), 32, CV_8U);
-
-    for (int i=0; i<static_cast<int>(MPdescriptorAll.size()); i++)
-    {
-        for (int j=0; j<32; j++)
-        {
-            MPdescriptors.at<unsigned char>(i, j) = MPdescriptorAll[i].at<unsigned char>(j);
-        }
-    }
-
-    std::vector<cv::DMatch> matches;
-    cv::BFMatcher desc_matcher(cv::NORM_HAMMING, true);
-    desc_matcher.match(MPdescriptors, F.mDescriptors, matches, cv::Mat());
+    std::vector<int> matches;
+    BinaryMatcher desc_matcher(TH_HIGH, bRatioTest ? mfNNratio : 0.0f);
+    desc_matcher.Match(MPdescriptors, F.mDescriptors, matches);
 
     int nmatches =0;
     for (int i = 0; i < static_cast<int>(matches.size()); ++i) {
-        int realIdxMap = select_indice[matches[i].queryIdx];
-        int bestIdxF  = matches[i].trainIdx;
-        
-        if(matches[i].distance > TH_HIGH)
+        int bestIdxF  = matches[i];
+        if(bestIdxF<0)
             continue;
 
+        int realIdxMap = select_indice[i];
+
         if(F.mvpMapPoints[bestIdxF])
             if(F.mvpMapPoints[bestIdxF]->Observations()>0)
                 continue;
@@ -202,33 +321,25 @@ int ORBmatcher::SearchByNN(Frame &F, const vector<MapPoint*> &vpMapPoints)
         nmatches++;
     }
 
-    // std::cout << MPdescriptors.rows << std::endl;
-    // std::cout << nmatches << std::endl;
-
     return nmatches;
 }
 
 
-int ORBmatcher::SearchByNN(KeyFrame *pKF, Frame &F, std::vector<MapPoint*> &vpMapPointMatches)
+int ORBmatcher::SearchByNN(KeyFrame *pKF, Frame &F, std::vector<MapPoint*> &vpMapPointMatches, const bool bRatioTest)
 {
-
-    // std::cout << "Matching KeyFrame" << std::endl;
-    // std::cout << pKF->mDescriptors.rows << std::endl;
-    // std::cout << F.mDescriptors.rows << std::endl;
-
     const vector<MapPoint*> vpMapPointsKF = pKF->GetMapPointMatches();
     vpMapPointMatches = vector<MapPoint*>(F.N,static_cast<MapPoint*>(NULL));
 
-    std::vector<cv::DMatch> matches;
-    cv::BFMatcher desc_matcher(cv::NORM_HAMMING, true);
-    desc_matcher.match(pKF->mDescriptors, F.mDescriptors, matches, cv::Mat());
+    std::vector<int> matches;
+    BinaryMatcher desc_matcher(TH_HIGH, bRatioTest ? mfNNratio : 0.0f);
+    desc_matcher.Match(pKF->mDescriptors, F.mDescriptors, matches);
 
     int nmatches =0;
     for (int i = 0; i < static_cast<int>(matches.size()); ++i) {
-        int realIdxKF = matches[i].queryIdx;
-        int bestIdxF  = matches[i].trainIdx;
+        int realIdxKF = i;
+        int bestIdxF  = matches[i];
 
-        if(matches[i].distance > TH_HIGH)
+        if(bestIdxF<0)
             continue;
 
         MapPoint* pMP = vpMapPointsKF[realIdxKF];
@@ -242,26 +353,25 @@ int ORBmatcher::SearchByNN(KeyFrame *pKF, Frame &F, std::vector<MapPoint*> &vpMa
         vpMapPointMatches[bestIdxF]=pMP;
         nmatches++;
     }
-    // std::cout << nmatches << std::endl;
 
     return nmatches;
 
 }
 
 
-int ORBmatcher::SearchByNN(Frame &CurrentFrame, const Frame &LastFrame)
+int ORBmatcher::SearchByNN(Frame &CurrentFrame, const Frame &LastFrame, const bool bRatioTest)
 {
 
-    std::vector<cv::DMatch> matches;
-    cv::BFMatcher desc_matcher(cv::NORM_HAMMING, true);
-    desc_matcher.match(LastFrame.mDescriptors, CurrentFrame.mDescriptors, matches, cv::Mat());
+    std::vector<int> matches;
+    BinaryMatcher desc_matcher(TH_LOW, bRatioTest ? mfNNratio : 0.0f);
+    desc_matcher.Match(LastFrame.mDescriptors, CurrentFrame.mDescriptors, matches);
 
     int nmatches =0;
     for (int i = 0; i < static_cast<int>(matches.size()); ++i) {
-        int realIdxKF = matches[i].queryIdx;
-        int bestIdxF  = matches[i].trainIdx;
+        int realIdxKF = i;
+        int bestIdxF  = matches[i];
 
-        if(matches[i].distance > TH_LOW)
+        if(bestIdxF<0)
             continue;
 
         MapPoint* pMP = LastFrame.mvpMapPoints[realIdxKF];
@@ -519,7 +629,7 @@ int ORBmatcher::SearchByProjection(KeyFrame* pKF, cv::Mat Scw, const vector<MapP
             if(vpMatched[idx])
                 continue;
 
-            const int &kpLevel= pKF->mvKeysUn[idx].octave;
+            const int kpLevel= pKF->mKeysUnArray.Octave(idx);
 
             if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                 continue;
@@ -805,13 +915,14 @@ int ORBmatcher::SearchForTriangulation(KeyFrame *pKF1, KeyFrame *pKF2, cv::Mat F
     const DBoW2::FeatureVector &vFeatVec2 = pKF2->mFeatVec;
 
     //Compute epipole in second image
-    cv::Mat Cw = pKF1->GetCameraCenter();
-    cv::Mat R2w = pKF2->GetRotation();
-    cv::Mat t2w = pKF2->GetTranslation();
-    cv::Mat C2 = R2w*Cw+t2w;
-    const float invz = 1.0f/C2.at<float>(2);
-    const float ex =pKF2->fx*C2.at<float>(0)*invz+pKF2->cx;
-    const float ey =pKF2->fy*C2.at<float>(1)*invz+pKF2->cy;
+    const Eigen::Vector3f Cw = pKF1->GetCameraCenterEigen();
+    Eigen::Matrix3f R2w;
+    Eigen::Vector3f t2w;
+    pKF2->GetPoseEigen(R2w,t2w);
+    const Eigen::Vector3f C2 = R2w*Cw+t2w;
+    const float invz = 1.0f/C2(2);
+    const float ex =pKF2->fx*C2(0)*invz+pKF2->cx;
+    const float ey =pKF2->fy*C2(1)*invz+pKF2->cy;
 
     // Find matches between not tracked keypoints
     // Matching speed-up by ORB Vocabulary
@@ -852,8 +963,18 @@ int ORBmatcher::SearchForTriangulation(KeyFrame *pKF1, KeyFrame *pKF2, cv::Mat F
                     if(!bStereo1)
                         continue;
                 
-                const cv::KeyPoint &kp1 = pKF1->mvKeysUn[idx1];
-                
+                const float &x1 = pKF1->mKeysUnArray.X(idx1);
+                const float &y1 = pKF1->mKeysUnArray.Y(idx1);
+
+                // Epipolar line in second image l = x1'F12 = [a b c] (as CheckDistEpipolarLine)
+                const float a = x1*F12.at<float>(0,0)+y1*F12.at<float>(1,0)+F12.at<float>(2,0);
+                const float b = x1*F12.at<float>(0,1)+y1*F12.at<float>(1,1)+F12.at<float>(2,1);
+                const float c = x1*F12.at<float>(0,2)+y1*F12.at<float>(1,2)+F12.at<float>(2,2);
+                const float den = a*a+b*b;
+
+                if(den==0)
+                    continue;
+
                 const cv::Mat &d1 = pKF1->mDescriptors.row(idx1);
                 
                 int bestDist = TH_LOW;
@@ -882,17 +1003,20 @@ int ORBmatcher::SearchForTriangulation(KeyFrame *pKF1, KeyFrame *pKF2, cv::Mat F
                     if(dist>TH_LOW || dist>bestDist)
                         continue;
 
-                    const cv::KeyPoint &kp2 = pKF2->mvKeysUn[idx2];
+                    const float &x2 = pKF2->mKeysUnArray.X(idx2);
+                    const float &y2 = pKF2->mKeysUnArray.Y(idx2);
+                    const int level2 = pKF2->mKeysUnArray.Octave(idx2);
 
                     if(!bStereo1 && !bStereo2)
                     {
-                        const float distex = ex-kp2.pt.x;
-                        const float distey = ey-kp2.pt.y;
-                        if(distex*distex+distey*distey<100*pKF2->mvScaleFactors[kp2.octave])
+                        const float distex = ex-x2;
+                        const float distey = ey-y2;
+                        if(distex*distex+distey*distey<100*pKF2->mvScaleFactors[level2])
                             continue;
                     }
 
-                    if(CheckDistEpipolarLine(kp1,kp2,F12,pKF2))
+                    const float num = a*x2+b*y2+c;
+                    if(num*num/den<3.84*pKF2->mvLevelSigma2[level2])
                     {
                         bestIdx2 = idx2;
                         bestDist = dist;
@@ -901,13 +1025,12 @@ int ORBmatcher::SearchForTriangulation(KeyFrame *pKF1, KeyFrame *pKF2, cv::Mat F
                 
                 if(bestIdx2>=0)
                 {
-                    const cv::KeyPoint &kp2 = pKF2->mvKeysUn[bestIdx2];
                     vMatches12[idx1]=bestIdx2;
                     nmatches++;
 
                     if(mbCheckOrientation)
                     {
-                        float rot = kp1.angle-kp2.angle;
+                        float rot = pKF1->mKeysUnArray.Angle(idx1)-pKF2->mKeysUnArray.Angle(bestIdx2);
                         if(rot<0.0)
                             rot+=360.0f;
                         int bin = round(rot*factor);
@@ -968,8 +1091,9 @@ int ORBmatcher::SearchForTriangulation(KeyFrame *pKF1, KeyFrame *pKF2, cv::Mat F
 
 int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const float th)
 {
-    cv::Mat Rcw = pKF->GetRotation();
-    cv::Mat tcw = pKF->GetTranslation();
+    Eigen::Matrix3f Rcw;
+    Eigen::Vector3f tcw;
+    pKF->GetPoseEigen(Rcw,tcw);
 
     const float &fx = pKF->fx;
     const float &fy = pKF->fy;
@@ -977,12 +1101,15 @@ int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const
     const float &cy = pKF->cy;
     const float &bf = pKF->mbf;
 
-    cv::Mat Ow = pKF->GetCameraCenter();
+    const Eigen::Vector3f Ow = pKF->GetCameraCenterEigen();
 
     int nFused=0;
 
     const int nMPs = vpMapPoints.size();
 
+    vector<size_t> vIndices;
+    vIndices.reserve(pKF->N);
+
     for(int i=0; i<nMPs; i++)
     {
         MapPoint* pMP = vpMapPoints[i];
@@ -993,16 +1120,16 @@ int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const
         if(pMP->isBad() || pMP->IsInKeyFrame(pKF))
             continue;
 
-        cv::Mat p3Dw = pMP->GetWorldPos();
-        cv::Mat p3Dc = Rcw*p3Dw + tcw;
+        const Eigen::Vector3f p3Dw = pMP->GetWorldPosEigen();
+        const Eigen::Vector3f p3Dc = Rcw*p3Dw + tcw;
 
         // Depth must be positive
-        if(p3Dc.at<float>(2)<0.0f)
+        if(p3Dc(2)<0.0f)
             continue;
 
-        const float invz = 1/p3Dc.at<float>(2);
-        const float x = p3Dc.at<float>(0)*invz;
-        const float y = p3Dc.at<float>(1)*invz;
+        const float invz = 1/p3Dc(2);
+        const float x = p3Dc(0)*invz;
+        const float y = p3Dc(1)*invz;
 
         const float u = fx*x+cx;
         const float v = fy*y+cy;
@@ -1015,15 +1142,15 @@ int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const
 
         const float maxDistance = pMP->GetMaxDistanceInvariance();
         const float minDistance = pMP->GetMinDistanceInvariance();
-        cv::Mat PO = p3Dw-Ow;
-        const float dist3D = cv::norm(PO);
+        const Eigen::Vector3f PO = p3Dw-Ow;
+        const float dist3D = PO.norm();
 
         // Depth must be inside the scale pyramid of the image
         if(dist3D<minDistance || dist3D>maxDistance )
             continue;
 
         // Viewing angle must be less than 60 deg
-        cv::Mat Pn = pMP->GetNormal();
+        const Eigen::Vector3f Pn = pMP->GetNormalEigen();
 
         if(PO.dot(Pn)<0.5*dist3D)
             continue;
@@ -1033,7 +1160,7 @@ int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const
         // Search in a radius
         const float radius = th*pKF->mvScaleFactors[nPredictedLevel];
 
-        const vector<size_t> vIndices = pKF->GetFeaturesInArea(u,v,radius);
+        pKF->GetFeaturesInArea(u,v,radius,vIndices);
 
         if(vIndices.empty())
             continue;
@@ -1048,9 +1175,7 @@ int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const
         {
             const size_t idx = *vit;
 
-            const cv::KeyPoint &kp = pKF->mvKeysUn[idx];
-
-            const int &kpLevel= kp.octave;
+            const int kpLevel= pKF->mKeysUnArray.Octave(idx);
 
             if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                 continue;
@@ -1058,8 +1183,8 @@ int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const
             if(pKF->mvuRight[idx]>=0)
             {
                 // Check reprojection error in stereo
-                const float &kpx = kp.pt.x;
-                const float &kpy = kp.pt.y;
+                const float &kpx = pKF->mKeysUnArray.X(idx);
+                const float &kpy = pKF->mKeysUnArray.Y(idx);
                 const float &kpr = pKF->mvuRight[idx];
                 const float ex = u-kpx;
                 const float ey = v-kpy;
@@ -1071,8 +1196,8 @@ int ORBmatcher::Fuse(KeyFrame *pKF, const vector<MapPoint *> &vpMapPoints, const
             }
             else
             {
-                const float &kpx = kp.pt.x;
-                const float &kpy = kp.pt.y;
+                const float &kpx = pKF->mKeysUnArray.X(idx);
+                const float &kpy = pKF->mKeysUnArray.Y(idx);
                 const float ex = u-kpx;
                 const float ey = v-kpy;
                 const float e2 = ex*ex+ey*ey;
@@ -1140,6 +1265,9 @@ int ORBmatcher::Fuse(KeyFrame *pKF, cv::Mat Scw, const vector<MapPoint *> &vpPoi
 
     const int nPoints = vpPoints.size();
 
+    vector<size_t> vIndices;
+    vIndices.reserve(pKF->N);
+
     // For each candidate MapPoint project and match
     for(int iMP=0; iMP<nPoints; iMP++)
     {
@@ -1192,7 +1320,7 @@ int ORBmatcher::Fuse(KeyFrame *pKF, cv::Mat Scw, const vector<MapPoint *> &vpPoi
         // Search in a radius
         const float radius = th*pKF->mvScaleFactors[nPredictedLevel];
 
-        const vector<size_t> vIndices = pKF->GetFeaturesInArea(u,v,radius);
+        pKF->GetFeaturesInArea(u,v,radius,vIndices);
 
         if(vIndices.empty())
             continue;
@@ -1206,7 +1334,7 @@ int ORBmatcher::Fuse(KeyFrame *pKF, cv::Mat Scw, const vector<MapPoint *> &vpPoi
         for(vector<size_t>::const_iterator vit=vIndices.begin(); vit!=vIndices.end(); vit++)
         {
             const size_t idx = *vit;
-            const int &kpLevel = pKF->mvKeysUn[idx].octave;
+            const int kpLevel = pKF->mKeysUnArray.Octave(idx);
 
             if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                 continue;
@@ -1346,9 +1474,9 @@ int ORBmatcher::SearchBySim3(KeyFrame *pKF1, KeyFrame *pKF2, vector<MapPoint*> &
         {
             const size_t idx = *vit;
 
-            const cv::KeyPoint &kp = pKF2->mvKeysUn[idx];
+            const int kpLevel = pKF2->mKeysUnArray.Octave(idx);
 
-            if(kp.octave<nPredictedLevel-1 || kp.octave>nPredictedLevel)
+            if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                 continue;
 
             const cv::Mat &dKF = pKF2->mDescriptors.row(idx);
@@ -1426,9 +1554,9 @@ int ORBmatcher::SearchBySim3(KeyFrame *pKF1, KeyFrame *pKF2, vector<MapPoint*> &
         {
             const size_t idx = *vit;
 
-            const cv::KeyPoint &kp = pKF1->mvKeysUn[idx];
+            const int kpLevel = pKF1->mKeysUnArray.Octave(idx);
 
-            if(kp.octave<nPredictedLevel-1 || kp.octave>nPredictedLevel)
+            if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                 continue;
 
             const cv::Mat &dKF = pKF1->mDescriptors.row(idx);
@@ -1479,18 +1607,21 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, const Frame &LastFrame,
         rotHist[i].reserve(500);
     const float factor = 1.0f/HISTO_LENGTH;
 
-    const cv::Mat Rcw = CurrentFrame.mTcw.rowRange(0,3).colRange(0,3);
-    const cv::Mat tcw = CurrentFrame.mTcw.rowRange(0,3).col(3);
+    const Eigen::Matrix3f &Rcw = CurrentFrame.GetRotationEigen();
+    const Eigen::Vector3f &tcw = CurrentFrame.GetTranslationEigen();
 
-    const cv::Mat twc = -Rcw.t()*tcw;
+    const Eigen::Vector3f &twc = CurrentFrame.GetCameraCenterEigen();
 
-    const cv::Mat Rlw = LastFrame.mTcw.rowRange(0,3).colRange(0,3);
-    const cv::Mat tlw = LastFrame.mTcw.rowRange(0,3).col(3);
+    const Eigen::Matrix3f &Rlw = LastFrame.GetRotationEigen();
+    const Eigen::Vector3f &tlw = LastFrame.GetTranslationEigen();
 
-    const cv::Mat tlc = Rlw*twc+tlw;
+    const Eigen::Vector3f tlc = Rlw*twc+tlw;
 
-    const bool bForward = tlc.at<float>(2)>CurrentFrame.mb && !bMono;
-    const bool bBackward = -tlc.at<float>(2)>CurrentFrame.mb && !bMono;
+    const bool bForward = tlc(2)>CurrentFrame.mb && !bMono;
+    const bool bBackward = -tlc(2)>CurrentFrame.mb && !bMono;
+
+    vector<size_t> vIndices2;
+    vIndices2.reserve(CurrentFrame.N);
 
     for(int i=0; i<LastFrame.N; i++)
     {
@@ -1501,12 +1632,12 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, const Frame &LastFrame,
             if(!LastFrame.mvbOutlier[i])
             {
                 // Project
-                cv::Mat x3Dw = pMP->GetWorldPos();
-                cv::Mat x3Dc = Rcw*x3Dw+tcw;
+                const Eigen::Vector3f x3Dw = pMP->GetWorldPosEigen();
+                const Eigen::Vector3f x3Dc = Rcw*x3Dw+tcw;
 
-                const float xc = x3Dc.at<float>(0);
-                const float yc = x3Dc.at<float>(1);
-                const float invzc = 1.0/x3Dc.at<float>(2);
+                const float xc = x3Dc(0);
+                const float yc = x3Dc(1);
+                const float invzc = 1.0/x3Dc(2);
 
                 if(invzc<0)
                     continue;
@@ -1519,19 +1650,17 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, const Frame &LastFrame,
                 if(v<CurrentFrame.mnMinY || v>CurrentFrame.mnMaxY)
                     continue;
 
-                int nLastOctave = LastFrame.mvKeys[i].octave;
+                int nLastOctave = LastFrame.mKeysUnArray.Octave(i);
 
                 // Search in a window. Size depends on scale
                 float radius = th*CurrentFrame.mvScaleFactors[nLastOctave];
 
-                vector<size_t> vIndices2;
-
                 if(bForward)
-                    vIndices2 = CurrentFrame.GetFeaturesInArea(u,v, radius, nLastOctave);
+                    CurrentFrame.GetFeaturesInArea(u,v, radius, nLastOctave, -1, vIndices2);
                 else if(bBackward)
-                    vIndices2 = CurrentFrame.GetFeaturesInArea(u,v, radius, 0, nLastOctave);
+                    CurrentFrame.GetFeaturesInArea(u,v, radius, 0, nLastOctave, vIndices2);
                 else
-                    vIndices2 = CurrentFrame.GetFeaturesInArea(u,v, radius, nLastOctave-1, nLastOctave+1);
+                    CurrentFrame.GetFeaturesInArea(u,v, radius, nLastOctave-1, nLastOctave+1, vIndices2);
 
                 if(vIndices2.empty())
                     continue;
@@ -1574,7 +1703,7 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, const Frame &LastFrame,
 
                     if(mbCheckOrientation)
                     {
-                        float rot = LastFrame.mvKeysUn[i].angle-CurrentFrame.mvKeysUn[bestIdx2].angle;
+                        float rot = LastFrame.mKeysUnArray.Angle(i)-CurrentFrame.mKeysUnArray.Angle(bestIdx2);
                         if(rot<0.0)
                             rot+=360.0f;
                         int bin = round(rot*factor);
@@ -1617,9 +1746,9 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, KeyFrame *pKF, const set
 {
     int nmatches = 0;
 
-    const cv::Mat Rcw = CurrentFrame.mTcw.rowRange(0,3).colRange(0,3);
-    const cv::Mat tcw = CurrentFrame.mTcw.rowRange(0,3).col(3);
-    const cv::Mat Ow = -Rcw.t()*tcw;
+    const Eigen::Matrix3f &Rcw = CurrentFrame.GetRotationEigen();
+    const Eigen::Vector3f &tcw = CurrentFrame.GetTranslationEigen();
+    const Eigen::Vector3f &Ow = CurrentFrame.GetCameraCenterEigen();
 
     // Rotation Histogram (to check rotation consistency)
     vector<int> rotHist[HISTO_LENGTH];
@@ -1629,6 +1758,9 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, KeyFrame *pKF, const set
 
     const vector<MapPoint*> vpMPs = pKF->GetMapPointMatches();
 
+    vector<size_t> vIndices2;
+    vIndices2.reserve(CurrentFrame.N);
+
     for(size_t i=0, iend=vpMPs.size(); i<iend; i++)
     {
         MapPoint* pMP = vpMPs[i];
@@ -1638,12 +1770,12 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, KeyFrame *pKF, const set
             if(!pMP->isBad() && !sAlreadyFound.count(pMP))
             {
                 //Project
-                cv::Mat x3Dw = pMP->GetWorldPos();
-                cv::Mat x3Dc = Rcw*x3Dw+tcw;
+                const Eigen::Vector3f x3Dw = pMP->GetWorldPosEigen();
+                const Eigen::Vector3f x3Dc = Rcw*x3Dw+tcw;
 
-                const float xc = x3Dc.at<float>(0);
-                const float yc = x3Dc.at<float>(1);
-                const float invzc = 1.0/x3Dc.at<float>(2);
+                const float xc = x3Dc(0);
+                const float yc = x3Dc(1);
+                const float invzc = 1.0/x3Dc(2);
 
                 const float u = CurrentFrame.fx*xc*invzc+CurrentFrame.cx;
                 const float v = CurrentFrame.fy*yc*invzc+CurrentFrame.cy;
@@ -1654,8 +1786,8 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, KeyFrame *pKF, const set
                     continue;
 
                 // Compute predicted scale level
-                cv::Mat PO = x3Dw-Ow;
-                float dist3D = cv::norm(PO);
+                const Eigen::Vector3f PO = x3Dw-Ow;
+                float dist3D = PO.norm();
 
                 const float maxDistance = pMP->GetMaxDistanceInvariance();
                 const float minDistance = pMP->GetMinDistanceInvariance();
@@ -1669,7 +1801,7 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, KeyFrame *pKF, const set
                 // Search in a window
                 const float radius = th*CurrentFrame.mvScaleFactors[nPredictedLevel];
 
-                const vector<size_t> vIndices2 = CurrentFrame.GetFeaturesInArea(u, v, radius, nPredictedLevel-1, nPredictedLevel+1);
+                CurrentFrame.GetFeaturesInArea(u, v, radius, nPredictedLevel-1, nPredictedLevel+1, vIndices2);
 
                 if(vIndices2.empty())
                     continue;
@@ -1703,7 +1835,7 @@ int ORBmatcher::SearchByProjection(Frame &CurrentFrame, KeyFrame *pKF, const set
 
                     if(mbCheckOrientation)
                     {
-                        float rot = pKF->mvKeysUn[i].angle-CurrentFrame.mvKeysUn[bestIdx2].angle;
+                        float rot = pKF->mKeysUnArray.Angle(i)-CurrentFrame.mKeysUnArray.Angle(bestIdx2);
                         if(rot<0.0)
                             rot+=360.0f;
                         int bin = round(rot*factor);
@@ -1790,20 +1922,7 @@ void ORBmatcher::ComputeThreeMaxima(vector<int>* histo, const int L, int &ind1,
 // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
 int ORBmatcher::DescriptorDistance(const cv::Mat &a, const cv::Mat &b)
 {
-    const int *pa = a.ptr<int32_t>();
-    const int *pb = b.ptr<int32_t>();
-
-    int dist=0;
-
-    for(int i=0; i<8; i++, pa++, pb++)
-    {
-        unsigned  int v = *pa ^ *pb;
-        v = v - ((v >> 1) & 0x55555555);
-        v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
-        dist += (((v + (v >> 4)) & 0xF0F0F0F) * 0x1010101) >> 24;
-    }
-
-    return dist;
+    return HammingDistance::Distance(a.ptr<unsigned char>(),b.ptr<unsigned char>());
 }
 
 } //namespace ORB_SLAM
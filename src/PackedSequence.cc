@@ -0,0 +1,214 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PackedSequence.h"
+
+#include <iostream>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+static const char SEQUENCE_SIGNATURE[4] = {'R','G','B','S'};
+static const int32_t SEQUENCE_VERSION = 1;
+
+// Frames start on cache line boundaries
+static const size_t FRAME_ALIGNMENT = 64;
+
+PackedSequence::PackedSequence():
+    mnWidth(0), mnHeight(0), mnFrames(0), mpData(static_cast<unsigned char*>(NULL)), mnSize(0),
+    mpIndex(static_cast<const IndexEntry*>(NULL)), mnOffset(0)
+{
+}
+
+PackedSequence::~PackedSequence()
+{
+    Close();
+}
+
+bool PackedSequence::IsPackedSequence(const string &strFile)
+{
+    ifstream f(strFile.c_str(), ios::in | ios::binary);
+    char signature[4];
+    return f.read(signature,4) && memcmp(signature,SEQUENCE_SIGNATURE,4)==0;
+}
+
+size_t PackedSequence::FrameSize()
+{
+    const size_t size = (size_t)mnWidth*mnHeight*(sizeof(unsigned char)+sizeof(unsigned short));
+    return (size+FRAME_ALIGNMENT-1)/FRAME_ALIGNMENT*FRAME_ALIGNMENT;
+}
+
+bool PackedSequence::Open(const string &strFile)
+{
+    Close();
+
+    const int fd = open(strFile.c_str(), O_RDONLY);
+    if(fd<0)
+    {
+        cerr << "PackedSequence: failed to open " << strFile << endl;
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd,&st)!=0 || (size_t)st.st_size<sizeof(Header))
+    {
+        cerr << "PackedSequence: " << strFile << " is not a packed sequence" << endl;
+        close(fd);
+        return false;
+    }
+
+    // Copy-on-write mapping: the views can be handed to code that takes non-const images
+    void* pMap = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(pMap==MAP_FAILED)
+    {
+        cerr << "PackedSequence: failed to map " << strFile << endl;
+        return false;
+    }
+
+    mpData = static_cast<unsigned char*>(pMap);
+    mnSize = st.st_size;
+
+    Header header;
+    memcpy(&header,mpData,sizeof(header));
+    mnWidth = header.width;
+    mnHeight = header.height;
+
+    bool bValid = memcmp(header.signature,SEQUENCE_SIGNATURE,4)==0 && header.version==SEQUENCE_VERSION &&
+                  header.width>0 && header.height>0 && header.nFrames>=0 &&
+                  header.indexOffset>=(int64_t)sizeof(Header) && header.indexOffset%8==0 &&
+                  (size_t)header.indexOffset+header.nFrames*sizeof(IndexEntry)<=mnSize;
+
+    if(bValid)
+    {
+        mpIndex = reinterpret_cast<const IndexEntry*>(mpData+header.indexOffset);
+        for(int64_t i=0; i<header.nFrames && bValid; i++)
+            bValid = mpIndex[i].offset>=(int64_t)sizeof(Header) && mpIndex[i].offset%FRAME_ALIGNMENT==0 &&
+                     mpIndex[i].offset+(int64_t)FrameSize()<=header.indexOffset;
+    }
+
+    if(!bValid)
+    {
+        cerr << "PackedSequence: " << strFile << " is not a complete packed sequence" << endl;
+        Close();
+        return false;
+    }
+
+    mnFrames = header.nFrames;
+    return true;
+}
+
+bool PackedSequence::Create(const string &strFile, int width, int height)
+{
+    Close();
+
+    mFile.open(strFile.c_str(), ios::out | ios::binary | ios::trunc);
+    if(!mFile.is_open())
+    {
+        cerr << "PackedSequence: failed to create " << strFile << endl;
+        return false;
+    }
+
+    mnWidth = width;
+    mnHeight = height;
+    mnFrames = 0;
+    mvIndex.clear();
+    mvPadding.assign(FRAME_ALIGNMENT,0);
+
+    // The header is written again by Close, once the index offset is known. The first frame
+    // starts on the alignment boundary after it.
+    mFile.write(reinterpret_cast<const char*>(&mvPadding[0]),FRAME_ALIGNMENT);
+    mnOffset = FRAME_ALIGNMENT;
+
+    return mFile.good();
+}
+
+bool PackedSequence::Add(const double &timestamp, const cv::Mat &imGray, const cv::Mat &imDepth)
+{
+    if(!mFile.is_open() || imGray.type()!=CV_8UC1 || imDepth.type()!=CV_16UC1 ||
+       imGray.cols!=mnWidth || imGray.rows!=mnHeight || imDepth.cols!=mnWidth || imDepth.rows!=mnHeight)
+        return false;
+
+    for(int y=0; y<mnHeight; y++)
+        mFile.write(reinterpret_cast<const char*>(imGray.ptr(y)),mnWidth);
+    for(int y=0; y<mnHeight; y++)
+        mFile.write(reinterpret_cast<const char*>(imDepth.ptr(y)),mnWidth*sizeof(unsigned short));
+
+    const size_t size = (size_t)mnWidth*mnHeight*(sizeof(unsigned char)+sizeof(unsigned short));
+    mFile.write(reinterpret_cast<const char*>(&mvPadding[0]),FrameSize()-size);
+
+    IndexEntry entry;
+    entry.timestamp = timestamp;
+    entry.offset = mnOffset;
+    mvIndex.push_back(entry);
+
+    mnOffset += FrameSize();
+    mnFrames++;
+
+    return mFile.good();
+}
+
+void PackedSequence::Close()
+{
+    if(mFile.is_open())
+    {
+        Header header;
+        memcpy(header.signature,SEQUENCE_SIGNATURE,4);
+        header.version = SEQUENCE_VERSION;
+        header.width = mnWidth;
+        header.height = mnHeight;
+        header.nFrames = mvIndex.size();
+        header.indexOffset = mnOffset;
+
+        if(!mvIndex.empty())
+            mFile.write(reinterpret_cast<const char*>(&mvIndex[0]),mvIndex.size()*sizeof(IndexEntry));
+        mFile.seekp(0);
+        mFile.write(reinterpret_cast<const char*>(&header),sizeof(header));
+        mFile.close();
+        mvIndex.clear();
+    }
+
+    if(mpData)
+    {
+        munmap(mpData,mnSize);
+        mpData = static_cast<unsigned char*>(NULL);
+        mpIndex = static_cast<const IndexEntry*>(NULL);
+        mnSize = 0;
+    }
+
+    mnFrames = 0;
+}
+
+void PackedSequence::GetFrame(const int i, cv::Mat &imGray, cv::Mat &imDepth)
+{
+    unsigned char* pFrame = mpData+mpIndex[i].offset;
+    imGray = cv::Mat(mnHeight, mnWidth, CV_8UC1, pFrame);
+    imDepth = cv::Mat(mnHeight, mnWidth, CV_16UC1, pFrame+(size_t)mnWidth*mnHeight);
+}
+
+} //namespace ORB_SLAM
@@ -0,0 +1,324 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Profiler.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+const bool Profiler::mbEnabled = getenv("PROFILE") != nullptr;
+
+namespace
+{
+
+// Log-linear buckets: values below 2^SUB_BUCKET_BITS have their own bucket, larger values
+// keep their SUB_BUCKET_BITS+1 most significant bits.
+const int SUB_BUCKET_BITS = 6;
+const int SUB_BUCKETS = 1<<SUB_BUCKET_BITS;
+const int MAX_BITS = 40;
+const int NUM_BUCKETS = (MAX_BITS-SUB_BUCKET_BITS+1)*SUB_BUCKETS;
+
+const char* STAGE_NAMES[Profiler::NUM_STAGES] =
+{
+    "Frame",
+    "ComputeBoW",
+    "Track",
+    "TrackReferenceKeyFrame",
+    "TrackWithMotionModel",
+    "TrackLocalMap",
+    "Relocalization",
+    "CreateNewKeyFrame",
+    "ProcessNewKeyFrame",
+    "MapPointCulling",
+    "CreateNewMapPoints",
+    "SearchInNeighbors",
+    "LocalBundleAdjustment",
+    "KeyFrameCulling",
+    "DetectLoop",
+    "ComputeSim3",
+    "CorrectLoop",
+    "SearchAndFuse",
+    "GlobalBundleAdjustment"
+};
+
+int BucketIndex(unsigned long long v)
+{
+    if(v < (unsigned long long)SUB_BUCKETS)
+        return v;
+
+    v = min(v,(1ULL<<MAX_BITS)-1);
+    const int e = 63-__builtin_clzll(v);
+    return (e-SUB_BUCKET_BITS+1)*SUB_BUCKETS + (int)(v>>(e-SUB_BUCKET_BITS)) - SUB_BUCKETS;
+}
+
+// Smallest value of a bucket and its width
+void BucketRange(const int idx, unsigned long long &low, unsigned long long &width)
+{
+    const int b = idx>>SUB_BUCKET_BITS;
+    if(b==0)
+    {
+        low = idx;
+        width = 1;
+        return;
+    }
+    low = (unsigned long long)(SUB_BUCKETS + (idx&(SUB_BUCKETS-1))) << (b-1);
+    width = 1ULL << (b-1);
+}
+
+// Only the owner thread writes, so a relaxed load and store is enough (no atomic read-modify-write)
+inline void Add(atomic<unsigned long long> &a, const unsigned long long v)
+{
+    a.store(a.load(memory_order_relaxed)+v,memory_order_relaxed);
+}
+
+struct Histogram
+{
+    Histogram()
+    {
+        for(int i=0; i<NUM_BUCKETS; i++)
+            vBuckets[i].store(0,memory_order_relaxed);
+        nCount.store(0,memory_order_relaxed);
+        nTotal.store(0,memory_order_relaxed);
+        nMin.store(ULLONG_MAX,memory_order_relaxed);
+        nMax.store(0,memory_order_relaxed);
+    }
+
+    atomic<unsigned long long> vBuckets[NUM_BUCKETS];
+    atomic<unsigned long long> nCount;
+    atomic<unsigned long long> nTotal;
+    atomic<unsigned long long> nMin;
+    atomic<unsigned long long> nMax;
+};
+
+struct ThreadData
+{
+    ThreadData()
+    {
+        name.store(static_cast<const char*>(NULL));
+        for(int i=0; i<Profiler::NUM_STAGES; i++)
+            vpHistograms[i].store(static_cast<Histogram*>(NULL));
+    }
+
+    atomic<const char*> name;
+    atomic<Histogram*> vpHistograms[Profiler::NUM_STAGES];
+};
+
+// Thread data is never freed, threads that have finished are still exported
+mutex gMutexThreads;
+vector<ThreadData*> gvpThreads;
+
+thread_local ThreadData* tpThreadData = static_cast<ThreadData*>(NULL);
+
+ThreadData* GetThreadData()
+{
+    if(!tpThreadData)
+    {
+        tpThreadData = new ThreadData();
+        unique_lock<mutex> lock(gMutexThreads);
+        gvpThreads.push_back(tpThreadData);
+    }
+    return tpThreadData;
+}
+
+// Merged histogram of all threads with the same name
+struct Summary
+{
+    Summary(): vBuckets(NUM_BUCKETS,0), nCount(0), nTotal(0), nMin(ULLONG_MAX), nMax(0) {}
+
+    void Merge(const Histogram &h)
+    {
+        for(int i=0; i<NUM_BUCKETS; i++)
+            vBuckets[i] += h.vBuckets[i].load(memory_order_relaxed);
+        nCount += h.nCount.load(memory_order_relaxed);
+        nTotal += h.nTotal.load(memory_order_relaxed);
+        nMin = min(nMin,h.nMin.load(memory_order_relaxed));
+        nMax = max(nMax,h.nMax.load(memory_order_relaxed));
+    }
+
+    // Middle of the bucket holding the q-th quantile, within the measured range
+    double Percentile(const double q) const
+    {
+        const unsigned long long nRank = max(1ULL,(unsigned long long)(q*nCount+0.5));
+        unsigned long long nSeen = 0;
+        for(int i=0; i<NUM_BUCKETS; i++)
+        {
+            nSeen += vBuckets[i];
+            if(nSeen>=nRank)
+            {
+                unsigned long long low, width;
+                BucketRange(i,low,width);
+                const double v = low + 0.5*(width-1);
+                return min(max(v,(double)nMin),(double)nMax);
+            }
+        }
+        return nMax;
+    }
+
+    vector<unsigned long long> vBuckets;
+    unsigned long long nCount;
+    unsigned long long nTotal;
+    unsigned long long nMin;
+    unsigned long long nMax;
+};
+
+const double NS_TO_MS = 1e-6;
+
+} // namespace
+
+void Profiler::SetThreadName(const char* name)
+{
+    Tracer::SetThreadName(name);
+
+    if(!mbEnabled)
+        return;
+
+    GetThreadData()->name.store(name,memory_order_relaxed);
+}
+
+void Profiler::Record(const Stage stage, const long long ns)
+{
+    ThreadData* pThread = GetThreadData();
+
+    Histogram* pHist = pThread->vpHistograms[stage].load(memory_order_relaxed);
+    if(!pHist)
+    {
+        pHist = new Histogram();
+        pThread->vpHistograms[stage].store(pHist,memory_order_release);
+    }
+
+    const unsigned long long v = max(ns,0LL);
+    Add(pHist->vBuckets[BucketIndex(v)],1);
+    Add(pHist->nCount,1);
+    Add(pHist->nTotal,v);
+    if(v<pHist->nMin.load(memory_order_relaxed))
+        pHist->nMin.store(v,memory_order_relaxed);
+    if(v>pHist->nMax.load(memory_order_relaxed))
+        pHist->nMax.store(v,memory_order_relaxed);
+}
+
+const char* Profiler::GetStageName(const Stage stage)
+{
+    return STAGE_NAMES[stage];
+}
+
+void Profiler::Save()
+{
+    if(!mbEnabled)
+        return;
+
+    string strPrefix = getenv("PROFILE");
+    if(strPrefix.empty())
+        strPrefix = "Profile";
+
+    // Merge the threads by name, in the order they first recorded
+    vector<string> vNames;
+    vector<vector<Summary> > vSummaries;
+    {
+        unique_lock<mutex> lock(gMutexThreads);
+        for(size_t t=0; t<gvpThreads.size(); t++)
+        {
+            const char* name = gvpThreads[t]->name.load(memory_order_relaxed);
+            const string strName = name ? name : "unnamed";
+
+            size_t idx = find(vNames.begin(),vNames.end(),strName)-vNames.begin();
+            if(idx==vNames.size())
+            {
+                vNames.push_back(strName);
+                vSummaries.push_back(vector<Summary>(NUM_STAGES));
+            }
+
+            for(int s=0; s<NUM_STAGES; s++)
+            {
+                const Histogram* pHist = gvpThreads[t]->vpHistograms[s].load(memory_order_acquire);
+                if(pHist)
+                    vSummaries[idx][s].Merge(*pHist);
+            }
+        }
+    }
+
+    ofstream fJson((strPrefix+".json").c_str());
+    ofstream fCsv((strPrefix+".csv").c_str());
+    if(!fJson.is_open() || !fCsv.is_open())
+    {
+        cerr << "Failed to write the stage timings to " << strPrefix << ".json/.csv" << endl;
+        return;
+    }
+
+    fCsv << "thread,stage,count,total_ms,mean_ms,min_ms,p50_ms,p90_ms,p99_ms,p999_ms,max_ms" << endl;
+    fJson << "{" << endl << "  \"unit\": \"ms\"," << endl << "  \"threads\": [";
+
+    for(size_t t=0; t<vNames.size(); t++)
+    {
+        fJson << (t>0 ? "," : "") << endl << "    {\"name\": \"" << vNames[t] << "\", \"stages\": [";
+
+        bool bFirst = true;
+        for(int s=0; s<NUM_STAGES; s++)
+        {
+            const Summary &sum = vSummaries[t][s];
+            if(sum.nCount==0)
+                continue;
+
+            const double stats[8] = {sum.nTotal*NS_TO_MS, sum.nTotal*NS_TO_MS/sum.nCount, sum.nMin*NS_TO_MS,
+                                     sum.Percentile(0.5)*NS_TO_MS, sum.Percentile(0.9)*NS_TO_MS, sum.Percentile(0.99)*NS_TO_MS,
+                                     sum.Percentile(0.999)*NS_TO_MS, sum.nMax*NS_TO_MS};
+            const char* keys[8] = {"total", "mean", "min", "p50", "p90", "p99", "p999", "max"};
+
+            fCsv << vNames[t] << "," << STAGE_NAMES[s] << "," << sum.nCount;
+            for(int k=0; k<8; k++)
+                fCsv << "," << stats[k];
+            fCsv << endl;
+
+            fJson << (bFirst ? "" : ",") << endl << "      {\"stage\": \"" << STAGE_NAMES[s] << "\", \"count\": " << sum.nCount;
+            for(int k=0; k<8; k++)
+                fJson << ", \"" << keys[k] << "\": " << stats[k];
+
+            // Non empty buckets as [upper bound, count]
+            fJson << "," << endl << "       \"histogram\": [";
+            bool bFirstBucket = true;
+            for(int i=0; i<NUM_BUCKETS; i++)
+            {
+                if(sum.vBuckets[i]==0)
+                    continue;
+                unsigned long long low, width;
+                BucketRange(i,low,width);
+                fJson << (bFirstBucket ? "" : ", ") << "[" << (low+width)*NS_TO_MS << ", " << sum.vBuckets[i] << "]";
+                bFirstBucket = false;
+            }
+            fJson << "]}";
+            bFirst = false;
+        }
+        fJson << endl << "    ]}";
+    }
+    fJson << endl << "  ]" << endl << "}" << endl;
+
+    cout << "Stage timings saved to " << strPrefix << ".json and " << strPrefix << ".csv" << endl;
+}
+
+} //namespace ORB_SLAM
@@ -0,0 +1,244 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SyntheticScene.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+// Angle in [-pi, pi)
+static float WrapAngle(float a)
+{
+    a = fmod(a+(float)CV_PI,2.0f*(float)CV_PI);
+    if(a<0)
+        a += 2.0f*(float)CV_PI;
+    return a-(float)CV_PI;
+}
+
+// Angle in [0, 2pi)
+static float NormalizeAngle(float a)
+{
+    a = fmod(a,2.0f*(float)CV_PI);
+    if(a<0)
+        a += 2.0f*(float)CV_PI;
+    return a;
+}
+
+SyntheticScene::SyntheticScene(const string &strSettingsFile)
+{
+    cv::FileStorage fSettings(strSettingsFile, cv::FileStorage::READ);
+
+    fx = fSettings["Camera.fx"];
+    fy = fSettings["Camera.fy"];
+    cx = fSettings["Camera.cx"];
+    cy = fSettings["Camera.cy"];
+    mnWidth = fSettings["Camera.width"];
+    mnHeight = fSettings["Camera.height"];
+    mFps = fSettings["Camera.fps"];
+    if(mFps==0)
+        mFps = 30;
+    mnFeatures = fSettings["ORBextractor.nFeatures"];
+
+    mnSeed = fSettings["Synthetic.seed"];
+    mRadius = fSettings["Synthetic.radius"];
+    mWallRadius = mRadius + (float)fSettings["Synthetic.wallDistance"];
+    mWallHeight = fSettings["Synthetic.wallHeight"];
+    mWallDepth = fSettings["Synthetic.wallDepth"];
+    const float density = fSettings["Synthetic.pointDensity"];
+    const int nLaps = fSettings["Synthetic.laps"];
+    mnFramesPerLap = max((int)fSettings["Synthetic.framesPerLap"],1);
+    mnFrames = nLaps*mnFramesPerLap;
+    mBobbing = fSettings["Synthetic.bobbing"];
+    mYaw = fSettings["Synthetic.yaw"];
+    mPixelNoise = fSettings["Synthetic.pixelNoise"];
+    mDepthNoise = fSettings["Synthetic.depthNoise"];
+    mnDescriptorNoise = fSettings["Synthetic.descriptorNoise"];
+
+    const int nPoints = density*2.0f*(float)CV_PI*mWallRadius*mWallHeight;
+
+    // Azimuths are drawn and sorted first, so the points are generated directly in that order
+    cv::RNG rng(mnSeed);
+    mvAzimuth.resize(nPoints);
+    for(int i=0; i<nPoints; i++)
+        mvAzimuth[i] = rng.uniform(0.0f,2.0f*(float)CV_PI);
+    sort(mvAzimuth.begin(),mvAzimuth.end());
+
+    mvPoints.resize(nPoints);
+    mvDescriptors.resize(nPoints*32);
+    for(int i=0; i<nPoints; i++)
+    {
+        const float r = mWallRadius + rng.uniform(-0.5f,0.5f)*mWallDepth;
+        Point &p = mvPoints[i];
+        p.x = r*cos(mvAzimuth[i]);
+        p.y = rng.uniform(-0.5f,0.5f)*mWallHeight;
+        p.z = r*sin(mvAzimuth[i]);
+        p.response = rng.uniform(0.0f,1.0f);
+
+        for(int j=0; j<32; j+=4)
+        {
+            const unsigned int bits = rng.next();
+            memcpy(&mvDescriptors[i*32+j],&bits,4);
+        }
+    }
+}
+
+void SyntheticScene::GetCamera(const int i, cv::Matx33f &Rwc, cv::Vec3f &twc)
+{
+    // Vertical motion and yaw repeat every lap, so later laps revisit the same views
+    const float theta = 2.0f*(float)CV_PI*i/mnFramesPerLap;
+    const float heading = theta + mYaw*sin(3.0f*theta);
+
+    twc = cv::Vec3f(mRadius*cos(theta), mBobbing*sin(5.0f*theta), mRadius*sin(theta));
+
+    // Looking outwards: z towards the wall, y down the cylinder axis and x = y cross z
+    const cv::Vec3f z(cos(heading), 0.0f, sin(heading));
+    const cv::Vec3f y(0.0f, 1.0f, 0.0f);
+    const cv::Vec3f x = y.cross(z);
+    Rwc = cv::Matx33f(x[0], y[0], z[0],
+                      x[1], y[1], z[1],
+                      x[2], y[2], z[2]);
+}
+
+cv::Mat SyntheticScene::GetPose(const int i)
+{
+    cv::Matx33f Rwc;
+    cv::Vec3f twc;
+    GetCamera(i,Rwc,twc);
+
+    cv::Mat Twc = cv::Mat::eye(4,4,CV_32F);
+    cv::Mat(Rwc).copyTo(Twc.rowRange(0,3).colRange(0,3));
+    cv::Mat(twc).copyTo(Twc.rowRange(0,3).col(3));
+    return Twc;
+}
+
+void SyntheticScene::GetFrame(const int i, vector<cv::KeyPoint> &vKeys, cv::Mat &descriptors, vector<float> &vDepth)
+{
+    cv::Matx33f Rwc;
+    cv::Vec3f twc;
+    GetCamera(i,Rwc,twc);
+    const cv::Matx33f Rcw = Rwc.t();
+
+    // Bound on the depth of the points in view: the horizontal distance to the wall along the
+    // corner rays. Seen from inside the cylinder, that distance grows with the angle to the
+    // radial direction, so it is largest on the sides of the frustum.
+    const float outerRadius = mWallRadius + 0.5f*mWallDepth;
+    const float corners[4][2] = {{0,0},{(float)mnWidth,0},{0,(float)mnHeight},{(float)mnWidth,(float)mnHeight}};
+    cv::Vec3f rays[4];
+    float dmax = 0;
+    for(int k=0; k<4; k++)
+    {
+        rays[k] = Rwc*cv::Vec3f((corners[k][0]-cx)/fx, (corners[k][1]-cy)/fy, 1.0f);
+        const float a = rays[k][0]*rays[k][0]+rays[k][2]*rays[k][2];
+        const float b = 2.0f*(twc[0]*rays[k][0]+twc[2]*rays[k][2]);
+        const float c = twc[0]*twc[0]+twc[2]*twc[2]-outerRadius*outerRadius;
+        dmax = max(dmax,(-b+sqrt(b*b-4.0f*a*c))/(2.0f*a)*sqrt(a));
+    }
+
+    // Azimuth range of the view frustum up to that depth. The frustum does not contain the
+    // cylinder axis, so its range is the one of its vertices (camera center and far corners).
+    const float theta = atan2(twc[2],twc[0]);
+    float minAzimuth = 0;
+    float maxAzimuth = 0;
+    for(int k=0; k<4; k++)
+    {
+        const cv::Vec3f p = rays[k]*dmax + twc;
+        const float a = WrapAngle(atan2(p[2],p[0])-theta);
+        minAzimuth = min(minAzimuth,a);
+        maxAzimuth = max(maxAzimuth,a);
+    }
+
+    // Candidate points, in one or two ranges of the sorted azimuths
+    const float a0 = NormalizeAngle(theta+minAzimuth);
+    const float a1 = NormalizeAngle(theta+maxAzimuth);
+    vector<pair<int,int> > vRanges;
+    const int i0 = lower_bound(mvAzimuth.begin(),mvAzimuth.end(),a0)-mvAzimuth.begin();
+    const int i1 = upper_bound(mvAzimuth.begin(),mvAzimuth.end(),a1)-mvAzimuth.begin();
+    if(a0<=a1)
+        vRanges.push_back(make_pair(i0,i1));
+    else
+    {
+        vRanges.push_back(make_pair(i0,(int)mvAzimuth.size()));
+        vRanges.push_back(make_pair(0,i1));
+    }
+
+    // Visible points: (-response, index), and their projection
+    vector<pair<float,int> > vVisible;
+    vector<cv::Vec3f> vProjections;
+    for(size_t r=0; r<vRanges.size(); r++)
+    {
+        for(int j=vRanges[r].first; j<vRanges[r].second; j++)
+        {
+            const Point &P = mvPoints[j];
+            const cv::Vec3f Pc = Rcw*(cv::Vec3f(P.x,P.y,P.z)-twc);
+            if(Pc[2]<=0.1f)
+                continue;
+
+            const float invz = 1.0f/Pc[2];
+            const float u = fx*Pc[0]*invz+cx;
+            const float v = fy*Pc[1]*invz+cy;
+            if(u<0 || u>=mnWidth || v<0 || v>=mnHeight)
+                continue;
+
+            vVisible.push_back(make_pair(-P.response,j));
+            vProjections.push_back(cv::Vec3f(u,v,Pc[2]));
+        }
+    }
+
+    // Strongest responses first, as the keypoints of the extractors
+    vector<int> vOrder(vVisible.size());
+    for(size_t k=0; k<vOrder.size(); k++)
+        vOrder[k] = k;
+    const size_t N = mnFeatures>0 ? min((size_t)mnFeatures,vVisible.size()) : vVisible.size();
+    partial_sort(vOrder.begin(),vOrder.begin()+N,vOrder.end(),[&vVisible](int a, int b) { return vVisible[a]<vVisible[b]; });
+
+    // Sensor noise, the same for every call on this frame
+    cv::RNG rng((uint64)(mnSeed+1)*1000003+i);
+
+    vKeys.resize(N);
+    vDepth.resize(N);
+    descriptors.create(N,32,CV_8U);
+    for(size_t k=0; k<N; k++)
+    {
+        const int j = vVisible[vOrder[k]].second;
+        const cv::Vec3f &proj = vProjections[vOrder[k]];
+
+        const float u = min(max(proj[0]+(float)rng.gaussian(mPixelNoise),0.0f),(float)mnWidth-1);
+        const float v = min(max(proj[1]+(float)rng.gaussian(mPixelNoise),0.0f),(float)mnHeight-1);
+        vKeys[k] = cv::KeyPoint(u,v,1.0f,-1,mvPoints[j].response,0);
+
+        // Depth noise grows with the squared depth, as for structured light sensors
+        vDepth[k] = proj[2]+(float)rng.gaussian(mDepthNoise*proj[2]*proj[2]);
+
+        unsigned char* d = descriptors.ptr(k);
+        memcpy(d,&mvDescriptors[j*32],32);
+        const int nFlips = rng.uniform(0,mnDescriptorNoise+1);
+        for(int f=0; f<nFlips; f++)
+            d[rng.uniform(0,32)] ^= 1 << rng.uniform(0,8);
+    }
+}
+
+} //namespace ORB_SLAM
@@ -22,6 +22,7 @@
 
 #include "System.h"
 #include "Converter.h"
+#include "Profiler.h"
 #include <thread>
 #include <pangolin/pangolin.h>
 #include <iomanip>
@@ -30,7 +31,8 @@ namespace ORB_SLAM2
 {
 
 System::System(const string &strVocFile, const string &strSettingsFile, const eSensor sensor,
-               const bool bUseViewer):mSensor(sensor), mpViewer(static_cast<Viewer*>(NULL)), mbReset(false),mbActivateLocalizationMode(false),
+               const bool bUseViewer, GCNInferenceService* pGCNService):mSensor(sensor), mpViewer(static_cast<Viewer*>(NULL)),
+        mpFeatureExtraction(static_cast<FeatureExtraction*>(NULL)), mpFeatureCache(static_cast<FeatureCache*>(NULL)), mbReset(false),mbActivateLocalizationMode(false),
         mbDeactivateLocalizationMode(false)
 {
     // Output welcome message
@@ -85,7 +87,7 @@ System::System(const string &strVocFile, const string &strSettingsFile, const eS
     //Initialize the Tracking thread
     //(it will live in the main thread of execution, the one that called this constructor)
     mpTracker = new Tracking(this, mpVocabulary, mpFrameDrawer, mpMapDrawer,
-                             mpMap, mpKeyFrameDatabase, strSettingsFile, mSensor);
+                             mpMap, mpKeyFrameDatabase, strSettingsFile, mSensor, pGCNService);
 
     //Initialize the Local Mapping thread and launch
     mpLocalMapper = new LocalMapping(mpMap, mSensor==MONOCULAR);
@@ -103,6 +105,15 @@ System::System(const string &strVocFile, const string &strSettingsFile, const eS
         mpTracker->SetViewer(mpViewer);
     }
 
+    //Initialize the Feature Extraction thread and launch (only if a queue is requested)
+    int nExtractionQueue = fsSettings["Extraction.queueSize"];
+    if(mSensor==RGBD && nExtractionQueue>0)
+    {
+        mpFeatureExtraction = new FeatureExtraction(mpTracker,nExtractionQueue);
+        mptFeatureExtraction = new thread(&ORB_SLAM2::FeatureExtraction::Run, mpFeatureExtraction);
+        mpTracker->SetFeatureExtraction(mpFeatureExtraction);
+    }
+
     //Set pointers between threads
     mpTracker->SetLocalMapper(mpLocalMapper);
     mpTracker->SetLoopClosing(mpLoopCloser);
@@ -216,6 +227,66 @@ cv::Mat System::TrackRGBD(const cv::Mat &im, const cv::Mat &depthmap, const doub
     return Tcw;
 }
 
+cv::Mat System::TrackRGBD(const vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, const vector<float> &vDepth,
+                          const cv::Size &imageSize, const double &timestamp)
+{
+    if(mSensor!=RGBD)
+    {
+        cerr << "ERROR: you called TrackRGBD but input sensor was not set to RGBD." << endl;
+        exit(-1);
+    }
+
+    if(vDepth.size()!=vKeys.size() || descriptors.rows!=(int)vKeys.size() ||
+       (!vKeys.empty() && (descriptors.type()!=CV_8U || descriptors.cols!=32)))
+    {
+        cerr << "ERROR: you called TrackRGBD with " << vKeys.size() << " keypoints, " << vDepth.size()
+             << " depths and " << descriptors.rows << " descriptors (one 32 byte row per keypoint needed)." << endl;
+        exit(-1);
+    }
+
+    // Check mode change
+    {
+        unique_lock<mutex> lock(mMutexMode);
+        if(mbActivateLocalizationMode)
+        {
+            mpLocalMapper->RequestStop();
+
+            // Wait until Local Mapping has effectively stopped
+            while(!mpLocalMapper->isStopped())
+            {
+                usleep(1000);
+            }
+
+            mpTracker->InformOnlyTracking(true);
+            mbActivateLocalizationMode = false;
+        }
+        if(mbDeactivateLocalizationMode)
+        {
+            mpTracker->InformOnlyTracking(false);
+            mpLocalMapper->Release();
+            mbDeactivateLocalizationMode = false;
+        }
+    }
+
+    // Check reset
+    {
+    unique_lock<mutex> lock(mMutexReset);
+    if(mbReset)
+    {
+        mpTracker->Reset();
+        mbReset = false;
+    }
+    }
+
+    cv::Mat Tcw = mpTracker->GrabFeaturesRGBD(vKeys,descriptors,vDepth,imageSize,timestamp);
+
+    unique_lock<mutex> lock2(mMutexState);
+    mTrackingState = mpTracker->mState;
+    mTrackedMapPoints = mpTracker->mCurrentFrame.mvpMapPoints;
+    mTrackedKeyPointsUn = mpTracker->mCurrentFrame.mvKeysUn;
+    return Tcw;
+}
+
 cv::Mat System::TrackMonocular(const cv::Mat &im, const double &timestamp)
 {
     if(mSensor!=MONOCULAR)
@@ -299,8 +370,46 @@ void System::Reset()
     mbReset = true;
 }
 
+bool System::SetFeatureCache(const string &strFile)
+{
+    if(mpFeatureCache)
+        return false;
+
+    mpFeatureCache = new FeatureCache();
+    if(!mpTracker->SetFeatureCache(mpFeatureCache,strFile))
+    {
+        delete mpFeatureCache;
+        mpFeatureCache = static_cast<FeatureCache*>(NULL);
+        return false;
+    }
+
+    return true;
+}
+
 void System::Shutdown()
 {
+    if(mpFeatureExtraction)
+    {
+        // Track the frames that were extracted ahead
+        while(mpFeatureExtraction->FramesPending()>0)
+            mpTracker->TrackExtractedFrame();
+
+        {
+            unique_lock<mutex> lock(mMutexState);
+            mTrackingState = mpTracker->mState;
+            mTrackedMapPoints = mpTracker->mCurrentFrame.mvpMapPoints;
+            mTrackedKeyPointsUn = mpTracker->mCurrentFrame.mvKeysUn;
+        }
+
+        mpFeatureExtraction->RequestFinish();
+        mptFeatureExtraction->join();
+        mpFeatureExtraction->PrintStatistics();
+    }
+
+    // All frames are extracted, the cache can be completed
+    if(mpFeatureCache)
+        mpFeatureCache->Close();
+
     mpLocalMapper->RequestFinish();
     mpLoopCloser->RequestFinish();
     if(mpViewer)
@@ -318,6 +427,11 @@ void System::Shutdown()
 
     if(mpViewer)
         pangolin::BindToContext("ORB-SLAM2: Map Viewer");
+
+    // Stage timings (PROFILE), timeline (TRACE) and lock contention (LOCK_PROFILING)
+    Profiler::Save();
+    Tracer::Save();
+    LockProfiler::PrintReport();
 }
 
 void System::SaveTrajectoryTUM(const string &filename)
@@ -490,4 +604,14 @@ vector<cv::KeyPoint> System::GetTrackedKeyPointsUn()
     return mTrackedKeyPointsUn;
 }
 
+long unsigned int System::KeyFramesInMap()
+{
+    return mpMap->KeyFramesInMap();
+}
+
+long unsigned int System::MapPointsInMap()
+{
+    return mpMap->MapPointsInMap();
+}
+
 } //namespace ORB_SLAM
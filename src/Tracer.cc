@@ -0,0 +1,187 @@
+/**
+* This file is part of ORB-SLAM2.
+*
+* Copyright (C) 2014-2016 Raúl Mur-Artal <raulmur at unizar dot es> (University of Zaragoza)
+* For more information see <https://github.com/raulmur/ORB_SLAM2>
+*
+* ORB-SLAM2 is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM2 is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with ORB-SLAM2. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Tracer.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+using namespace std;
+
+namespace ORB_SLAM2
+{
+
+const bool Tracer::mbEnabled = getenv("TRACE") != nullptr;
+
+namespace
+{
+
+struct Event
+{
+    const char* name;
+    const char* category;
+    char phase;
+    long long ts;
+    long long value;
+};
+
+struct ThreadBuffer
+{
+    ThreadBuffer(): vEvents(Tracer::EVENTS_PER_THREAD), nNext(0)
+    {
+        name.store(static_cast<const char*>(NULL));
+    }
+
+    vector<Event> vEvents;
+    // Events written so far, the last EVENTS_PER_THREAD are kept
+    atomic<unsigned long long> nNext;
+    atomic<const char*> name;
+};
+
+// Buffers are never freed, events of threads that have finished are still written
+mutex gMutexBuffers;
+vector<ThreadBuffer*> gvpBuffers;
+
+thread_local ThreadBuffer* tpBuffer = static_cast<ThreadBuffer*>(NULL);
+
+// Timestamps are relative to the start of the program
+const std::chrono::steady_clock::time_point gStart = std::chrono::steady_clock::now();
+
+ThreadBuffer* GetThreadBuffer()
+{
+    if(!tpBuffer)
+    {
+        tpBuffer = new ThreadBuffer();
+        unique_lock<mutex> lock(gMutexBuffers);
+        gvpBuffers.push_back(tpBuffer);
+    }
+    return tpBuffer;
+}
+
+long long ToNanoseconds(const std::chrono::steady_clock::time_point &t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t - gStart).count();
+}
+
+void AddEvent(const char* name, const char* category, const char phase, const long long ts, const long long value)
+{
+    ThreadBuffer* pBuffer = GetThreadBuffer();
+    const unsigned long long n = pBuffer->nNext.load(memory_order_relaxed);
+    Event &e = pBuffer->vEvents[n%Tracer::EVENTS_PER_THREAD];
+    e.name = name;
+    e.category = category;
+    e.phase = phase;
+    e.ts = ts;
+    e.value = value;
+    pBuffer->nNext.store(n+1,memory_order_release);
+}
+
+} // namespace
+
+void Tracer::SetThreadName(const char* name)
+{
+    if(!mbEnabled)
+        return;
+
+    GetThreadBuffer()->name.store(name,memory_order_relaxed);
+}
+
+void Tracer::Complete(const char* name, const char* category, const std::chrono::steady_clock::time_point &start,
+                      const std::chrono::steady_clock::time_point &end)
+{
+    if(!mbEnabled)
+        return;
+
+    const long long ts = ToNanoseconds(start);
+    AddEvent(name,category,'X',ts,ToNanoseconds(end)-ts);
+}
+
+void Tracer::Counter(const char* name, const long long value)
+{
+    if(!mbEnabled)
+        return;
+
+    AddEvent(name,"queue",'C',ToNanoseconds(std::chrono::steady_clock::now()),value);
+}
+
+void Tracer::Save()
+{
+    if(!mbEnabled)
+        return;
+
+    string strFile = getenv("TRACE");
+    if(strFile.empty())
+        strFile = "Trace.json";
+
+    ofstream f(strFile.c_str());
+    if(!f.is_open())
+    {
+        cerr << "Failed to write the trace to " << strFile << endl;
+        return;
+    }
+
+    unique_lock<mutex> lock(gMutexBuffers);
+
+    size_t nEvents = 0;
+    size_t nDropped = 0;
+    bool bFirst = true;
+    f << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    f << fixed << setprecision(3);
+    for(size_t t=0; t<gvpBuffers.size(); t++)
+    {
+        const ThreadBuffer* pBuffer = gvpBuffers[t];
+        const int tid = t+1;
+        const char* name = pBuffer->name.load(memory_order_relaxed);
+
+        f << (bFirst ? "" : ",") << endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+          << ", \"args\": {\"name\": \"" << (name ? name : "unnamed") << "\"}}";
+        bFirst = false;
+
+        // Oldest kept event first
+        const unsigned long long nWritten = pBuffer->nNext.load(memory_order_acquire);
+        const unsigned long long nFirst = nWritten>(unsigned long long)EVENTS_PER_THREAD ? nWritten-EVENTS_PER_THREAD : 0;
+        nDropped += nFirst;
+
+        for(unsigned long long n=nFirst; n<nWritten; n++)
+        {
+            const Event &e = pBuffer->vEvents[n%EVENTS_PER_THREAD];
+            f << "," << endl << "{\"name\": \"" << e.name << "\", \"cat\": \"" << e.category << "\", \"ph\": \"" << e.phase
+              << "\", \"pid\": 1, \"tid\": " << tid << ", \"ts\": " << e.ts*1e-3;
+            if(e.phase=='X')
+                f << ", \"dur\": " << e.value*1e-3 << "}";
+            else
+                f << ", \"args\": {\"size\": " << e.value << "}}";
+            nEvents++;
+        }
+    }
+    f << endl << "]}" << endl;
+
+    cout << "Trace of " << nEvents << " events saved to " << strFile;
+    if(nDropped>0)
+        cout << " (" << nDropped << " older events dropped)";
+    cout << endl;
+}
+
+} //namespace ORB_SLAM
@@ -27,6 +27,9 @@
 #include"ORBmatcher.h"
 #include"FrameDrawer.h"
 #include"Converter.h"
+#include"ImagePreprocessing.h"
+#include"Profiler.h"
+#include"BinaryMatcher.h"
 #include"Map.h"
 #include"Initializer.h"
 
@@ -34,6 +37,7 @@
 #include"PnPsolver.h"
 
 #include<iostream>
+#include<chrono>
 
 #include<mutex>
 
@@ -43,8 +47,15 @@ using namespace std;
 namespace ORB_SLAM2
 {
 
-Tracking::Tracking(System *pSys, ORBVocabulary* pVoc, FrameDrawer *pFrameDrawer, MapDrawer *pMapDrawer, Map *pMap, KeyFrameDatabase* pKFDB, const string &strSettingPath, const int sensor):
-    mState(NO_IMAGES_YET), mSensor(sensor), mbOnlyTracking(false), mbVO(false), mpORBVocabulary(pVoc),
+// Local map matches by projection below which the search falls back to NN matching
+const int MIN_LOCAL_MAP_MATCHES = 50;
+
+Tracking::Tracking(System *pSys, ORBVocabulary* pVoc, FrameDrawer *pFrameDrawer, MapDrawer *pMapDrawer, Map *pMap, KeyFrameDatabase* pKFDB, const string &strSettingPath, const int sensor,
+                   GCNInferenceService* pGCNService):
+    mState(NO_IMAGES_YET), mSensor(sensor), mbOnlyTracking(false), mbVO(false),
+    mpFeatureExtraction(static_cast<FeatureExtraction*>(NULL)), mpFeatureCache(static_cast<FeatureCache*>(NULL)),
+    mpORBextractorLeft(static_cast<ORBextractor*>(NULL)), mpORBextractorRight(static_cast<ORBextractor*>(NULL)),
+    mpGCNextractor(static_cast<GCNextractor*>(NULL)), mpORBVocabulary(pVoc),
     mpKeyFrameDB(pKFDB), mpInitializer(static_cast<Initializer*>(NULL)), mpSystem(pSys), mpViewer(NULL),
     mpFrameDrawer(pFrameDrawer), mpMapDrawer(pMapDrawer), mpMap(pMap), mnLastRelocFrameId(0)
 {
@@ -119,9 +130,19 @@ Tracking::Tracking(System *pSys, ORBVocabulary* pVoc, FrameDrawer *pFrameDrawer,
     int fIniThFAST = fSettings["ORBextractor.iniThFAST"];
     int fMinThFAST = fSettings["ORBextractor.minThFAST"];
 
+    // GCN inference device ("cpu", "cuda" or empty for automatic) and CPU threads
+    string strGCNDevice = (string)fSettings["GCNextractor.device"];
+    int nGCNThreads = fSettings["GCNextractor.nThreads"];
+
+    // Precision of the native network and input ranges for INT8 (written by gcn_quantize)
+    string strGCNPrecision = (string)fSettings["GCNextractor.precision"];
+    string strGCNCalibration = (string)fSettings["GCNextractor.calibration"];
+
     if (getenv("USE_ORB") == nullptr)
     {
-        mpGCNextractor = new GCNextractor(nFeatures,fScaleFactor,nLevels,fIniThFAST,fMinThFAST);
+        mpGCNextractor = new GCNextractor(nFeatures,fScaleFactor,nLevels,fIniThFAST,fMinThFAST,strGCNDevice,nGCNThreads,pGCNService);
+        if(!mpGCNextractor->SetPrecision(strGCNPrecision,strGCNCalibration))
+            cerr << "Failed to set the GCN precision, running in fp32" << endl;
     }
     else
     {
@@ -135,6 +156,30 @@ Tracking::Tracking(System *pSys, ORBVocabulary* pVoc, FrameDrawer *pFrameDrawer,
     cout << "- Initial Fast Threshold: " << fIniThFAST << endl;
     cout << "- Minimum Fast Threshold: " << fMinThFAST << endl;
 
+    if (getenv("USE_ORB") == nullptr)
+    {
+        cout << endl  << "GCN Extractor Parameters: " << endl;
+        cout << "- Device: " << (mpGCNextractor->IsOnCPU() ? "cpu" : "cuda") << endl;
+        if(mpGCNextractor->IsOnCPU())
+            cout << "- CPU Threads: " << mpGCNextractor->GetThreads() << endl;
+        cout << "- Precision: " << mpGCNextractor->GetPrecision() << endl;
+    }
+
+    // Brute force descriptor matching
+    int nMatcherThreads = fSettings["Matcher.nThreads"];
+    int nNNRatioTest = fSettings["Matcher.ratioTest"];
+    BinaryMatcher::SetDefaultThreads(nMatcherThreads);
+    mLocalMapCuller.SetThreads(nMatcherThreads);
+    mbNNRatioTest = nNNRatioTest!=0;
+
+    int nLocalMapByProjection = fSettings["Matcher.localMapByProjection"];
+    mbLocalMapByProjection = nLocalMapByProjection!=0;
+
+    cout << endl  << "Matcher Parameters: " << endl;
+    cout << "- Threads: " << max(nMatcherThreads,1) << endl;
+    cout << "- Ratio Test: " << (mbNNRatioTest ? "on" : "off") << endl;
+    cout << "- Local Map Search: " << (mbLocalMapByProjection ? "projection" : "NN") << endl;
+
     if(sensor==System::STEREO || sensor==System::RGBD)
     {
         mThDepth = mbf*(float)fSettings["ThDepth"]/fx;
@@ -166,6 +211,44 @@ void Tracking::SetViewer(Viewer *pViewer)
     mpViewer=pViewer;
 }
 
+void Tracking::SetFeatureExtraction(FeatureExtraction *pFeatureExtraction)
+{
+    mpFeatureExtraction=pFeatureExtraction;
+}
+
+bool Tracking::SetFeatureCache(FeatureCache *pFeatureCache, const string &strFile)
+{
+    if(!mpGCNextractor || mSensor!=System::RGBD)
+    {
+        cerr << "The feature cache only holds GCN features of RGB-D frames" << endl;
+        return false;
+    }
+
+    const int width = mpGCNextractor->GetInputWidth();
+    const int height = mpGCNextractor->GetInputHeight();
+    const int nFeatures = mpGCNextractor->GetFeatures();
+
+    if(pFeatureCache->Open(strFile))
+    {
+        if(pFeatureCache->GetWidth()!=width || pFeatureCache->GetHeight()!=height || pFeatureCache->GetFeatures()!=nFeatures)
+        {
+            cerr << "Feature cache " << strFile << " was written with other extraction settings ("
+                 << pFeatureCache->GetWidth() << "x" << pFeatureCache->GetHeight() << ", "
+                 << pFeatureCache->GetFeatures() << " features)" << endl;
+            pFeatureCache->Close();
+            return false;
+        }
+        cout << "Reading GCN features from " << strFile << endl;
+    }
+    else if(pFeatureCache->Create(strFile,width,height,nFeatures))
+        cout << "Writing GCN features to " << strFile << endl;
+    else
+        return false;
+
+    mpFeatureCache = pFeatureCache;
+    return true;
+}
+
 
 cv::Mat Tracking::GrabImageStereo(const cv::Mat &imRectLeft, const cv::Mat &imRectRight, const double &timestamp)
 {
@@ -199,7 +282,10 @@ cv::Mat Tracking::GrabImageStereo(const cv::Mat &imRectLeft, const cv::Mat &imRe
         }
     }
 
-    mCurrentFrame = Frame(mImGray,imGrayRight,timestamp,mpORBextractorLeft,mpORBextractorRight,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+    {
+        Profiler::ScopedTimer timer(Profiler::FRAME);
+        mCurrentFrame = Frame(mImGray,imGrayRight,timestamp,mpORBextractorLeft,mpORBextractorRight,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+    }
 
     Track();
 
@@ -209,48 +295,148 @@ cv::Mat Tracking::GrabImageStereo(const cv::Mat &imRectLeft, const cv::Mat &imRe
 
 cv::Mat Tracking::GrabImageRGBD(const cv::Mat &imRGB, const cv::Mat &imD, const double &timestamp)
 {
-    mImGray = imRGB;
-    cv::Mat imDepth = imD;
+    if(!mpFeatureExtraction)
+    {
+        mCurrentFrame = CreateFrameRGBD(imRGB,imD,timestamp,mImGray);
 
-    if(mImGray.channels()==3)
+        Track();
+
+        return mCurrentFrame.mTcw.clone();
+    }
+
+    // Pipelined extraction: this image is extracted in the FeatureExtraction thread while
+    // we track the oldest extracted frame. The returned pose belongs to that older frame
+    // (empty while the queue is being filled).
+    mpFeatureExtraction->InsertImageRGBD(imRGB,imD,timestamp);
+
+    if(mpFeatureExtraction->FramesPending()<=mpFeatureExtraction->GetQueueSize())
+        return cv::Mat();
+
+    return TrackExtractedFrame();
+}
+
+cv::Mat Tracking::GrabFeaturesRGBD(const vector<cv::KeyPoint> &vKeys, const cv::Mat &descriptors, const vector<float> &vDepth,
+                                   const cv::Size &imageSize, const double &timestamp)
+{
+    if(!mpORBextractorLeft)
     {
-        if(mbRGB)
-            cvtColor(mImGray,mImGray,CV_RGB2GRAY);
-        else
-            cvtColor(mImGray,mImGray,CV_BGR2GRAY);
+        cerr << "Features given directly need the ORB scale information, set USE_ORB" << endl;
+        return cv::Mat();
     }
-    else if(mImGray.channels()==4)
+
+    if(vDepth.size()!=vKeys.size() || descriptors.rows!=(int)vKeys.size())
     {
-        if(mbRGB)
-            cvtColor(mImGray,mImGray,CV_RGBA2GRAY);
-        else
-            cvtColor(mImGray,mImGray,CV_BGRA2GRAY);
+        cerr << "Features given directly need one depth and one descriptor per keypoint" << endl;
+        return cv::Mat();
+    }
+
+    // There is no image, the viewer draws the keypoints on black
+    if(mpViewer)
+        mImGray = cv::Mat::zeros(imageSize,CV_8UC1);
+    else
+        mImGray = cv::Mat();
+
+    {
+        Profiler::ScopedTimer timer(Profiler::FRAME);
+        mCurrentFrame = Frame(vKeys,descriptors,vDepth,imageSize,timestamp,mpORBextractorLeft,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
     }
 
+    Track();
+
+    return mCurrentFrame.mTcw.clone();
+}
+
+cv::Mat Tracking::TrackExtractedFrame()
+{
+    if(!mpFeatureExtraction->GetFrame(mCurrentFrame,mImGray))
+        return cv::Mat();
+
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    Track();
+
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    mpFeatureExtraction->AddTrackingTime(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+
+    return mCurrentFrame.mTcw.clone();
+}
+
+Frame Tracking::CreateFrameRGBD(const cv::Mat &imRGB, const cv::Mat &imD, const double &timestamp, cv::Mat &imGray)
+{
+    Profiler::ScopedTimer timer(Profiler::FRAME);
+
+    const bool bGCN = getenv("USE_ORB") == nullptr;
+
+    // Cached features skip the network and its input preparation
+    vector<cv::KeyPoint> vCachedKeys;
+    cv::Mat cachedDescriptors;
+    const bool bCached = bGCN && mpFeatureCache && mpFeatureCache->Get(timestamp,vCachedKeys,cachedDescriptors);
+
+    cv::Size size = imRGB.size();
     if (getenv("NN_ONLY") != nullptr || getenv("FULL_RESOLUTION") == nullptr)
+        size = cv::Size(320, 240);
+
+    // Fused path: gray conversion, downscale and (GCN) network input normalization in a single
+    // pass over the color image, and depth downscale and conversion in a single pass.
+    imGray = cv::Mat(size,CV_8UC1);
+    cv::Mat imDepth(size,CV_32FC1);
+
+    bool bFusedGray;
+    if(bGCN && !bCached)
+        bFusedGray = mpGCNextractor->Preprocess(imRGB,mbRGB,imGray);
+    else
+        bFusedGray = ImagePreprocessing::ToGray(imRGB,mbRGB,imGray,static_cast<float*>(NULL));
+
+    if(!bFusedGray)
     {
-        cv::resize(mImGray, mImGray, cv::Size(320, 240));
-        cv::resize(imDepth, imDepth, cv::Size(320, 240), 0, 0, cv::INTER_NEAREST);
+        imGray = imRGB;
+
+        if(imGray.channels()==3)
+        {
+            if(mbRGB)
+                cvtColor(imGray,imGray,CV_RGB2GRAY);
+            else
+                cvtColor(imGray,imGray,CV_BGR2GRAY);
+        }
+        else if(imGray.channels()==4)
+        {
+            if(mbRGB)
+                cvtColor(imGray,imGray,CV_RGBA2GRAY);
+            else
+                cvtColor(imGray,imGray,CV_BGRA2GRAY);
+        }
+
+        if(imGray.size()!=size)
+            cv::resize(imGray, imGray, size);
     }
 
-    if((fabs(mDepthMapFactor-1.0f)>1e-5) || imDepth.type()!=CV_32F)
-        imDepth.convertTo(imDepth,CV_32F,mDepthMapFactor);
+    if(!ImagePreprocessing::ToDepth(imD,mDepthMapFactor,imDepth))
+    {
+        imDepth = imD;
+        if(imDepth.size()!=size)
+            cv::resize(imDepth, imDepth, size, 0, 0, cv::INTER_NEAREST);
 
-    if (getenv("USE_ORB") == nullptr)
+        if((fabs(mDepthMapFactor-1.0f)>1e-5) || imDepth.type()!=CV_32F)
+            imDepth.convertTo(imDepth,CV_32F,mDepthMapFactor);
+    }
+
+    if (bCached)
+    {
+        return Frame(imGray,imDepth,timestamp,vCachedKeys,cachedDescriptors,mpGCNextractor,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+    }
+    else if (bGCN)
     {
         // GCN
-        mCurrentFrame = Frame(mImGray,imDepth,timestamp,mpGCNextractor,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
-
+        Frame frame(imGray,imDepth,timestamp,mpGCNextractor,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+        if(mpFeatureCache && mpFeatureCache->IsWriting())
+            mpFeatureCache->Add(timestamp,frame.mvKeys,frame.mDescriptors);
+        return frame;
     }
     else
     {
         // Orb
-        mCurrentFrame = Frame(mImGray,imDepth,timestamp,mpORBextractorLeft,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+        return Frame(imGray,imDepth,timestamp,mpORBextractorLeft,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
     }
-
-    Track();
-
-    return mCurrentFrame.mTcw.clone();
 }
 
 
@@ -273,10 +459,13 @@ cv::Mat Tracking::GrabImageMonocular(const cv::Mat &im, const double &timestamp)
             cvtColor(mImGray,mImGray,CV_BGRA2GRAY);
     }
 
-    if(mState==NOT_INITIALIZED || mState==NO_IMAGES_YET)
-        mCurrentFrame = Frame(mImGray,timestamp,mpIniORBextractor,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
-    else
-        mCurrentFrame = Frame(mImGray,timestamp,mpORBextractorLeft,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+    {
+        Profiler::ScopedTimer timer(Profiler::FRAME);
+        if(mState==NOT_INITIALIZED || mState==NO_IMAGES_YET)
+            mCurrentFrame = Frame(mImGray,timestamp,mpIniORBextractor,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+        else
+            mCurrentFrame = Frame(mImGray,timestamp,mpORBextractorLeft,mpORBVocabulary,mK,mDistCoef,mbf,mThDepth);
+    }
 
     Track();
 
@@ -285,6 +474,9 @@ cv::Mat Tracking::GrabImageMonocular(const cv::Mat &im, const double &timestamp)
 
 void Tracking::Track()
 {
+    Profiler::SetThreadName("Tracking");
+    Profiler::ScopedTimer timer(Profiler::TRACK);
+
     if(mState==NO_IMAGES_YET)
     {
         mState = NOT_INITIALIZED;
@@ -293,7 +485,7 @@ void Tracking::Track()
     mLastProcessedState=mState;
 
     // Get Map Mutex -> Map cannot be changed
-    unique_lock<mutex> lock(mpMap->mMutexMapUpdate);
+    unique_lock<MapUpdateMutex> lock(Tracer::Lock(mpMap->mMutexMapUpdate,"mMutexMapUpdate"));
 
     if(mState==NOT_INITIALIZED)
     {
@@ -526,7 +718,9 @@ void Tracking::Track()
         if(!mCurrentFrame.mpReferenceKF)
             mCurrentFrame.mpReferenceKF = mpReferenceKF;
 
-        mLastFrame = Frame(mCurrentFrame);
+        // Copied into the buffers of the last frame, which keep their capacity between frames.
+        // The cv::Mat headers are shared until the next frame replaces mCurrentFrame.
+        mLastFrame = mCurrentFrame;
     }
 
     // Store frame pose information to retrieve the complete camera trajectory afterwards.
@@ -601,7 +795,7 @@ void Tracking::StereoInitialization()
 
         mpLocalMapper->InsertKeyFrame(pKFini);
 
-        mLastFrame = Frame(mCurrentFrame);
+        mLastFrame = mCurrentFrame;
         mnLastKeyFrameId=mCurrentFrame.mnId;
         mpLastKeyFrame = pKFini;
 
@@ -629,7 +823,7 @@ void Tracking::MonocularInitialization()
         if(mCurrentFrame.mvKeys.size()>100)
         {
             mInitialFrame = Frame(mCurrentFrame);
-            mLastFrame = Frame(mCurrentFrame);
+            mLastFrame = mCurrentFrame;
             mvbPrevMatched.resize(mCurrentFrame.mvKeysUn.size());
             for(size_t i=0; i<mCurrentFrame.mvKeysUn.size(); i++)
                 mvbPrevMatched[i]=mCurrentFrame.mvKeysUn[i].pt;
@@ -785,7 +979,7 @@ void Tracking::CreateInitialMapMonocular()
     mpReferenceKF = pKFcur;
     mCurrentFrame.mpReferenceKF = pKFcur;
 
-    mLastFrame = Frame(mCurrentFrame);
+    mLastFrame = mCurrentFrame;
 
     mpMap->SetReferenceMapPoints(mvpLocalMapPoints);
 
@@ -816,6 +1010,8 @@ void Tracking::CheckReplacedInLastFrame()
 
 bool Tracking::TrackReferenceKeyFrame()
 {
+    Profiler::ScopedTimer timer(Profiler::TRACK_REFERENCE_KEYFRAME);
+
     // Compute Bag of Words vector
     mCurrentFrame.ComputeBoW();
 
@@ -829,7 +1025,7 @@ bool Tracking::TrackReferenceKeyFrame()
     // nmatches = matcher.SearchByBoW(mpReferenceKF,mCurrentFrame,vpMapPointMatches);
 
     // NN only matching
-    nmatches = matcher.SearchByNN(mpReferenceKF,mCurrentFrame,vpMapPointMatches);
+    nmatches = matcher.SearchByNN(mpReferenceKF,mCurrentFrame,vpMapPointMatches,mbNNRatioTest);
 
     if(nmatches<15)
         return false;
@@ -931,6 +1127,8 @@ void Tracking::UpdateLastFrame()
 
 bool Tracking::TrackWithMotionModel()
 {
+    Profiler::ScopedTimer timer(Profiler::TRACK_MOTION_MODEL);
+
     ORBmatcher matcher(0.9,true);
 
     // Update last frame pose according to its reference keyframe
@@ -997,6 +1195,8 @@ bool Tracking::TrackWithMotionModel()
 
 bool Tracking::TrackLocalMap()
 {
+    Profiler::ScopedTimer timer(Profiler::TRACK_LOCAL_MAP);
+
     // We have an estimation of the camera pose and some map points tracked in the frame.
     // We retrieve the local map and try to find matches to points in the local map.
 
@@ -1130,6 +1330,8 @@ bool Tracking::NeedNewKeyFrame()
 
 void Tracking::CreateNewKeyFrame()
 {
+    Profiler::ScopedTimer timer(Profiler::CREATE_NEW_KEYFRAME);
+
     if(!mpLocalMapper->SetNotStop(true))
         return;
 
@@ -1230,39 +1432,78 @@ void Tracking::SearchLocalPoints()
         }
     }
 
-    int nToMatch=0;
-
-    // Project points in frame and check its visibility
+    // Points out of view must not keep the flag of an earlier frame, only candidates set it below
     for(vector<MapPoint*>::iterator vit=mvpLocalMapPoints.begin(), vend=mvpLocalMapPoints.end(); vit!=vend; vit++)
+        (*vit)->mbTrackInView = false;
+
+    // Project points in frame and check its visibility, all at once on a snapshot of the local map
+    // (only new points and points that moved are read from the map)
+    mLocalMapCuller.Update(mvpLocalMapPoints);
+    mLocalMapCuller.Cull(mCurrentFrame,0.5,mvLocalMapCandidates);
+
+    // Points already matched are not searched. The tracking variables are filled for the points in view.
+    int nToMatch=0;
+    for(size_t k=0; k<mvLocalMapCandidates.size(); k++)
     {
-        MapPoint* pMP = *vit;
+        const FrustumCandidate &candidate = mvLocalMapCandidates[k];
+        MapPoint* pMP = mvpLocalMapPoints[candidate.index];
         if(pMP->mnLastFrameSeen == mCurrentFrame.mnId)
             continue;
         if(pMP->isBad())
             continue;
-        // Project (this fills MapPoint variables for matching)
-        if(mCurrentFrame.isInFrustum(pMP,0.5))
-        {
-            pMP->IncreaseVisible();
-            nToMatch++;
-        }
+
+        pMP->mbTrackInView = true;
+        pMP->mTrackProjX = candidate.u;
+        pMP->mTrackProjXR = candidate.ur;
+        pMP->mTrackProjY = candidate.v;
+        pMP->mnTrackScaleLevel = candidate.level;
+        pMP->mTrackViewCos = candidate.viewCos;
+        pMP->IncreaseVisible();
+        mvLocalMapCandidates[nToMatch++] = candidate;
     }
+    mvLocalMapCandidates.resize(nToMatch);
 
     if(nToMatch>0)
     {
         ORBmatcher matcher(0.8);
-        // int th = 1;
-        // if(mSensor==System::RGBD)
-        //     th=3;
-        // // If the camera has been relocalised recently, perform a coarser search
-        // if(mCurrentFrame.mnId<mnLastRelocFrameId+2)
-        //     th=5;
-        
-        // matcher.SearchByProjection(mCurrentFrame,mvpLocalMapPoints,th);
-        
+
+        // Only new points and points whose descriptor changed are read from the map
+        mLocalMapDescriptors.Update(mvpLocalMapPoints);
+        const cv::Mat &LocalMapDescriptors = mLocalMapDescriptors.GetDescriptors();
+
+        if(mbLocalMapByProjection)
+        {
+            int th = 1;
+            if(mSensor==System::RGBD)
+                th=3;
+            // If the camera has been relocalised recently, perform a coarser search
+            if(mCurrentFrame.mnId<mnLastRelocFrameId+2)
+                th=5;
+
+            // GCN keypoints are all at level 0, ORB keypoints are searched around the predicted level
+            const bool bAllLevels = mpGCNextractor!=NULL;
+            const int nMatched = matcher.SearchByProjectionAllLevels(mCurrentFrame,mvpLocalMapPoints,mvLocalMapCandidates,
+                                                                     LocalMapDescriptors,th,mbNNRatioTest,bAllLevels);
+
+            // Only the matches of the local map count, not those of the motion model or reference keyframe
+            if(nMatched>=MIN_LOCAL_MAP_MATCHES)
+                return;
+
+            // Too few matches (bad pose prediction): fall back to NN matching of the points
+            // that were not matched by projection
+            for(int i=0; i<mCurrentFrame.N; i++)
+                if(mCurrentFrame.mvpMapPoints[i])
+                    mCurrentFrame.mvpMapPoints[i]->mbTrackInView = false;
+
+            int nLeft = 0;
+            for(size_t k=0; k<mvLocalMapCandidates.size(); k++)
+                if(mvpLocalMapPoints[mvLocalMapCandidates[k].index]->mbTrackInView)
+                    mvLocalMapCandidates[nLeft++] = mvLocalMapCandidates[k];
+            mvLocalMapCandidates.resize(nLeft);
+        }
+
         // NN only matching
-        matcher.SearchByNN(mCurrentFrame,mvpLocalMapPoints);
-        
+        matcher.SearchByNN(mCurrentFrame,mvpLocalMapPoints,mvLocalMapCandidates,LocalMapDescriptors,mbNNRatioTest);
     }
 }
 
@@ -1414,6 +1655,8 @@ void Tracking::UpdateLocalKeyFrames()
 
 bool Tracking::Relocalization()
 {
+    Profiler::ScopedTimer timer(Profiler::RELOCALIZATION);
+
     // Compute Bag of Words Vector
     mCurrentFrame.ComputeBoW();
 
@@ -1603,6 +1846,16 @@ void Tracking::Reset()
 
     // Clear Map (this erase MapPoints and KeyFrames)
     mpMap->clear();
+    mLocalMapDescriptors.Clear();
+    mLocalMapCuller.Clear();
+
+    // Drop frames extracted ahead, they carry ids of the previous map
+    if(mpFeatureExtraction)
+    {
+        cout << "Reseting Feature Extraction...";
+        mpFeatureExtraction->Clear();
+        cout << " done" << endl;
+    }
 
     KeyFrame::nNextId = 0;
     Frame::nNextId = 0;
@@ -1636,7 +1889,8 @@ void Tracking::ChangeCalibration(const string &strSettingPath)
     K.at<float>(1,1) = fy;
     K.at<float>(0,2) = cx;
     K.at<float>(1,2) = cy;
-    K.copyTo(mK);
+    // New buffers, the frames and keyframes keep sharing the previous calibration
+    mK = K;
 
     cv::Mat DistCoef(4,1,CV_32F);
     DistCoef.at<float>(0) = fSettings["Camera.k1"];
@@ -1649,7 +1903,7 @@ void Tracking::ChangeCalibration(const string &strSettingPath)
         DistCoef.resize(5);
         DistCoef.at<float>(4) = k3;
     }
-    DistCoef.copyTo(mDistCoef);
+    mDistCoef = DistCoef;
 
     mbf = fSettings["Camera.bf"];
 
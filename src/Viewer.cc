@@ -19,6 +19,7 @@
 */
 
 #include "Viewer.h"
+#include "Profiler.h"
 #include <pangolin/pangolin.h>
 
 #include <mutex>
@@ -92,8 +93,12 @@ void Viewer::Run()
     bool bFollow = true;
     bool bLocalizationMode = false;
 
+    Profiler::SetThreadName("Viewer");
+
     while(1)
     {
+        Tracer::ScopedSpan span("Draw","viewer");
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         mpMapDrawer->GetCurrentOpenGLCameraMatrix(Twc);
@@ -155,6 +160,7 @@ void Viewer::Run()
 
         if(Stop())
         {
+            Tracer::ScopedSpan span("Stopped","wait");
             while(isStopped())
             {
                 usleep(3000);